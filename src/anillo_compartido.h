@@ -0,0 +1,227 @@
+/**
+ * @file anillo_compartido.h
+ * @brief Anillo de lecturas en memoria compartida (un escritor, N lectores)
+ *        y biblioteca de consumo para procesos externos.
+ * @details Solo depende de POSIX (shm_open/mmap): otro programa puede
+ *          incluir este encabezado, conectarse con ConsumidorAnillo y leer
+ *          las lecturas que publica el sistema (--publicar /nombre) sin
+ *          enlazar nada más. Enlazar con -lrt en glibc anteriores a 2.34.
+ */
+
+#ifndef ANILLO_COMPARTIDO_H
+#define ANILLO_COMPARTIDO_H
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Pausa de espera activa: cede el núcleo al hermano SMT sin dormir.
+inline void pausaGiro() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+/**
+ * @brief Anillo en memoria compartida (shm_open) con registros seqlock.
+ * @details El escritor nunca espera a los lectores: cada ranura lleva una
+ *          secuencia impar mientras se escribe y 2*pos+2 al terminar; el
+ *          lector valida la secuencia antes y después de copiar y, si el
+ *          escritor le dio la vuelta, salta hacia adelante contando las
+ *          pérdidas. Incluye un directorio handle -> nombre de sensor.
+ */
+class AnilloCompartido {
+public:
+    static const unsigned MAX_NOMBRES = 4096;
+
+    struct Registro {
+        unsigned long long seq;
+        unsigned handle;
+        unsigned reservado;
+        double valor;
+        unsigned long long marcaNs; ///< relojNs() del escritor (CLOCK_MONOTONIC)
+    };
+
+    struct Cabecera {
+        char magia[8];
+        unsigned capacidad;            ///< Potencia de 2
+        unsigned nombres;              ///< Entradas usadas del directorio
+        unsigned long long escritos;   ///< Posición del próximo registro
+        char directorio[MAX_NOMBRES][52];
+    };
+
+protected:
+    unsigned char* base;
+    size_t bytes;
+    Cabecera* cab() const { return (Cabecera*)base; }
+    Registro* registros() const { return (Registro*)(base + sizeof(Cabecera)); }
+
+    bool mapear(int fd, int prot) {
+        void* p = mmap(NULL, bytes, prot, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) return false;
+        base = (unsigned char*)p;
+        return true;
+    }
+
+private:
+    char nombreShm[64];
+
+    AnilloCompartido(const AnilloCompartido&);
+    AnilloCompartido& operator=(const AnilloCompartido&);
+
+public:
+    AnilloCompartido() : base(NULL), bytes(0) { nombreShm[0] = '\0'; }
+    ~AnilloCompartido() { cerrar(); }
+
+    bool abierto() const { return base != NULL; }
+
+    /**
+     * @brief Crea (o recrea) el segmento como escritor.
+     * @param nombre Nombre POSIX, p.ej. "/iot_lecturas"
+     * @param capacidad Registros del anillo (se redondea a potencia de 2)
+     */
+    bool crear(const char* nombre, unsigned capacidad = 1u << 16) {
+        cerrar();
+        unsigned cap = 1;
+        while (cap < capacidad) cap <<= 1;
+        bytes = sizeof(Cabecera) + (size_t)cap * sizeof(Registro);
+        shm_unlink(nombre);
+        int fd = shm_open(nombre, O_CREAT | O_RDWR, 0644);
+        if (fd < 0) return false;
+        if (ftruncate(fd, (off_t)bytes) != 0) { close(fd); return false; }
+        if (!mapear(fd, PROT_READ | PROT_WRITE)) return false;
+        std::strncpy(nombreShm, nombre, sizeof(nombreShm) - 1);
+        nombreShm[sizeof(nombreShm) - 1] = '\0';
+        cab()->capacidad = cap;
+        cab()->nombres = 0;
+        cab()->escritos = 0;
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        std::memcpy(cab()->magia, "IOTRING1", 8); // los lectores esperan la magia
+        return true;
+    }
+
+    void cerrar() {
+        if (base) munmap(base, bytes);
+        if (nombreShm[0]) shm_unlink(nombreShm);
+        base = NULL;
+        nombreShm[0] = '\0';
+    }
+
+    /// Publica el nombre de un handle en el directorio compartido.
+    void nombrar(unsigned handle, const char* nombre) {
+        if (!base || handle >= MAX_NOMBRES) return;
+        std::strncpy(cab()->directorio[handle], nombre, 51);
+        cab()->directorio[handle][51] = '\0';
+        if (handle >= cab()->nombres) __atomic_store_n(&cab()->nombres, handle + 1, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * @brief Publica una lectura. Nunca bloquea: sobrescribe la más vieja.
+     */
+    void publicar(unsigned handle, double valor, unsigned long long marcaNs) {
+        Cabecera* c = cab();
+        unsigned long long pos = c->escritos; // único escritor
+        Registro* r = &registros()[pos & (c->capacidad - 1)];
+        __atomic_store_n(&r->seq, 2 * pos + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        r->handle = handle;
+        r->valor = valor;
+        r->marcaNs = marcaNs;
+        __atomic_store_n(&r->seq, 2 * pos + 2, __ATOMIC_RELEASE);
+        __atomic_store_n(&c->escritos, pos + 1, __ATOMIC_RELEASE);
+    }
+
+    unsigned long long publicados() const { return base ? cab()->escritos : 0; }
+};
+
+/**
+ * @brief Biblioteca de consumo: lector del anillo, solo lectura, sin
+ *        coordinación con el escritor ni con otros lectores.
+ */
+class ConsumidorAnillo : public AnilloCompartido {
+private:
+    unsigned long long siguiente; ///< Próxima posición a leer
+    unsigned long long perdidos;  ///< Registros sobrescritos antes de leerlos
+
+public:
+    ConsumidorAnillo() : siguiente(0), perdidos(0) {}
+    ~ConsumidorAnillo() {
+        if (base) munmap(base, bytes);
+        base = NULL;
+    }
+
+    /**
+     * @brief Se conecta a un anillo existente y empieza por lo más reciente.
+     */
+    bool conectar(const char* nombre) {
+        int fd = shm_open(nombre, O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Cabecera)) { close(fd); return false; }
+        bytes = (size_t)st.st_size;
+        if (!mapear(fd, PROT_READ)) return false;
+        if (std::memcmp(cab()->magia, "IOTRING1", 8) != 0) return false;
+        siguiente = __atomic_load_n(&cab()->escritos, __ATOMIC_ACQUIRE);
+        return true;
+    }
+
+    unsigned long long getPerdidos() const { return perdidos; }
+
+    const char* nombreDe(unsigned handle) const {
+        if (handle >= __atomic_load_n(&cab()->nombres, __ATOMIC_ACQUIRE)) return "?";
+        return cab()->directorio[handle];
+    }
+
+    /**
+     * @brief Lee el próximo registro publicado.
+     * @return false si no hay nada nuevo.
+     */
+    bool leer(Registro& out) {
+        const Cabecera* c = cab();
+        while (true) {
+            unsigned long long escritos = __atomic_load_n(&c->escritos, __ATOMIC_ACQUIRE);
+            if (siguiente >= escritos) return false;
+            if (escritos - siguiente > c->capacidad) {
+                perdidos += escritos - c->capacidad - siguiente;
+                siguiente = escritos - c->capacidad;
+            }
+            const Registro* r = &registros()[siguiente & (c->capacidad - 1)];
+            unsigned long long esperado = 2 * siguiente + 2;
+            unsigned long long s1 = __atomic_load_n(&r->seq, __ATOMIC_ACQUIRE);
+            if (s1 == esperado) {
+                out.handle = r->handle;
+                out.valor = r->valor;
+                out.marcaNs = r->marcaNs;
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&r->seq, __ATOMIC_RELAXED) == s1) {
+                    out.seq = siguiente++;
+                    return true;
+                }
+            } else if (s1 < esperado) {
+                return false; // la ranura aún no terminó de escribirse
+            }
+            perdidos++; // sobrescrito mientras se leía
+            siguiente++;
+        }
+    }
+
+    /**
+     * @brief Espera activa con pausaGiro() hasta leer un registro o agotar
+     *        `giros` sondeos vacíos. Sin llamadas al sistema: la latencia
+     *        medida es la del anillo, a costa de un núcleo ocupado.
+     */
+    bool leerGirando(Registro& out, unsigned long giros) {
+        for (unsigned long i = 0; i < giros; ++i) {
+            if (leer(out)) return true;
+            pausaGiro();
+        }
+        return false;
+    }
+};
+
+#endif // ANILLO_COMPARTIDO_H
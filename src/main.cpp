@@ -7,19 +7,335 @@
  *  - Lista de gestión polimórfica (no genérica) que guarda SensorBase* y libera en cascada.
  *  - Menú de consola para crear sensores, registrar lecturas, y ejecutar procesamiento polimórfico.
  *  - Opcional: ingestión de líneas estilo "ID,valor" para simular Serial/Arduino.
+ *  - Opcional: suavizado por sensor en la ingesta (EWMA, Kalman 1-D, mediana de k),
+ *    con el estado en arreglos por campo (--bench-filtros sensores [lecturas]).
+ *  - Opcional: pronóstico incremental Holt-Winters con bandas de confianza.
+ *  - Opcional: alertas de sensores silenciosos con una rueda jerárquica de temporizadores.
+ *  - Opcional: procesamiento planificado por sensor (periodo o cada N lecturas).
+ *  - Calidad de datos en la ingesta: valores pegados, huecos y picos por lectura.
+ *  - Opcional: presupuesto de memoria con desborde a disco de historiales fríos.
+ *  - Opcional (--persistente archivo): copia durable de cada lectura en un archivo mapeado;
+ *    al reiniciar los sensores vuelven sin leer el archivo y cada historial se arma al usarlo.
+ *  - Instantáneas en segundo plano con fork() (--restaurar archivo para cargarlas).
+ *  - Checkpoints incrementales de sensores modificados (--checkpoint ruta).
+ *  - Publicación en anillo de memoria compartida (--publicar /nombre) y modo
+ *    consumidor en espera activa (--suscriptor /nombre [segundos]
+ *    [silencioso] [girar|dormir]); el anillo y su lector viven en
+ *    anillo_compartido.h para que otros procesos lo incluyan.
+ *  - Replicación por envío de registros a un standby local (--replicar ruta /
+ *    --standby ruta) con conmutación al perder el primario; cada cambio se
+ *    confirma con el standby antes de informarlo (--prueba-failover [N]).
+ *  - Modo cluster (--cluster N): router con hash consistente hacia procesos
+ *    trabajadores, consultas combinadas (también de bocetos por grupo) y rebalanceo
+ *    al agregar trabajadores.
+ *  - Cada lectura lleva su hora de llegada; exportación de historiales en
+ *    formato de archivo Arrow IPC escrito a mano.
+ *  - Arena de nodos con páginas grandes y nodo NUMA preferido
+ *    (--arena hugetlb|thp|normal, --bench-arena N [sensores]).
+ *  - Ingesta busy-poll con CPU fija y memoria bloqueada, comparada con la
+ *    bloqueante (--bench-ingesta N [cpu]).
+ *  - Trazas por etapa con reloj TSC y exportación Chrome trace (--trazas f.json).
+ *  - Compresión del historial con error acotado (banda muerta / puerta
+ *    giratoria) y banco comparativo (--bench-compresion N [E]).
+ *  - Tramo frío de las temperaturas en float16 o 16/8 bits escalados, con
+ *    suma vía F16C (--bench-cuantizado N).
+ *  - Rankings top-K incrementales por último valor, promedio o máximo
+ *    (--bench-topk sensores [lecturas] [K]).
+ *  - Bocetos HyperLogLog + count-min por sensor, combinables por grupo
+ *    (--bench-bocetos [max]).
+ *  - Líneas "ID,valor,secuencia": retransmisiones descartadas con una
+ *    ventana de bits por sensor, con contadores de duplicados y huecos.
+ *  - Join as-of / más cercano entre dos historiales y remuestreo lineal en
+ *    grilla regular, con correlación y exportación CSV; autoverificación
+ *    de bordes y banco (--bench-alineacion [lecturas]).
+ *  - Mezcla k-vías (árbol de perdedores) de todos los historiales en un
+ *    flujo ordenado por tiempo, por tramos en paralelo
+ *    (--bench-mezcla sensores [lecturas] [tramos]).
+ *  - Resumen visual de historiales grandes con LTTB (print_summary, CSV).
+ *  - Banco comparativo de la lista enlazada contra backends de referencia
+ *    contiguo, deque y por trozos (--bench-backends [max] [archivo.csv]).
  *
  * @author
  *   Equipo IC – ITIID
  */
 
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <new>
+#include <cerrno>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <sys/ioctl.h>
+#include <sched.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "anillo_compartido.h"
+
+/* ============================================================
+ *        Arena de nodos con páginas grandes y afinidad NUMA
+ * ============================================================*/
+
+/**
+ * @brief Asignador de nodos de ListaSensor en bloques de 2 MB dentro de una
+ *        única reserva de direcciones (pertenencia en O(1)).
+ * @details Cada bloque intenta, en orden: páginas grandes explícitas
+ *          (MAP_HUGETLB), páginas grandes transparentes (madvise) y páginas
+ *          normales. Antes del primer acceso se prefiere el nodo NUMA de la
+ *          CPU que crea el bloque (mbind). Sin soporte, degrada en silencio y
+ *          lo informa en el reporte. Los nodos liberados vuelven a una lista
+ *          libre por tamaño; los bloques no se devuelven al sistema.
+ */
+class ArenaNodos {
+public:
+    enum Modo { MODO_NORMAL = 0, MODO_THP = 1, MODO_HUGETLB = 2 };
+
+    static const size_t BLOQUE = 2u << 20;
+    static const size_t RESERVA = 64ull << 30; ///< Espacio de direcciones, no memoria
+    static const int CLASES = 16;               ///< Tamaños de 8 a 128 bytes
+
+private:
+    unsigned char* base;
+    size_t comprometido;
+    unsigned char* cursor;
+    unsigned char* limite;
+    void* libres[CLASES];
+    Modo preferido;
+    size_t bloques[3];          ///< Bloques obtenidos por modo
+    int nodoNuma;
+    size_t bloquesLigados;      ///< Bloques con mbind exitoso
+    size_t vivos;
+
+    ArenaNodos(const ArenaNodos&);
+    ArenaNodos& operator=(const ArenaNodos&);
+
+    ArenaNodos()
+        : base(NULL), comprometido(0), cursor(NULL), limite(NULL), preferido(MODO_NORMAL),
+          nodoNuma(-1), bloquesLigados(0), vivos(0) {
+        std::memset(libres, 0, sizeof(libres));
+        bloques[0] = bloques[1] = bloques[2] = 0;
+    }
+
+    static const char* nombreModo(int m) {
+        return m == MODO_HUGETLB ? "hugetlb 2MB" : m == MODO_THP ? "THP (madvise)" : "paginas de 4KB";
+    }
+
+    bool nuevoBloque() {
+        if (comprometido + BLOQUE > RESERVA) return false;
+        unsigned char* p = base + comprometido;
+        int modo = MODO_NORMAL;
+        void* r = MAP_FAILED;
+        if (preferido >= MODO_HUGETLB) {
+            r = mmap(p, BLOQUE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB, -1, 0);
+            if (r != MAP_FAILED) modo = MODO_HUGETLB;
+        }
+        if (r == MAP_FAILED) {
+            r = mmap(p, BLOQUE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+            if (r == MAP_FAILED) return false;
+            if (preferido >= MODO_THP && madvise(p, BLOQUE, MADV_HUGEPAGE) == 0) modo = MODO_THP;
+        }
+        if (nodoNuma >= 0) {
+            unsigned long mascara = 1ul << nodoNuma;
+            const int MPOL_PREFERIDO = 1; // MPOL_PREFERRED
+            if (syscall(SYS_mbind, p, BLOQUE, MPOL_PREFERIDO, &mascara, sizeof(mascara) * 8, 0) == 0)
+                bloquesLigados++;
+        }
+        bloques[modo]++;
+        comprometido += BLOQUE;
+        cursor = p;
+        limite = p + BLOQUE;
+        return true;
+    }
+
+public:
+    static ArenaNodos& global() {
+        static ArenaNodos a;
+        return a;
+    }
+
+    bool activa() const { return base != NULL; }
+
+    /**
+     * @brief Reserva el espacio de direcciones y fija el modo preferido.
+     *        Los nodos creados antes siguen en el heap y se liberan ahí.
+     */
+    bool activar(Modo modo) {
+        if (base) return true;
+        void* r = mmap(NULL, RESERVA + BLOQUE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (r == MAP_FAILED) return false;
+        size_t dir = ((size_t)r + BLOQUE - 1) & ~(BLOQUE - 1); // bloques alineados a 2 MB
+        base = (unsigned char*)dir;
+        preferido = modo;
+        unsigned cpu = 0, nodo = 0;
+        if (syscall(SYS_getcpu, &cpu, &nodo, NULL) == 0) nodoNuma = (int)nodo;
+        return true;
+    }
+
+    bool contiene(const void* p) const {
+        return base && (const unsigned char*)p >= base && (const unsigned char*)p < base + comprometido;
+    }
+
+    void* reservar(size_t bytes) {
+        int c = (int)((bytes + 7) / 8) - 1;
+        if (c >= CLASES) return ::operator new(bytes);
+        vivos++;
+        if (libres[c]) {
+            void* p = libres[c];
+            libres[c] = *(void**)p;
+            return p;
+        }
+        size_t tam = (size_t)(c + 1) * 8;
+        if (cursor + tam > limite && !nuevoBloque()) {
+            vivos--;
+            return ::operator new(bytes); // reserva agotada: heap
+        }
+        void* p = cursor;
+        cursor += tam;
+        return p;
+    }
+
+    /**
+     * @brief Deja `cuantos` nodos de `bytes` ya tocados en la lista libre,
+     *        para que la ruta caliente no pida bloques ni cause fallos de página.
+     */
+    size_t precalentar(size_t bytes, size_t cuantos) {
+        int c = (int)((bytes + 7) / 8) - 1;
+        if (!base || c >= CLASES) return 0;
+        size_t tam = (size_t)(c + 1) * 8, hechos = 0;
+        for (; hechos < cuantos; ++hechos) {
+            if (cursor + tam > limite && !nuevoBloque()) break;
+            void* p = cursor;
+            cursor += tam;
+            *(void**)p = libres[c];
+            libres[c] = p;
+        }
+        return hechos;
+    }
+
+    size_t bloquesComprometidos() const { return comprometido / BLOQUE; }
+
+    void liberar(void* p, size_t bytes) {
+        int c = (int)((bytes + 7) / 8) - 1;
+        *(void**)p = libres[c];
+        libres[c] = p;
+        vivos--;
+    }
+
+    /**
+     * @brief Memoria anónima respaldada por páginas grandes en el proceso
+     *        (AnonHugePages de /proc/self/smaps_rollup), en kB; -1 si no se sabe.
+     */
+    static long paginasGrandesKb() {
+        FILE* f = std::fopen("/proc/self/smaps_rollup", "r");
+        if (!f) return -1;
+        char linea[256];
+        long kb = -1;
+        while (std::fgets(linea, sizeof(linea), f)) {
+            if (std::sscanf(linea, "AnonHugePages: %ld kB", &kb) == 1) break;
+        }
+        std::fclose(f);
+        return kb;
+    }
+
+    void imprimirReporte() const {
+        printf("\n--- Arena de nodos ---\n");
+        if (!base) {
+            printf("  Inactiva: los nodos usan el heap (new/delete).\n");
+            return;
+        }
+        printf("  Modo preferido: %s\n", nombreModo(preferido));
+        printf("  Bloques de 2MB: %zu hugetlb, %zu THP, %zu normales (%zu MB comprometidos)\n",
+               bloques[MODO_HUGETLB], bloques[MODO_THP], bloques[MODO_NORMAL], comprometido >> 20);
+        if (nodoNuma >= 0)
+            printf("  NUMA: nodo %d preferido, %zu de %zu bloques ligados\n", nodoNuma, bloquesLigados,
+                   bloques[0] + bloques[1] + bloques[2]);
+        else
+            printf("  NUMA: sin informacion de nodo (sin ligar)\n");
+        long kb = paginasGrandesKb();
+        if (kb >= 0) printf("  AnonHugePages del proceso: %ld kB\n", kb);
+        printf("  Nodos vivos en la arena: %zu\n", vivos);
+    }
+};
+
+/**
+ * @brief Contador de fallos de DTLB (lecturas) del propio proceso vía
+ *        perf_event_open; `disponible()` es false si el kernel no lo permite.
+ */
+class ContadorTlb {
+private:
+    int fd;
+
+    ContadorTlb(const ContadorTlb&);
+    ContadorTlb& operator=(const ContadorTlb&);
+
+public:
+    ContadorTlb() : fd(-1) {
+        perf_event_attr a;
+        std::memset(&a, 0, sizeof(a));
+        a.size = sizeof(a);
+        a.type = PERF_TYPE_HW_CACHE;
+        a.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        a.disabled = 1;
+        a.exclude_kernel = 1;
+        a.exclude_hv = 1;
+        fd = (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+    }
+    ~ContadorTlb() { if (fd >= 0) close(fd); }
+
+    bool disponible() const { return fd >= 0; }
+
+    void iniciar() {
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    long long detener() {
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long v = 0;
+        return read(fd, &v, sizeof(v)) == (ssize_t)sizeof(v) ? v : -1;
+    }
+};
+
+/**
+ * @brief Mensajes de log por lectura ("[Log] Insertando..."). Los modos de
+ *        baja latencia y los bancos los apagan para no medir printf.
+ */
+inline bool& registroDetallado() {
+    static bool activo = true;
+    return activo;
+}
 
 /* ============================================================
  *           Lista enlazada genérica (sin STL)
  * ============================================================*/
 
+/**
+ * @brief Bytes de nodos vivos en todas las ListaSensor<T> del proceso.
+ *        Es la medida sobre la que se aplica el presupuesto de memoria.
+ */
+inline size_t& bytesNodosResidentes() {
+    static size_t bytes = 0;
+    return bytes;
+}
+
 /**
  * @brief Lista enlazada simple genérica sin STL.
  * @tparam T Tipo de dato almacenado (int, float, double, etc.)
@@ -35,6 +351,8 @@
  *  - sum (para métricas sencillas)
  *  - pop_min (elimina el mínimo, útil p/temperatura)
  *  - find_first (búsqueda simple por igualdad)
+ *  - contarConBandera (banderas de calidad por lectura)
+ *  - volcar/restaurar (desborde a disco)
  *  - clear
  */
 template <typename T>
@@ -42,8 +360,21 @@ class ListaSensor {
 public:
     struct Nodo {
         T dato;
+        unsigned char banderas; ///< Calidad de la lectura; ocupa relleno junto a T
         Nodo* siguiente;
-        Nodo(const T& v) : dato(v), siguiente(NULL) {}
+        long long marcaMs;      ///< Hora de llegada (ms desde epoch UTC; 0 = sin marca)
+        Nodo(const T& v, unsigned char b = 0, long long m = 0)
+            : dato(v), banderas(b), siguiente(NULL), marcaMs(m) {}
+
+        static void* operator new(size_t bytes) {
+            ArenaNodos& a = ArenaNodos::global();
+            return a.activa() ? a.reservar(bytes) : ::operator new(bytes);
+        }
+        static void operator delete(void* p, size_t bytes) {
+            ArenaNodos& a = ArenaNodos::global();
+            if (a.contiene(p)) a.liberar(p, bytes);
+            else ::operator delete(p);
+        }
     };
 
 private:
@@ -54,7 +385,7 @@ private:
     void copiarDesde(const ListaSensor& other) {
         Nodo* it = other.cabeza;
         while (it) {
-            push_back(it->dato);
+            push_back(it->dato, it->banderas, it->marcaMs);
             it = it->siguiente;
         }
     }
@@ -80,8 +411,9 @@ public:
         clear();
     }
 
-    void push_back(const T& v) {
-        Nodo* nuevo = new Nodo(v);
+    void push_back(const T& v, unsigned char banderas = 0, long long marcaMs = 0) {
+        Nodo* nuevo = new Nodo(v, banderas, marcaMs);
+        bytesNodosResidentes() += sizeof(Nodo);
         if (!cabeza) {
             cabeza = cola = nuevo;
         } else {
@@ -93,6 +425,15 @@ public:
 
     size_t size() const { return n; }
 
+    /**
+     * @brief Último valor insertado. Devuelve false si la lista está vacía.
+     */
+    bool back(T& out) const {
+        if (!cola) return false;
+        out = cola->dato;
+        return true;
+    }
+
     /**
      * @brief Suma de elementos (solo para tipos numéricos).
      * @return Suma de todos los valores (0 si lista vacía).
@@ -108,6 +449,18 @@ public:
         return s;
     }
 
+    /**
+     * @brief Valor mínimo sin eliminarlo. Devuelve false si la lista está vacía.
+     */
+    bool minimo(T& out) const {
+        if (!cabeza) return false;
+        out = cabeza->dato;
+        for (Nodo* it = cabeza->siguiente; it; it = it->siguiente) {
+            if (it->dato < out) out = it->dato;
+        }
+        return true;
+    }
+
     /**
      * @brief Elimina el valor mínimo. Devuelve true si eliminó alguno.
      */
@@ -139,9 +492,10 @@ public:
         }
 
         // Log de liberación
-        printf("    [Log] Nodo liberado con valor: %s\n",
-               formatNumber(outMin));
+        if (registroDetallado())
+            printf("    [Log] Nodo liberado con valor: %s\n", formatNumber(outMin));
         delete minNode;
+        bytesNodosResidentes() -= sizeof(Nodo);
         n--;
         return true;
     }
@@ -161,6 +515,17 @@ public:
         return false;
     }
 
+    /**
+     * @brief Cuenta las lecturas que tienen alguno de los bits de `mascara`.
+     */
+    size_t contarConBandera(unsigned char mascara) const {
+        size_t c = 0;
+        for (Nodo* it = cabeza; it; it = it->siguiente) {
+            if (it->banderas & mascara) c++;
+        }
+        return c;
+    }
+
     void clear() {
         Nodo* it = cabeza;
         while (it) {
@@ -168,10 +533,96 @@ public:
             delete it;
             it = nxt;
         }
+        bytesNodosResidentes() -= n * sizeof(Nodo);
         cabeza = cola = NULL;
         n = 0;
     }
 
+    size_t bytes() const { return n * sizeof(Nodo); }
+
+    /// Bytes por lectura en disco (volcar/restaurar): dato + banderas + marca.
+    static size_t bytesPorRegistro() { return sizeof(T) + 1 + sizeof(long long); }
+
+    /**
+     * @brief Escribe las lecturas (dato + banderas + marca) en el flujo actual de f,
+     *        a partir de la posición `desde`.
+     */
+    bool volcar(FILE* f, size_t desde = 0) const {
+        Nodo* it = cabeza;
+        for (size_t i = 0; it && i < desde; ++i) it = it->siguiente;
+        for (; it; it = it->siguiente) {
+            if (std::fwrite(&it->dato, sizeof(T), 1, f) != 1) return false;
+            if (std::fputc(it->banderas, f) == EOF) return false;
+            if (std::fwrite(&it->marcaMs, sizeof(it->marcaMs), 1, f) != 1) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Agrega al final cnt lecturas leídas de f (formato de volcar()).
+     */
+    bool restaurar(FILE* f, size_t cnt) {
+        for (size_t i = 0; i < cnt; ++i) {
+            T v;
+            unsigned char b;
+            long long m;
+            if (!leerRegistro(f, v, b, m)) return false;
+            push_back(v, b, m);
+        }
+        return true;
+    }
+
+    /// Lee un registro en el formato de volcar().
+    static bool leerRegistro(FILE* f, T& v, unsigned char& banderas, long long& marcaMs) {
+        int b;
+        if (std::fread(&v, sizeof(T), 1, f) != 1) return false;
+        if ((b = std::fgetc(f)) == EOF) return false;
+        if (std::fread(&marcaMs, sizeof(marcaMs), 1, f) != 1) return false;
+        banderas = (unsigned char)b;
+        return true;
+    }
+
+    /// Primer nodo, para recorridos de solo lectura (NULL si vacía).
+    const Nodo* primero() const { return cabeza; }
+
+    /// Último nodo (NULL si vacía).
+    const Nodo* ultimo() const { return cola; }
+
+    /**
+     * @brief Quita hasta `max` lecturas del frente y las copia en los arreglos.
+     * @return Lecturas quitadas.
+     */
+    size_t extraerFrente(T* datos, unsigned char* banderas, long long* marcas, size_t max) {
+        size_t k = 0;
+        while (cabeza && k < max) {
+            Nodo* x = cabeza;
+            datos[k] = x->dato;
+            banderas[k] = x->banderas;
+            marcas[k] = x->marcaMs;
+            k++;
+            cabeza = x->siguiente;
+            delete x;
+        }
+        if (!cabeza) cola = NULL;
+        n -= k;
+        bytesNodosResidentes() -= k * sizeof(Nodo);
+        return k;
+    }
+
+    /**
+     * @brief Mueve al final de esta lista los nodos de `otra` (O(1)); `otra`
+     *        queda vacía.
+     */
+    void anexarLista(ListaSensor& otra) {
+        if (this == &otra || !otra.cabeza) return;
+        if (cola) cola->siguiente = otra.cabeza;
+        else cabeza = otra.cabeza;
+        cola = otra.cola;
+        n += otra.n;
+        otra.cabeza = otra.cola = NULL;
+        otra.n = 0;
+    }
+
     // Utilidad de impresión (debug)
     void print_all(const char* prefix = "") const {
         printf("%s[", prefix);
@@ -184,7 +635,103 @@ public:
         printf("]\n");
     }
 
+    /**
+     * @brief Reduce el historial a lo sumo `puntos` lecturas representativas
+     *        con Largest-Triangle-Three-Buckets (eje x = marcaMs).
+     * @details Primera y última lectura fijas; el resto se reparte en
+     *          puntos - 2 cubos y de cada uno se elige la lectura que forma
+     *          el triángulo más grande con la elegida del cubo anterior y el
+     *          promedio del cubo siguiente. Se avanza una sola vez por la
+     *          lista: al promediar el cubo b + 1 se vuelve a recorrer el
+     *          cubo b desde su primer nodo, que sigue en caché.
+     * @return Lecturas escritas en `marcas`/`valores` (min(puntos, size())).
+     */
+    size_t reducirLttb(size_t puntos, long long* marcas, double* valores) const {
+        if (puntos == 0 || !cabeza) return 0;
+        if (puntos >= n || puntos < 3) {
+            size_t c = 0;
+            for (const Nodo* it = cabeza; it && c < puntos; it = it->siguiente, ++c) {
+                marcas[c] = it->marcaMs;
+                valores[c] = (double)it->dato;
+            }
+            if (puntos == 2 && n > 2) {
+                marcas[1] = cola->marcaMs;
+                valores[1] = (double)cola->dato;
+            }
+            return c;
+        }
+        const size_t cubos = puntos - 2;
+        const double ancho = (double)(n - 2) / (double)cubos;
+        const long long base = cabeza->marcaMs;
+        size_t c = 0;
+        marcas[c] = cabeza->marcaMs;
+        valores[c++] = (double)cabeza->dato;
+        double ax = 0.0, ay = (double)cabeza->dato;
+
+        const Nodo* it = cabeza->siguiente;
+        size_t idx = 1;
+        const Nodo* inicioCubo = it;
+        while (idx < finCubo(0, cubos, ancho)) { it = it->siguiente; ++idx; }
+        for (size_t b = 0; b < cubos; ++b) {
+            const Nodo* inicioSiguiente = it;
+            double px = 0.0, py = 0.0;
+            if (b + 1 < cubos) {
+                size_t fin = finCubo(b + 1, cubos, ancho), cuenta = 0;
+                for (; idx < fin; it = it->siguiente, ++idx, ++cuenta) {
+                    px += (double)(it->marcaMs - base);
+                    py += (double)it->dato;
+                }
+                px /= (double)cuenta;
+                py /= (double)cuenta;
+            } else {
+                px = (double)(cola->marcaMs - base);
+                py = (double)cola->dato;
+            }
+            const Nodo* elegido = inicioCubo;
+            double mayor = -1.0;
+            for (const Nodo* p = inicioCubo; p != inicioSiguiente; p = p->siguiente) {
+                double x = (double)(p->marcaMs - base), y = (double)p->dato;
+                double area = (ax - px) * (y - ay) - (ax - x) * (py - ay);
+                if (area < 0) area = -area;
+                if (area > mayor) {
+                    mayor = area;
+                    elegido = p;
+                }
+            }
+            marcas[c] = elegido->marcaMs;
+            valores[c++] = (double)elegido->dato;
+            ax = (double)(elegido->marcaMs - base);
+            ay = (double)elegido->dato;
+            inicioCubo = inicioSiguiente;
+        }
+        marcas[c] = cola->marcaMs;
+        valores[c++] = (double)cola->dato;
+        return c;
+    }
+
+    /**
+     * @brief Versión legible de print_all() para historiales grandes: imprime
+     *        `puntos` lecturas elegidas con reducirLttb(), una por línea.
+     * @return Lecturas impresas.
+     */
+    size_t print_summary(size_t puntos, const char* prefix = "") const {
+        long long* marcas = new long long[puntos ? puntos : 1];
+        double* valores = new double[puntos ? puntos : 1];
+        size_t c = reducirLttb(puntos, marcas, valores);
+        printf("%s%zu de %zu lecturas (LTTB)\n", prefix, c, n);
+        for (size_t i = 0; i < c; ++i)
+            printf("%s  +%lld ms  %s\n", prefix, marcas[i] - marcas[0], formatNumber((T)valores[i]));
+        delete[] marcas;
+        delete[] valores;
+        return c;
+    }
+
 private:
+    /// Índice (exclusivo) donde termina el cubo b de reducirLttb().
+    size_t finCubo(size_t b, size_t cubos, double ancho) const {
+        return b + 1 >= cubos ? n - 1 : 1 + (size_t)((double)(b + 1) * ancho);
+    }
+
     // Helpers sin STL: formateo de números a C-string temporal
     static const char* formatNumber(int v) {
         static char buf[64];
@@ -204,293 +751,9070 @@ private:
 };
 
 /* ============================================================
- *            Jerarquía polimórfica de sensores
+ *                 Reloj monotónico
  * ============================================================*/
 
 /**
- * @brief Clase base abstracta de sensores.
+ * @brief Nanosegundos de un reloj monotónico (no retrocede con ajustes de hora).
  */
-class SensorBase {
-protected:
-    char nombre[50]; ///< Identificador del sensor (e.g., "T-001")
+static inline unsigned long long relojNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
 
-public:
-    SensorBase(const char* id = "UNNAMED") {
-        std::strncpy(nombre, id, sizeof(nombre));
-        nombre[sizeof(nombre) - 1] = '\0';
-    }
+static inline unsigned long long relojMs() {
+    return relojNs() / 1000000ULL;
+}
 
-    virtual ~SensorBase() {} // VIRTUAL para liberar derivadas
+/**
+ * @brief Hora de pared en ms desde epoch (UTC), para marcar cada lectura.
+ */
+static inline long long relojEpochMs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000LL + (long long)(ts.tv_nsec / 1000000L);
+}
 
-    const char* getNombre() const { return nombre; }
+/**
+ * @brief Histograma log-lineal de latencias (ns): 8 sub-cubetas por potencia
+ *        de 2, error relativo <= 12.5%, tamaño fijo y registro O(1).
+ */
+struct HistogramaLatencia {
+    static const int CUBETAS = 496;
 
-    /**
-     * @brief Procesa las lecturas internas de cada sensor (polimórfico).
-     */
-    virtual void procesarLectura() = 0;
+    unsigned long long cuenta[CUBETAS];
+    unsigned long long total;
+    unsigned long long suma;
+    unsigned long long maximo;
 
-    /**
-     * @brief Imprime información resumen del sensor.
-     */
-    virtual void imprimirInfo() const = 0;
+    HistogramaLatencia() { reiniciar(); }
 
-    /**
-     * @brief Registra una lectura desde texto (general para menú/serial).
-     *        Cada derivada la parsea a su tipo.
-     */
-    virtual bool registrarDesdeTexto(const char* texto) = 0;
-};
+    void reiniciar() {
+        std::memset(cuenta, 0, sizeof(cuenta));
+        total = suma = maximo = 0;
+    }
 
-/**
- * @brief Sensor concreto: Temperatura (usa float).
- *  - Contiene ListaSensor<float> historial
- *  - Procesamiento: Elimina la lectura mínima y muestra promedio restante.
- */
-class SensorTemperatura : public SensorBase {
-private:
-    ListaSensor<float> historial;
+    static int indice(unsigned long long v) {
+        if (v < 8) return (int)v;
+        int e = 63 - __builtin_clzll(v);
+        return (e - 2) * 8 + (int)((v >> (e - 3)) & 7);
+    }
 
-public:
-    SensorTemperatura(const char* id) : SensorBase(id) {}
+    /// Cota superior de los valores que caen en la cubeta i.
+    static unsigned long long limite(int i) {
+        if (i < 8) return (unsigned long long)i;
+        int e = i / 8 + 2;
+        unsigned long long sub = (unsigned long long)(i % 8);
+        return ((8ULL + sub + 1) << (e - 3)) - 1;
+    }
 
-    virtual ~SensorTemperatura() {
-        printf("  [Destructor Sensor %s] Liberando Lista Interna (float)...\n", nombre);
-        // historial.clear() se llama en su destructor automáticamente.
+    void registrar(unsigned long long v) {
+        cuenta[indice(v)]++;
+        total++;
+        suma += v;
+        if (v > maximo) maximo = v;
     }
 
-    void agregar(float v) {
-        printf("[Log] Insertando Nodo<float> en %s.\n", nombre);
-        historial.push_back(v);
+    void combinar(const HistogramaLatencia& o) {
+        for (int i = 0; i < CUBETAS; ++i) cuenta[i] += o.cuenta[i];
+        total += o.total;
+        suma += o.suma;
+        if (o.maximo > maximo) maximo = o.maximo;
     }
 
-    virtual bool registrarDesdeTexto(const char* texto) {
-        // Texto esperado: número float, e.g. "45.3"
-        if (!texto) return false;
-        float v = 0.0f;
-        if (std::sscanf(texto, "%f", &v) == 1) {
-            agregar(v);
-            return true;
+    /**
+     * @brief Percentil aproximado (p en [0, 100]).
+     */
+    unsigned long long percentil(double p) const {
+        if (total == 0) return 0;
+        unsigned long long objetivo = (unsigned long long)((p / 100.0) * (double)total);
+        if (objetivo >= total) objetivo = total - 1;
+        unsigned long long acum = 0;
+        for (int i = 0; i < CUBETAS; ++i) {
+            acum += cuenta[i];
+            if (acum > objetivo) {
+                unsigned long long lim = limite(i);
+                return lim < maximo ? lim : maximo;
+            }
         }
-        return false;
+        return maximo;
     }
 
-    virtual void procesarLectura() {
-        printf("-> Procesando Sensor %s (Temperatura)...\n", nombre);
-        if (historial.size() == 0) {
-            printf("[Sensor Temp] No hay lecturas.\n");
-            return;
-        }
+    double promedio() const { return total ? (double)suma / (double)total : 0.0; }
 
-        // Eliminar mínima y reportar promedio del resto
-        float eliminado = 0.0f;
-        bool ok = historial.pop_min(eliminado);
-        if (ok) {
-            size_t n = historial.size();
-            float promedio = (n > 0) ? (historial.sum() / (float)n) : 0.0f;
-            printf("[Sensor Temp] Lectura más baja (%.3f) eliminada. Promedio restante: %.3f.\n",
-                   eliminado, promedio);
-        } else {
-            // Si no pudo eliminar, solo computa promedio
-            size_t n = historial.size();
-            float promedio = (n > 0) ? (historial.sum() / (float)n) : 0.0f;
-            printf("[Sensor Temp] Promedio calculado sobre %zu lectura(s): %.3f.\n", n, promedio);
-        }
+    void imprimir(const char* titulo) const {
+        printf("  %-22s n=%llu  prom=%.1f us  p50=%.1f us  p99=%.1f us  p99.9=%.1f us  max=%.1f us\n",
+               titulo, total, promedio() / 1000.0,
+               percentil(50.0) / 1000.0, percentil(99.0) / 1000.0,
+               percentil(99.9) / 1000.0, maximo / 1000.0);
     }
 
-    virtual void imprimirInfo() const {
-        printf("[%s] (Temperatura)\n", nombre);
+    void imprimirNs(const char* titulo) const {
+        printf("  %-22s n=%llu  prom=%.0f ns  p50=%llu ns  p99=%llu ns  p99.9=%llu ns  max=%llu ns\n",
+               titulo, total, promedio(), percentil(50.0), percentil(99.0), percentil(99.9), maximo);
     }
 };
 
+/* ============================================================
+ *          Trazas de latencia por etapa (reloj TSC)
+ * ============================================================*/
+
 /**
- * @brief Sensor concreto: Presión (usa int).
- *  - Contiene ListaSensor<int> historial
- *  - Procesamiento: Calcula promedio de lecturas (sin eliminar).
+ * @brief Trazado liviano de cada lectura: llegada -> cola -> parseo ->
+ *        aplicar (agregar) y, más tarde, procesarLectura().
+ * @details Las marcas son ciclos del TSC (rdtsc), calibrado contra
+ *          CLOCK_MONOTONIC al activar; fuera de x86 se usa relojNs().
+ *          Toda lectura alimenta los histogramas por etapa; una de cada
+ *          `muestreo` lecturas (y de cada `muestreo` procesarLectura())
+ *          guarda la traza completa en un anillo fijo, exportable
+ *          como JSON de Chrome trace (chrome://tracing, Perfetto).
  */
-class SensorPresion : public SensorBase {
+class Trazador {
+public:
+    enum Etapa {
+        ETAPA_COLA,            ///< Llegada -> inicio del parseo (~0 en el menú: la llegada es el fgets ya devuelto)
+        ETAPA_PARSEO,          ///< Separar ID/valor y buscar el sensor
+        ETAPA_APLICAR,         ///< agregar() completo
+        ETAPA_TOTAL,           ///< Llegada -> agregar() terminado
+        ETAPA_HASTA_PROCESADO, ///< Llegada de la lectura pendiente más vieja -> procesarLectura()
+        ETAPA_PROCESAR,        ///< Duración de procesarLectura()
+        ETAPAS
+    };
+
+    static const size_t MAX_TRAZAS = 4096;
+
+    struct Traza {
+        char sensor[24];
+        bool procesado;        ///< false: lectura; true: procesarLectura()
+        unsigned long long t[4];
+    };
+
 private:
-    ListaSensor<int> historial;
+    bool activo;
+    unsigned muestreo;
+    unsigned long long contador;          ///< Lecturas vistas (para el muestreo)
+    unsigned long long contadorProcesado; ///< procesarLectura() vistos (mismo muestreo)
+    unsigned long long tscBase;
+    double nsPorCiclo;
+    HistogramaLatencia etapas[ETAPAS];
+    Traza* trazas;
+    size_t numTrazas;          ///< Total guardadas (el anillo conserva las últimas)
 
-public:
-    SensorPresion(const char* id) : SensorBase(id) {}
+    Trazador(const Trazador&);
+    Trazador& operator=(const Trazador&);
 
-    virtual ~SensorPresion() {
-        printf("  [Destructor Sensor %s] Liberando Lista Interna (int)...\n", nombre);
-        // historial.clear() en destructor
+    Trazador()
+        : activo(false), muestreo(16), contador(0), contadorProcesado(0), tscBase(0), nsPorCiclo(1.0),
+          trazas(NULL), numTrazas(0) {}
+
+    void registrar(Etapa e, unsigned long long desde, unsigned long long hasta) {
+        if (hasta >= desde) etapas[e].registrar((unsigned long long)((hasta - desde) * nsPorCiclo));
     }
 
-    void agregar(int v) {
-        printf("[Log] Insertando Nodo<int> en %s.\n", nombre);
-        historial.push_back(v);
+    Traza& nuevaTraza(const char* sensor, bool procesado) {
+        Traza& t = trazas[numTrazas++ % MAX_TRAZAS];
+        size_t i = 0;
+        for (; sensor[i] && i + 1 < sizeof(t.sensor); ++i)
+            t.sensor[i] = (sensor[i] == '"' || sensor[i] == '\\' || (unsigned char)sensor[i] < 0x20) ? '_' : sensor[i];
+        t.sensor[i] = '\0';
+        t.procesado = procesado;
+        return t;
     }
 
-    virtual bool registrarDesdeTexto(const char* texto) {
-        // Texto esperado: número entero, e.g. "85"
-        if (!texto) return false;
-        int v = 0;
-        if (std::sscanf(texto, "%d", &v) == 1) {
-            agregar(v);
-            return true;
-        }
-        return false;
+    double us(unsigned long long c) const { return c > tscBase ? (c - tscBase) * nsPorCiclo / 1000.0 : 0.0; }
+
+public:
+    static Trazador& global() {
+        static Trazador t;
+        return t;
     }
 
-    virtual void procesarLectura() {
-        printf("-> Procesando Sensor %s (Presion)...\n", nombre);
-        size_t n = historial.size();
-        if (n == 0) {
-            printf("[Sensor Presion] No hay lecturas.\n");
-            return;
+    ~Trazador() { delete[] trazas; }
+
+    static unsigned long long ciclos() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return relojNs();
+#endif
+    }
+
+    bool estaActivo() const { return activo; }
+
+    /**
+     * @brief Calibra el TSC (~20 ms) y empieza a trazar.
+     * @param cadaN Una traza completa cada N lecturas
+     */
+    void activar(unsigned cadaN) {
+        muestreo = cadaN ? cadaN : 1;
+        if (!trazas) trazas = new Traza[MAX_TRAZAS];
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned long long n0 = relojNs(), c0 = ciclos();
+        while (relojNs() - n0 < 20000000ULL) {}
+        unsigned long long n1 = relojNs(), c1 = ciclos();
+        nsPorCiclo = (double)(n1 - n0) / (double)(c1 - c0);
+#endif
+        tscBase = ciclos();
+        activo = true;
+    }
+
+    /// Una lectura aplicada, con sus cuatro marcas.
+    void lectura(const char* sensor, unsigned long long llegada, unsigned long long inicioParseo,
+                 unsigned long long finParseo, unsigned long long finAplicar) {
+        registrar(ETAPA_COLA, llegada, inicioParseo);
+        registrar(ETAPA_PARSEO, inicioParseo, finParseo);
+        registrar(ETAPA_APLICAR, finParseo, finAplicar);
+        registrar(ETAPA_TOTAL, llegada, finAplicar);
+        if (contador++ % muestreo) return;
+        Traza& t = nuevaTraza(sensor, false);
+        t.t[0] = llegada;
+        t.t[1] = inicioParseo;
+        t.t[2] = finParseo;
+        t.t[3] = finAplicar;
+    }
+
+    /// Un procesarLectura(); `pendienteDesde` = llegada más vieja sin procesar (0 = ninguna).
+    void procesado(const char* sensor, unsigned long long pendienteDesde, unsigned long long inicio,
+                   unsigned long long fin) {
+        if (pendienteDesde) registrar(ETAPA_HASTA_PROCESADO, pendienteDesde, fin);
+        registrar(ETAPA_PROCESAR, inicio, fin);
+        if (contadorProcesado++ % muestreo) return;
+        Traza& t = nuevaTraza(sensor, true);
+        t.t[0] = pendienteDesde ? pendienteDesde : inicio;
+        t.t[1] = t.t[2] = inicio;
+        t.t[3] = fin;
+    }
+
+    void imprimir() const {
+        static const char* nombres[ETAPAS] = { "Cola:", "Parseo:", "Aplicar (agregar):", "Llegada -> aplicada:",
+                                               "Llegada -> procesada:", "procesarLectura:" };
+        printf("\n--- Trazas por etapa (%.3f ns/ciclo, 1 de cada %u guardada) ---\n", nsPorCiclo, muestreo);
+        if (!activo) {
+            printf("  Trazado inactivo (use --trazas archivo.json).\n");
+            return;
         }
-        int s = historial.sum();
-        float promedio = (float)s / (float)n;
-        printf("[Sensor Presion] Promedio de lecturas: %.3f (sobre %zu lecturas).\n", promedio, n);
+        for (int e = 0; e < ETAPAS; ++e) etapas[e].imprimirNs(nombres[e]);
+        printf("  Trazas completas guardadas: %zu\n", numTrazas < MAX_TRAZAS ? numTrazas : MAX_TRAZAS);
     }
 
-    virtual void imprimirInfo() const {
-        printf("[%s] (Presion)\n", nombre);
+    /**
+     * @brief Exporta las trazas guardadas como eventos "X" de Chrome trace:
+     *        hilo 1 = ingesta (lectura con cola/parseo/aplicar anidados),
+     *        hilo 2 = procesamiento.
+     */
+    bool exportarChrome(const char* ruta) const {
+        FILE* f = std::fopen(ruta, "w");
+        if (!f) return false;
+        std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"ingesta\"}},\n");
+        std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"procesamiento\"}}");
+        size_t total = numTrazas < MAX_TRAZAS ? numTrazas : MAX_TRAZAS;
+        size_t primera = numTrazas - total;
+        for (size_t k = primera; k < numTrazas; ++k) {
+            const Traza& t = trazas[k % MAX_TRAZAS];
+            if (t.procesado) {
+                std::fprintf(f, ",\n{\"name\":\"procesarLectura\",\"cat\":\"procesamiento\",\"ph\":\"X\",\"pid\":1,"
+                                "\"tid\":2,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"sensor\":\"%s\",\"espera_us\":%.3f}}",
+                             us(t.t[1]), us(t.t[3]) - us(t.t[1]), t.sensor, us(t.t[1]) - us(t.t[0]));
+                continue;
+            }
+            static const char* tramos[4] = { "lectura", "cola", "parseo", "aplicar" };
+            for (int i = 0; i < 4; ++i) {
+                unsigned long long a = i == 0 ? t.t[0] : t.t[i - 1];
+                unsigned long long b = i == 0 ? t.t[3] : t.t[i];
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"ingesta\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                                "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"sensor\":\"%s\"}}",
+                             tramos[i], us(a), us(b) - us(a), t.sensor);
+            }
+        }
+        std::fprintf(f, "\n]}\n");
+        return std::fclose(f) == 0;
     }
 };
 
 /* ============================================================
- *    Lista de gestión polimórfica (SensorBase*)
+ *     Planificación del procesamiento por sensor
  * ============================================================*/
 
-class ListaGeneral {
-public:
-    struct Nodo {
+class SensorBase;
+
+/**
+ * @brief Parámetros de planificación de un sensor (viven dentro del sensor).
+ */
+struct Planificacion {
+    unsigned long long periodoNs; ///< 0 = sin procesamiento periódico
+    unsigned long long vencePeriodo; ///< Próximo turno periódico (fase propia)
+    size_t cadaN;                 ///< 0 = sin disparo por número de lecturas
+    size_t pendientes;            ///< Lecturas desde el último procesamiento
+    long posHeap;                 ///< Posición en la cola (-1 = fuera)
+    bool porCuenta;               ///< En cola por haber llegado a cadaN
+
+    Planificacion()
+        : periodoNs(0), vencePeriodo(0), cadaN(0), pendientes(0), posHeap(-1), porCuenta(false) {}
+};
+
+/**
+ * @brief Cola de prioridad (montículo binario indexado) de sensores por
+ *        instante de vencimiento. Sustituye la ráfaga de procesarTodos():
+ *        cada sensor se procesa en su propio periodo o cada N lecturas.
+ * @details Las fases iniciales se escalonan (razón áurea) para repartir la
+ *          carga en el tiempo. El plazo periódico y el disparo por cuenta
+ *          son independientes: un procesamiento adelantado por cadaN no
+ *          corre la fase del periodo. Mide jitter (inicio real -
+ *          vencimiento) y la latencia de cada ciclo de procesarLectura().
+ */
+class PlanificadorProcesamiento {
+private:
+    struct Entrada {
+        unsigned long long vence;
         SensorBase* sensor;
-        Nodo* siguiente;
-        Nodo(SensorBase* ptr) : sensor(ptr), siguiente(NULL) {}
     };
 
-private:
-    Nodo* cabeza;
-    Nodo* cola;
+    Entrada* heap;
     size_t n;
+    size_t cap;
+    size_t registrados;
+    size_t omitidos;           ///< Ciclos periódicos saltados por retraso
+    HistogramaLatencia jitter;
+    HistogramaLatencia ciclo;
+
+    PlanificadorProcesamiento(const PlanificadorProcesamiento&);
+    PlanificadorProcesamiento& operator=(const PlanificadorProcesamiento&);
+
+    void colocar(size_t i, const Entrada& e);
+    void subir(size_t i);
+    void bajar(size_t i);
+    void fijarVencimiento(SensorBase* s, unsigned long long vence);
 
 public:
-    ListaGeneral() : cabeza(NULL), cola(NULL), n(0) {}
+    PlanificadorProcesamiento() : heap(NULL), n(0), cap(0), registrados(0), omitidos(0) {}
+    ~PlanificadorProcesamiento() { delete[] heap; }
 
-    ~ListaGeneral() {
-        liberarTodo();
+    size_t size() const { return n; }
+
+    /**
+     * @brief Programa un sensor. periodoMs y cadaN pueden combinarse; con
+     *        ambos en 0 el sensor sale de la planificación.
+     */
+    void planificar(SensorBase* s, unsigned long long periodoMs, size_t cadaN);
+
+    void quitar(SensorBase* s);
+
+    /// Llamado por el sensor en cada lectura (disparo "cada N lecturas").
+    void lecturaRegistrada(SensorBase* s);
+
+    /// Vencimiento más próximo (ns monotónicos); false si la cola está vacía.
+    bool proximo(unsigned long long& vence) const {
+        if (n == 0) return false;
+        vence = heap[0].vence;
+        return true;
     }
 
-    void push_back(SensorBase* s) {
-        Nodo* nuevo = new Nodo(s);
-        if (!cabeza) {
-            cabeza = cola = nuevo;
-        } else {
-            cola->siguiente = nuevo;
-            cola = nuevo;
+    /**
+     * @brief Procesa los sensores vencidos (como máximo maxPorRonda).
+     * @return Número de sensores procesados.
+     */
+    size_t ejecutarPendientes(size_t maxPorRonda = (size_t)-1);
+
+    void imprimirReporte() const;
+};
+
+
+/* ============================================================
+ *   Rueda jerárquica de temporizadores (detección de silencio)
+ * ============================================================*/
+
+class SensorBase;
+
+/**
+ * @brief Temporizador intrusivo: vive dentro del sensor, sin memoria extra.
+ */
+struct Temporizador {
+    Temporizador* prev;
+    Temporizador* next;
+    unsigned long long expira;  ///< Tick absoluto de vencimiento
+    unsigned long long plazoMs; ///< Silencio tolerado (0 = no vigilado)
+    SensorBase* sensor;
+    bool disparado;             ///< Ya alertó y espera una lectura nueva
+
+    Temporizador()
+        : prev(NULL), next(NULL), expira(0), plazoMs(0), sensor(NULL), disparado(false) {}
+
+    bool armado() const { return prev != NULL; }
+};
+
+/**
+ * @brief Rueda jerárquica (NIVELES x RANURAS) con listas circulares dobles.
+ * @details armar/desarmar son O(1). Un mapa de bits por nivel marca las
+ *          ranuras ocupadas, así avanzar() salta directo al próximo tick con
+ *          vencidos o con una ranura superior que redistribuir, en vez de
+ *          recorrer cada tick tras un período inactivo; proximoTick() da ese
+ *          instante para dormir hasta él. Alcance: 2^(NIVELES*BITS) ticks.
+ */
+class RuedaTemporizadores {
+public:
+    static const int BITS = 6;
+    static const int RANURAS = 1 << BITS;
+    static const int NIVELES = 4;
+    static const unsigned long long MASCARA = RANURAS - 1;
+    static const unsigned long long ALCANCE = 1ULL << (BITS * NIVELES);
+
+private:
+    Temporizador ranuras[NIVELES][RANURAS]; ///< Centinelas
+    unsigned long long ocupadas[NIVELES];   ///< Bit i: ranura i no vacía (RANURAS == 64)
+    unsigned long long actual;              ///< Último tick procesado
+    size_t activos;
+
+    RuedaTemporizadores(const RuedaTemporizadores&);
+    RuedaTemporizadores& operator=(const RuedaTemporizadores&);
+
+    void enlazar(Temporizador* t) {
+        unsigned long long delta = t->expira - actual;
+        int nivel = 0;
+        while (nivel < NIVELES - 1 && delta >= (1ULL << (BITS * (nivel + 1)))) nivel++;
+        unsigned long long idx = (t->expira >> (BITS * nivel)) & MASCARA;
+        Temporizador* cab = &ranuras[nivel][idx];
+        t->prev = cab->prev;
+        t->next = cab;
+        cab->prev->next = t;
+        cab->prev = t;
+        ocupadas[nivel] |= 1ULL << idx;
+    }
+
+    void desenlazar(Temporizador* t) {
+        t->prev->next = t->next;
+        t->next->prev = t->prev;
+        if (t->prev == t->next) {
+            // Solo quedó el centinela: la ranura está vacía.
+            size_t pos = (size_t)(t->prev - &ranuras[0][0]);
+            ocupadas[pos / RANURAS] &= ~(1ULL << (pos % RANURAS));
+        }
+        t->prev = t->next = NULL;
+    }
+
+    /// Reubica en niveles inferiores todo lo que cuelga de una ranura.
+    void cascada(int nivel, unsigned long long idx) {
+        Temporizador* cab = &ranuras[nivel][idx];
+        Temporizador* it = cab->next;
+        cab->next = cab->prev = cab;
+        ocupadas[nivel] &= ~(1ULL << idx);
+        while (it != cab) {
+            Temporizador* sig = it->next;
+            enlazar(it);
+            it = sig;
+        }
+    }
+
+    /**
+     * @brief Primer tick posterior a `actual` en que hay algo que hacer: una
+     *        ranura del nivel 0 con vencidos o una ranura superior ocupada
+     *        que se redistribuye al cruzar su límite.
+     */
+    unsigned long long siguienteEvento() const {
+        unsigned long long mejor = ~0ULL;
+        for (int nivel = 0; nivel < NIVELES; ++nivel) {
+            unsigned long long bits = ocupadas[nivel];
+            if (!bits) continue;
+            unsigned long long bloque = actual >> (BITS * nivel);
+            unsigned c = (unsigned)(bloque & MASCARA);
+            unsigned long long despues = c == MASCARA ? 0 : bits & (~0ULL << (c + 1));
+            // Distancia en ranuras (1..RANURAS): la misma ranura vuelve tras una vuelta.
+            unsigned long long d = despues ? (unsigned long long)__builtin_ctzll(despues) - c
+                                           : (unsigned long long)__builtin_ctzll(bits) + RANURAS - c;
+            unsigned long long tick = nivel == 0 ? actual + d : (bloque + d) << (BITS * nivel);
+            if (tick < mejor) mejor = tick;
+        }
+        return mejor;
+    }
+
+public:
+    RuedaTemporizadores() : actual(0), activos(0) {
+        for (int l = 0; l < NIVELES; ++l) {
+            ocupadas[l] = 0;
+            for (int i = 0; i < RANURAS; ++i)
+                ranuras[l][i].prev = ranuras[l][i].next = &ranuras[l][i];
+        }
+    }
+
+    unsigned long long tickActual() const { return actual; }
+    size_t size() const { return activos; }
+
+    /**
+     * @brief Arma (o rearma) t para vencer en el tick absoluto indicado.
+     */
+    void armar(Temporizador* t, unsigned long long expiraTick) {
+        if (t->armado()) desarmar(t);
+        if (expiraTick <= actual) expiraTick = actual + 1;
+        if (expiraTick - actual >= ALCANCE) expiraTick = actual + ALCANCE - 1;
+        t->expira = expiraTick;
+        enlazar(t);
+        activos++;
+    }
+
+    void desarmar(Temporizador* t) {
+        if (!t->armado()) return;
+        desenlazar(t);
+        activos--;
+    }
+
+    /**
+     * @brief Tick en que conviene volver a llamar a avanzar() (un vencimiento
+     *        o una redistribución). false si no hay temporizadores.
+     */
+    bool proximoTick(unsigned long long& tick) const {
+        if (!activos) return false;
+        tick = siguienteEvento();
+        return true;
+    }
+
+    /**
+     * @brief Avanza hasta el tick `hasta` y devuelve los vencidos, ya
+     *        desarmados, encadenados por `next` (NULL al final). Los ticks
+     *        sin eventos se saltan de una vez.
+     */
+    Temporizador* avanzar(unsigned long long hasta) {
+        Temporizador* vencidos = NULL;
+        while (actual < hasta) {
+            unsigned long long sig = activos ? siguienteEvento() : hasta;
+            if (sig > hasta) {
+                actual = hasta;
+                break;
+            }
+            actual = sig;
+            unsigned long long idx = actual & MASCARA;
+            for (int nivel = 1; idx == 0 && nivel < NIVELES; ++nivel) {
+                idx = (actual >> (BITS * nivel)) & MASCARA;
+                cascada(nivel, idx);
+            }
+            Temporizador* cab = &ranuras[0][actual & MASCARA];
+            while (cab->next != cab) {
+                Temporizador* t = cab->next;
+                desenlazar(t);
+                activos--;
+                t->next = vencidos;
+                vencidos = t;
+            }
+        }
+        return vencidos;
+    }
+};
+
+/**
+ * @brief Monitor de latidos: cada sensor vigilado rearma su temporizador en
+ *        cada lectura; si vence, el sensor lleva más de su plazo en silencio.
+ */
+class MonitorLatidos {
+private:
+    RuedaTemporizadores rueda;
+    unsigned long long inicioMs;
+    unsigned long long tickMs;
+    size_t alertas;
+
+    unsigned long long tickAhora() const { return (relojMs() - inicioMs) / tickMs; }
+
+public:
+    explicit MonitorLatidos(unsigned long long tick = 10)
+        : inicioMs(relojMs()), tickMs(tick ? tick : 1), alertas(0) {}
+
+    /**
+     * @brief Arma de nuevo el temporizador con su plazo, contado desde ahora.
+     */
+    void rearmar(Temporizador* t) {
+        t->disparado = false;
+        if (t->plazoMs == 0) return;
+        rueda.armar(t, tickAhora() + (t->plazoMs + tickMs - 1) / tickMs);
+    }
+
+    void olvidar(Temporizador* t) {
+        rueda.desarmar(t);
+        t->plazoMs = 0;
+        t->disparado = false;
+    }
+
+    size_t vigilados() const { return rueda.size(); }
+    size_t totalAlertas() const { return alertas; }
+
+    /**
+     * @brief Instante (relojMs) de la próxima revisión útil; false si no hay
+     *        sensores vigilados.
+     */
+    bool proximoMs(unsigned long long& ms) const {
+        unsigned long long tick;
+        if (!rueda.proximoTick(tick)) return false;
+        ms = inicioMs + tick * tickMs;
+        return true;
+    }
+
+    /**
+     * @brief Dispara las alertas vencidas hasta el instante actual.
+     * @return Número de sensores que entraron en silencio en esta revisión.
+     */
+    size_t revisar();
+};
+
+/* ============================================================
+ *        Filtros de suavizado aplicados en la ingesta
+ * ============================================================*/
+
+/**
+ * @brief Configuración de un filtro de suavizado: EWMA, Kalman 1-D o
+ *        mediana de k.
+ * @details Solo describe el filtro; el estado de cada sensor vive en su
+ *          ranura de BancoFiltros, que lo actualiza en O(1) para
+ *          EWMA/Kalman y O(k) para la mediana (k <= MAX_VENTANA).
+ */
+struct FiltroSuavizado {
+    enum Tipo { NINGUNO = 0, EWMA = 1, KALMAN = 2, MEDIANA = 3 };
+    static const int MAX_VENTANA = 15;
+
+    Tipo tipo;
+    double alpha;   ///< EWMA: peso de la lectura nueva (0, 1]
+    double q;       ///< Kalman: varianza del ruido de proceso
+    double r;       ///< Kalman: varianza del ruido de medición
+    int k;          ///< Mediana: tamaño de ventana (impar)
+
+    FiltroSuavizado() : tipo(NINGUNO), alpha(0.2), q(1e-3), r(0.1), k(5) {}
+
+    static FiltroSuavizado crearEWMA(double a) {
+        FiltroSuavizado f;
+        f.tipo = EWMA;
+        f.alpha = (a > 0.0 && a <= 1.0) ? a : 0.2;
+        return f;
+    }
+
+    static FiltroSuavizado crearKalman(double q, double r) {
+        FiltroSuavizado f;
+        f.tipo = KALMAN;
+        f.q = (q > 0.0) ? q : 1e-3;
+        f.r = (r > 0.0) ? r : 0.1;
+        return f;
+    }
+
+    static FiltroSuavizado crearMediana(int k) {
+        FiltroSuavizado f;
+        f.tipo = MEDIANA;
+        if (k < 1) k = 1;
+        if (k > MAX_VENTANA) k = MAX_VENTANA;
+        if (k % 2 == 0) k--; // ventana impar: la mediana es un elemento
+        f.k = k;
+        return f;
+    }
+
+    const char* nombreTipo() const {
+        switch (tipo) {
+            case EWMA:    return "EWMA";
+            case KALMAN:  return "Kalman 1-D";
+            case MEDIANA: return "Mediana";
+            default:      return "Ninguno";
+        }
+    }
+};
+
+/**
+ * @brief Serie suavizada de un sensor: valores y marcas en trozos de
+ *        TROZO lecturas, de modo que anexar no reserva memoria por lectura.
+ *        volcar()/restaurar() usan el formato de ListaSensor<float>.
+ */
+class SerieSuavizada {
+public:
+    static const size_t TROZO = 256;
+
+private:
+    struct Trozo {
+        float valores[TROZO];
+        long long marcas[TROZO];
+        size_t usados;
+        Trozo* siguiente;
+    };
+    Trozo* cabeza;
+    Trozo* cola;
+    size_t n;
+    size_t trozos;
+
+    SerieSuavizada(const SerieSuavizada&);
+    SerieSuavizada& operator=(const SerieSuavizada&);
+
+public:
+    SerieSuavizada() : cabeza(NULL), cola(NULL), n(0), trozos(0) {}
+    ~SerieSuavizada() { clear(); }
+
+    void push_back(float v, long long marcaMs) {
+        if (!cola || cola->usados == TROZO) {
+            Trozo* t = new Trozo;
+            t->usados = 0;
+            t->siguiente = NULL;
+            if (cola) cola->siguiente = t;
+            else cabeza = t;
+            cola = t;
+            trozos++;
+            bytesNodosResidentes() += sizeof(Trozo);
         }
+        cola->valores[cola->usados] = v;
+        cola->marcas[cola->usados++] = marcaMs;
         n++;
     }
 
     size_t size() const { return n; }
 
+    bool back(float& out) const {
+        if (!n) return false;
+        out = cola->valores[cola->usados - 1];
+        return true;
+    }
+
+    void clear() {
+        while (cabeza) {
+            Trozo* sig = cabeza->siguiente;
+            delete cabeza;
+            cabeza = sig;
+        }
+        bytesNodosResidentes() -= trozos * sizeof(Trozo);
+        cola = NULL;
+        n = trozos = 0;
+    }
+
+    size_t bytes() const { return trozos * sizeof(Trozo); }
+
+    bool volcar(FILE* f) const {
+        for (const Trozo* t = cabeza; t; t = t->siguiente) {
+            for (size_t i = 0; i < t->usados; ++i) {
+                if (std::fwrite(&t->valores[i], sizeof(float), 1, f) != 1) return false;
+                if (std::fputc(0, f) == EOF) return false;
+                if (std::fwrite(&t->marcas[i], sizeof(long long), 1, f) != 1) return false;
+            }
+        }
+        return true;
+    }
+
+    bool restaurar(FILE* f, size_t cnt) {
+        for (size_t i = 0; i < cnt; ++i) {
+            float v;
+            long long m;
+            if (std::fread(&v, sizeof(v), 1, f) != 1 || std::fgetc(f) == EOF ||
+                std::fread(&m, sizeof(m), 1, f) != 1) return false;
+            push_back(v, m);
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Estado de los filtros de todos los sensores en estructura de
+ *        arreglos (una ranura por sensor filtrado).
+ * @details La ingesta usa filtrar(): actualiza la ranura con la lectura
+ *          y anexa el valor suavizado a la SerieSuavizada del sensor en el
+ *          acto, de modo que la serie nunca va por detrás del historial.
+ *          aplicarLote() procesa un arreglo de lecturas de muchas ranuras:
+ *          reúne el estado de EWMA/Kalman en arreglos contiguos, lo
+ *          actualiza en un bucle sin saltos (vectorizable) y lo devuelve a
+ *          sus ranuras. Con la llegada intercalada de la ingesta el costo de
+ *          reunir y devolver supera lo que ahorra el bucle (--bench-filtros),
+ *          así que queda para quien ya tenga el lote armado.
+ */
+class BancoFiltros {
+public:
+    static const size_t LOTE = 256;
+
+private:
+    size_t cap;
+    size_t usadas;
+    unsigned char* tipo;      ///< FiltroSuavizado::Tipo (NINGUNO = ranura libre)
+    unsigned char* escalar;   ///< Mediana o sin primera lectura: ruta escalar
+    double* estado;
+    double* p;
+    double* q;                ///< 0 en EWMA
+    double* r;                ///< EWMA: (1 - alpha) / alpha
+    unsigned char* k;
+    unsigned char* llenos;
+    unsigned char* pos;
+    double* ventanas;         ///< MAX_VENTANA valores por ranura
+    unsigned* visto;          ///< Generación del sub-lote que ya usó la ranura
+    SerieSuavizada** destino;
+    unsigned* libres;
+    size_t numLibres;
+    unsigned generacion;
+    unsigned long long procesadas;
+
+    BancoFiltros(const BancoFiltros&);
+    BancoFiltros& operator=(const BancoFiltros&);
+
+    template <typename U>
+    static void crecer(U*& a, size_t viejo, size_t nuevo) {
+        U* mayor = new U[nuevo]();
+        if (viejo) std::memcpy(mayor, a, viejo * sizeof(U));
+        delete[] a;
+        a = mayor;
+    }
+
+    void ampliar() {
+        size_t nuevo = cap ? cap * 2 : 64;
+        crecer(tipo, cap, nuevo);
+        crecer(escalar, cap, nuevo);
+        crecer(estado, cap, nuevo);
+        crecer(p, cap, nuevo);
+        crecer(q, cap, nuevo);
+        crecer(r, cap, nuevo);
+        crecer(k, cap, nuevo);
+        crecer(llenos, cap, nuevo);
+        crecer(pos, cap, nuevo);
+        crecer(ventanas, cap * FiltroSuavizado::MAX_VENTANA, nuevo * FiltroSuavizado::MAX_VENTANA);
+        crecer(visto, cap, nuevo);
+        crecer(destino, cap, nuevo);
+        crecer(libres, cap, nuevo);
+        cap = nuevo;
+    }
+
+    double pasoMediana(unsigned s, double x) {
+        double* v = ventanas + (size_t)s * FiltroSuavizado::MAX_VENTANA;
+        v[pos[s]] = x;
+        pos[s] = (unsigned char)((pos[s] + 1) % k[s]);
+        if (llenos[s] < k[s]) llenos[s]++;
+        double tmp[FiltroSuavizado::MAX_VENTANA];
+        for (int i = 0; i < llenos[s]; ++i) {
+            double e = v[i];
+            int j = i - 1;
+            while (j >= 0 && tmp[j] > e) { tmp[j + 1] = tmp[j]; j--; }
+            tmp[j + 1] = e;
+        }
+        return estado[s] = tmp[llenos[s] / 2];
+    }
+
     /**
-     * @brief Busca por nombre (id) exacto. Retorna puntero o NULL.
+     * @brief Paso EWMA/Kalman sobre arreglos contiguos, sin saltos. EWMA se
+     *        guarda como Kalman con q = 0, p = 1 y r = (1 - alpha) / alpha
+     *        (ganancia alpha) cuya varianza no se actualiza; q > 0 hace de
+     *        máscara. Se pide vectorizar aunque el programa compile con -O2.
      */
-    SensorBase* buscarPorNombre(const char* id) {
-        Nodo* it = cabeza;
-        while (it) {
-            if (std::strcmp(it->sensor->getNombre(), id) == 0) {
-                return it->sensor;
-            }
-            it = it->siguiente;
+    __attribute__((optimize("tree-vectorize")))
+    static void actualizarContiguo(double* __restrict__ es, double* __restrict__ ps, const double* qs,
+                                   const double* rs, const double* xs, size_t m) {
+        for (size_t j = 0; j < m; ++j) {
+            double pp = ps[j] + qs[j];
+            double g = pp / (pp + rs[j]);
+            es[j] += g * (xs[j] - es[j]);
+            ps[j] = qs[j] > 0.0 ? pp * (1.0 - g) : ps[j];
         }
-        return NULL;
+    }
+
+public:
+    BancoFiltros()
+        : cap(0), usadas(0), tipo(NULL), escalar(NULL), estado(NULL), p(NULL), q(NULL), r(NULL),
+          k(NULL), llenos(NULL), pos(NULL), ventanas(NULL), visto(NULL), destino(NULL), libres(NULL),
+          numLibres(0), generacion(0), procesadas(0) {}
+
+    ~BancoFiltros() {
+        delete[] tipo;
+        delete[] escalar;
+        delete[] estado;
+        delete[] p;
+        delete[] q;
+        delete[] r;
+        delete[] k;
+        delete[] llenos;
+        delete[] pos;
+        delete[] ventanas;
+        delete[] visto;
+        delete[] destino;
+        delete[] libres;
+    }
+
+    static BancoFiltros& global() {
+        static BancoFiltros banco;
+        return banco;
     }
 
     /**
-     * @brief Itera y llama procesarLectura() en todos los sensores.
+     * @brief Reserva una ranura con la configuración de `f` (estado nuevo).
+     * @param serie Destino de los valores suavizados (NULL: solo se calculan).
      */
-    void procesarTodos() {
-        printf("\n--- Ejecutando Polimorfismo ---\n");
-        Nodo* it = cabeza;
-        while (it) {
-            it->sensor->procesarLectura();
-            it = it->siguiente;
+    unsigned alta(const FiltroSuavizado& f, SerieSuavizada* serie) {
+        unsigned s;
+        if (numLibres) {
+            s = libres[--numLibres];
+        } else {
+            if (usadas == cap) ampliar();
+            s = (unsigned)usadas++;
+        }
+        bool kalman = f.tipo == FiltroSuavizado::KALMAN;
+        tipo[s] = (unsigned char)f.tipo;
+        escalar[s] = 1;
+        estado[s] = 0.0;
+        p[s] = kalman ? f.r : 1.0;
+        q[s] = kalman ? f.q : 0.0;
+        r[s] = kalman ? f.r : (1.0 - f.alpha) / f.alpha;
+        k[s] = (unsigned char)f.k;
+        llenos[s] = pos[s] = 0;
+        visto[s] = 0;
+        destino[s] = serie;
+        return s;
+    }
+
+    /// Libera la ranura.
+    void baja(unsigned s) {
+        tipo[s] = FiltroSuavizado::NINGUNO;
+        destino[s] = NULL;
+        libres[numLibres++] = s;
+    }
+
+    const char* nombreTipo(unsigned s) const {
+        FiltroSuavizado f;
+        f.tipo = (FiltroSuavizado::Tipo)tipo[s];
+        return f.nombreTipo();
+    }
+
+    /// Ruta escalar: una lectura de una ranura.
+    double aplicar(unsigned s, double x) {
+        if (tipo[s] == FiltroSuavizado::MEDIANA) return pasoMediana(s, x);
+        if (escalar[s]) {
+            escalar[s] = 0;
+            return estado[s] = x;
+        }
+        double pp = p[s] + q[s];
+        double g = pp / (pp + r[s]);
+        estado[s] += g * (x - estado[s]);
+        if (tipo[s] == FiltroSuavizado::KALMAN) p[s] = pp * (1.0 - g);
+        return estado[s];
+    }
+
+    /**
+     * @brief Aplica lecturas de muchas ranuras (en orden) y deja los valores
+     *        suavizados en `out`.
+     */
+    void aplicarLote(const unsigned* ranuras, const double* x, float* out, size_t n) {
+        size_t idx[LOTE];
+        double es[LOTE], ps[LOTE], qs[LOTE], rs[LOTE], xs[LOTE];
+        size_t i = 0;
+        while (i < n) {
+            if (++generacion == 0) {
+                for (size_t s = 0; s < usadas; ++s) visto[s] = 0;
+                generacion = 1;
+            }
+            size_t m = 0, fin = i;
+            for (; fin < n && fin - i < LOTE; ++fin) {
+                unsigned s = ranuras[fin];
+                if (visto[s] == generacion) break;
+                visto[s] = generacion;
+                if (escalar[s]) {
+                    out[fin] = (float)aplicar(s, x[fin]);
+                    continue;
+                }
+                idx[m] = fin;
+                es[m] = estado[s];
+                ps[m] = p[s];
+                qs[m] = q[s];
+                rs[m] = r[s];
+                xs[m] = x[fin];
+                m++;
+            }
+            actualizarContiguo(es, ps, qs, rs, xs, m);
+            for (size_t j = 0; j < m; ++j) {
+                unsigned s = ranuras[idx[j]];
+                estado[s] = es[j];
+                p[s] = ps[j];
+                out[idx[j]] = (float)es[j];
+            }
+            i = fin;
+        }
+        procesadas += n;
+    }
+
+    /// Ruta de la ingesta: filtra la lectura y anexa el valor a su serie.
+    void filtrar(unsigned s, double x, long long marcaMs) {
+        float v = (float)aplicar(s, x);
+        procesadas++;
+        if (destino[s]) destino[s]->push_back(v, marcaMs);
+    }
+
+    size_t ranurasActivas() const { return usadas - numLibres; }
+    unsigned long long getProcesadas() const { return procesadas; }
+};
+
+/* ============================================================
+ *        Compresión del historial con error acotado
+ * ============================================================*/
+
+/**
+ * @brief Compresor por sensor al estilo de los historiadores industriales:
+ *        banda muerta o puerta giratoria (swinging door) con error máximo E.
+ * @details Solo los puntos de quiebre llegan al historial; la señal se
+ *          reconstruye uniendo quiebres con rectas sobre el eje de marcaMs,
+ *          y toda lectura cruda queda a distancia <= E de la reconstrucción
+ *          (E + 0.5 en sensores enteros, por el redondeo del quiebre).
+ *          - Banda muerta: se guarda una lectura si se aleja más de E de la
+ *            última guardada, precedida del valor retenido en la marca
+ *            anterior para que la recta no cruce el tramo plano.
+ *          - Puerta giratoria: se acota el haz de pendientes desde el ancla;
+ *            al cerrarse, el quiebre va en la última lectura sobre la
+ *            pendiente media del haz, que respeta a todas las del tramo.
+ *          El eje del tiempo necesita marcas estrictamente crecientes: dos
+ *          lecturas en el mismo milisegundo se separan 1 ms. La última
+ *          lectura queda pendiente hasta que otra cierra su tramo, hasta
+ *          que el tramo retenido supera `retencionMs` o hasta cerrarTramo().
+ */
+struct CompresorHistorial {
+    enum Tipo { NINGUNO = 0, BANDA_MUERTA = 1, PUERTA_GIRATORIA = 2 };
+
+    struct PuntoQuiebre {
+        long long marcaMs;
+        double valor;
+        unsigned char banderas; ///< OR de las banderas de calidad del tramo
+    };
+
+    static const long long RETENCION_MS = 60000;
+
+    Tipo tipo;
+    double error;            ///< Error máximo E (unidades del sensor)
+    bool entero;             ///< Redondear quiebres (historial int)
+    long long retencionMs;   ///< Tramo máximo sin guardar (0 = sin límite)
+    bool iniciado;
+    bool hayPendiente;
+    PuntoQuiebre ancla;      ///< Último quiebre guardado
+    PuntoQuiebre pendiente;  ///< Última lectura aún sin guardar
+    double pendSup, pendInf; ///< Haz de pendientes admisible desde el ancla
+    long long ultimaMarca;
+    size_t crudas, guardadas;
+
+    CompresorHistorial()
+        : tipo(NINGUNO), error(0.0), entero(false), retencionMs(RETENCION_MS), iniciado(false), hayPendiente(false),
+          pendSup(0.0), pendInf(0.0), ultimaMarca(0), crudas(0), guardadas(0) {
+        ancla = pendiente = punto(0, 0.0, 0);
+    }
+
+    static CompresorHistorial crearBandaMuerta(double e, bool entero = false) {
+        return crear(BANDA_MUERTA, e, entero);
+    }
+
+    static CompresorHistorial crearPuertaGiratoria(double e, bool entero = false) {
+        return crear(PUERTA_GIRATORIA, e, entero);
+    }
+
+    const char* nombreTipo() const {
+        switch (tipo) {
+            case BANDA_MUERTA:     return "Banda muerta";
+            case PUERTA_GIRATORIA: return "Puerta giratoria";
+            default:               return "Ninguna";
+        }
+    }
+
+    /**
+     * @brief Incorpora una lectura cruda.
+     * @param marcaMs Marca de la lectura; se corrige si no supera a la anterior.
+     * @param salida Recibe los quiebres a guardar, en orden (hasta 2).
+     * @return Cuántos quiebres escribió en salida (0, 1 o 2).
+     */
+    int agregar(double v, unsigned char b, long long& marcaMs, PuntoQuiebre salida[2]) {
+        if (iniciado && marcaMs <= ultimaMarca) marcaMs = ultimaMarca + 1;
+        ultimaMarca = marcaMs;
+        crudas++;
+        int n = 0;
+        // Un tramo retenido demasiado tiempo se cierra antes de seguir: así
+        // lo guardado nunca queda más de retencionMs detrás de lo leído.
+        int cerrado = 0; // cerrarTramo() ya lo contó en guardadas
+        if (hayPendiente && retencionMs > 0 && pendiente.marcaMs - ancla.marcaMs >= retencionMs)
+            n = cerrado = cerrarTramo(salida[0]);
+        if (!iniciado) {
+            iniciado = true;
+            ancla = salida[n++] = punto(marcaMs, redondear(v), b);
+        } else if (tipo == BANDA_MUERTA) {
+            double d = v - ancla.valor;
+            if (d <= error && -d <= error) {
+                unsigned char previas = hayPendiente ? pendiente.banderas : 0;
+                pendiente = punto(marcaMs, ancla.valor, (unsigned char)(previas | b));
+                hayPendiente = true;
+                return n;
+            }
+            if (hayPendiente) salida[n++] = pendiente;
+            ancla = salida[n++] = punto(marcaMs, redondear(v), b);
+            hayPendiente = false;
+        } else {
+            double dt = (double)(marcaMs - ancla.marcaMs);
+            double sup = (v + error - ancla.valor) / dt;
+            double inf = (v - error - ancla.valor) / dt;
+            if (!hayPendiente) {
+                pendSup = sup;
+                pendInf = inf;
+                pendiente = punto(marcaMs, v, b);
+                hayPendiente = true;
+                return n;
+            }
+            double nSup = sup < pendSup ? sup : pendSup;
+            double nInf = inf > pendInf ? inf : pendInf;
+            if (nInf <= nSup) {
+                pendSup = nSup;
+                pendInf = nInf;
+                pendiente = punto(marcaMs, v, (unsigned char)(pendiente.banderas | b));
+                return 0;
+            }
+            // Puerta cerrada: el quiebre cierra el tramo en la lectura anterior.
+            ancla = salida[n++] = punto(pendiente.marcaMs, finTramo(), pendiente.banderas);
+            dt = (double)(marcaMs - ancla.marcaMs);
+            pendSup = (v + error - ancla.valor) / dt;
+            pendInf = (v - error - ancla.valor) / dt;
+            pendiente = punto(marcaMs, v, b);
+        }
+        guardadas += n - cerrado;
+        return n;
+    }
+
+    /**
+     * @brief Guarda el extremo pendiente como quiebre y lo vuelve el ancla;
+     *        la compresión sigue desde ahí. Se usa antes de instantáneas,
+     *        checkpoints, exportaciones, reconfiguración y cierre.
+     * @return 1 si escribió el quiebre en q, 0 si no había pendiente.
+     */
+    int cerrarTramo(PuntoQuiebre& q) {
+        if (!puntoPendiente(q)) return 0;
+        ancla = q;
+        hayPendiente = false;
+        guardadas++;
+        return 1;
+    }
+
+    /**
+     * @brief Extremo de la reconstrucción que aún no está en el historial.
+     */
+    bool puntoPendiente(PuntoQuiebre& p) const {
+        if (!hayPendiente) return false;
+        p = pendiente;
+        if (tipo == PUERTA_GIRATORIA) p.valor = finTramo();
+        return true;
+    }
+
+    double razon() const { return guardadas ? (double)crudas / (double)guardadas : 0.0; }
+
+    /**
+     * @brief Promedio ponderado en el tiempo de la señal reconstruida
+     *        (trapecios entre quiebres, incluido el punto pendiente). Recorre
+     *        solo los quiebres. Sin duración, es el promedio simple.
+     * @return false si no hay puntos.
+     */
+    template <typename T>
+    bool promedioReconstruido(const ListaSensor<T>& h, double& promedio) const {
+        double area = 0.0, suma = 0.0;
+        size_t puntos = 0;
+        long long t0 = 0, tAnt = 0;
+        double vAnt = 0.0;
+        for (const typename ListaSensor<T>::Nodo* x = h.primero(); x; x = x->siguiente) {
+            acumular(x->marcaMs, (double)x->dato, puntos, t0, tAnt, vAnt, area, suma);
+        }
+        PuntoQuiebre p;
+        if (puntoPendiente(p)) acumular(p.marcaMs, p.valor, puntos, t0, tAnt, vAnt, area, suma);
+        if (puntos == 0) return false;
+        promedio = tAnt > t0 ? area / (double)(tAnt - t0) : suma / (double)puntos;
+        return true;
+    }
+
+    void imprimir() const {
+        printf("    Compresion %s (E=%g): %zu lecturas -> %zu quiebres (%.1fx)\n",
+               nombreTipo(), error, crudas, guardadas, razon());
+    }
+
+private:
+    static CompresorHistorial crear(Tipo t, double e, bool entero) {
+        CompresorHistorial c;
+        c.tipo = t;
+        c.error = e > 0.0 ? e : 0.0;
+        c.entero = entero;
+        return c;
+    }
+
+    static PuntoQuiebre punto(long long m, double v, unsigned char b) {
+        PuntoQuiebre p;
+        p.marcaMs = m;
+        p.valor = v;
+        p.banderas = b;
+        return p;
+    }
+
+    double redondear(double v) const {
+        if (!entero) return v;
+        return v >= 0.0 ? (double)(long long)(v + 0.5) : -(double)(long long)(0.5 - v);
+    }
+
+    /// Valor en la lectura pendiente sobre la pendiente media del haz.
+    double finTramo() const {
+        return redondear(ancla.valor + 0.5 * (pendSup + pendInf) * (double)(pendiente.marcaMs - ancla.marcaMs));
+    }
+
+    static void acumular(long long t, double v, size_t& puntos, long long& t0, long long& tAnt,
+                         double& vAnt, double& area, double& suma) {
+        if (puntos == 0) t0 = t;
+        else if (t > tAnt) area += 0.5 * (vAnt + v) * (double)(t - tAnt);
+        suma += v;
+        puntos++;
+        tAnt = t > tAnt || puntos == 1 ? t : tAnt;
+        vAnt = v;
+    }
+};
+
+/* ============================================================
+ *      Almacenamiento cuantizado de temperaturas (16/8 bits)
+ * ============================================================*/
+
+/**
+ * @brief float -> IEEE binary16 por software (redondeo al par más cercano).
+ */
+static inline unsigned short floatAMedio(float f) {
+    unsigned x;
+    std::memcpy(&x, &f, sizeof(x));
+    unsigned short signo = (unsigned short)((x >> 16) & 0x8000);
+    unsigned expF = (x >> 23) & 0xFF;
+    unsigned mant = x & 0x7FFFFF;
+    if (expF == 0xFF) return (unsigned short)(signo | 0x7C00 | (mant ? 0x200 : 0));
+    int e = (int)expF - 127 + 15;
+    if (e >= 31) return (unsigned short)(signo | 0x7C00);
+    if (e <= 0) { // subnormal en binary16
+        if (e < -10) return signo;
+        mant |= 0x800000;
+        unsigned corrimiento = (unsigned)(14 - e);
+        unsigned h = mant >> corrimiento;
+        unsigned resto = mant & ((1u << corrimiento) - 1);
+        unsigned mitad = 1u << (corrimiento - 1);
+        if (resto > mitad || (resto == mitad && (h & 1))) h++;
+        return (unsigned short)(signo | h);
+    }
+    unsigned h = ((unsigned)e << 10) | (mant >> 13);
+    unsigned resto = mant & 0x1FFF;
+    if (resto > 0x1000 || (resto == 0x1000 && (h & 1))) h++; // el acarreo puede llegar a infinito
+    return (unsigned short)(signo | h);
+}
+
+/**
+ * @brief IEEE binary16 -> float por software.
+ */
+static inline float medioAFloat(unsigned short h) {
+    unsigned signo = (unsigned)(h & 0x8000) << 16;
+    unsigned e = (h >> 10) & 0x1F;
+    unsigned mant = h & 0x3FF;
+    unsigned x;
+    if (e == 0 && mant == 0) {
+        x = signo;
+    } else if (e == 0) {
+        int ee = 1;
+        while (!(mant & 0x400)) { mant <<= 1; ee--; }
+        x = signo | ((unsigned)(ee + 112) << 23) | ((mant & 0x3FF) << 13);
+    } else if (e == 31) {
+        x = signo | 0x7F800000 | (mant << 13);
+    } else {
+        x = signo | ((e + 112) << 23) | (mant << 13);
+    }
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * @brief Suma de valores binary16 convirtiendo de a 8 con F16C (vcvtph2ps).
+ */
+__attribute__((target("avx,f16c")))
+static double sumarMediosF16c(const unsigned short* v, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(v + i))));
+    }
+    float parcial[8];
+    _mm256_storeu_ps(parcial, acc);
+    double s = 0.0;
+    for (int k = 0; k < 8; ++k) s += parcial[k];
+    for (; i < n; ++i) s += medioAFloat(v[i]);
+    return s;
+}
+
+static bool hayF16c() {
+    static int soporta = -1;
+    if (soporta < 0) soporta = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    return soporta != 0;
+}
+#endif
+
+/**
+ * @brief Suma de valores binary16 (F16C si la CPU lo soporta).
+ */
+static double sumarMedios(const unsigned short* v, size_t n) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (hayF16c()) return sumarMediosF16c(v, n);
+#endif
+    double s = 0.0;
+    for (size_t i = 0; i < n; ++i) s += medioAFloat(v[i]);
+    return s;
+}
+
+/**
+ * @brief Tramo frío del historial de una temperatura, en bloques de
+ *        BLOQUE lecturas con el valor reducido a 16 u 8 bits.
+ * @details Modos:
+ *          - F16: IEEE binary16 (paso de 0.0156 entre 16 y 32 °C).
+ *          - Q16 / Q8: valor = base + escala * q con base y escala por
+ *            bloque. La escala es la menor potencia de dos que cubre el
+ *            rango del bloque en 65533 o 253 pasos y la base un múltiplo
+ *            suyo, así un valor ya decuantizado cae en la grilla.
+ *          Cada lectura ocupa ancho + 1 (banderas) + 4 (marca relativa al
+ *          bloque) bytes, contra los 24 del nodo de ListaSensor; la suma
+ *          lee solo el arreglo de valores (2 o 1 byte por lectura). Los
+ *          borrados de procesarLectura() quedan como lápida en banderas y
+ *          se descuentan de la suma con un ajuste por bloque.
+ *          Volver a cuantizar valores decuantizados (F16 siempre, Q16/Q8
+ *          por la grilla) los deja iguales: el desborde, las instantáneas y
+ *          la migración escriben lecturas float y se recargan al archivo sin
+ *          sumar error. Lo que una recarga sí mueva se suma a la cota.
+ */
+class ArchivoCuantizado {
+public:
+    enum Modo { F16 = 1, Q16 = 2, Q8 = 3 };
+    static const size_t BLOQUE = 1024;
+    static const unsigned char BORRADO = 0x80; ///< Bit de lápida en banderas
+
+private:
+    struct Bloque {
+        size_t n;
+        size_t borrados;
+        double ajuste;           ///< Suma de los valores borrados
+        float base, escala;      ///< Solo Q16/Q8
+        long long marca0;
+        int* deltaMs;            ///< marcaMs - marca0
+        unsigned char* banderas;
+        unsigned char* valores;  ///< n * ancho() bytes
+    };
+
+    Modo modo;
+    Bloque* bloques;
+    size_t cuantos, capacidad;
+    size_t vivas;
+    double errorMax, errorCuad;
+    size_t medidas;
+    double errorPrevio;   ///< Cota del error de un archivo anterior ya decuantizado
+    double errorRecarga;  ///< Error de la recarga en curso (se suma al cerrarla)
+
+    // No copiable: posee los bloques.
+    ArchivoCuantizado(const ArchivoCuantizado&);
+    ArchivoCuantizado& operator=(const ArchivoCuantizado&);
+
+    float valor(const Bloque& b, size_t i) const {
+        if (modo == F16) return medioAFloat(((const unsigned short*)b.valores)[i]);
+        unsigned q = modo == Q16 ? ((const unsigned short*)b.valores)[i] : b.valores[i];
+        return b.base + b.escala * (float)q;
+    }
+
+    double sumaBloque(const Bloque& b) const {
+        double s;
+        if (modo == F16) {
+            s = sumarMedios((const unsigned short*)b.valores, b.n);
+        } else {
+            unsigned long long q = 0;
+            if (modo == Q16) {
+                const unsigned short* v = (const unsigned short*)b.valores;
+                for (size_t i = 0; i < b.n; ++i) q += v[i];
+            } else {
+                for (size_t i = 0; i < b.n; ++i) q += b.valores[i];
+            }
+            s = (double)b.base * (double)b.n + (double)b.escala * (double)q;
+        }
+        return s - b.ajuste;
+    }
+
+public:
+    explicit ArchivoCuantizado(Modo m)
+        : modo(m), bloques(NULL), cuantos(0), capacidad(0), vivas(0),
+          errorMax(0.0), errorCuad(0.0), medidas(0), errorPrevio(0.0), errorRecarga(0.0) {}
+
+    ~ArchivoCuantizado() { vaciar(); }
+
+    Modo getModo() const { return modo; }
+
+    const char* nombreModo() const {
+        switch (modo) {
+            case F16: return "float16";
+            case Q16: return "16 bits escalado";
+            default:  return "8 bits escalado";
+        }
+    }
+
+    size_t ancho() const { return modo == Q8 ? 1 : 2; }
+
+    /// Error máximo contra las lecturas originales (suma la cota heredada).
+    double getErrorMax() const { return errorPrevio + errorMax; }
+
+    /**
+     * @brief Las lecturas que recibirá ya traen el error de otro archivo
+     *        (cambio de modo): se suma a la cota para no subestimarla.
+     */
+    void heredarError(double e) { errorPrevio += e; }
+
+    /// Suma a la cota el error de las lecturas recargadas con archivar(..., true).
+    void cerrarRecarga() {
+        errorPrevio += errorRecarga;
+        errorRecarga = 0.0;
+    }
+
+    size_t size() const { return vivas; }
+
+    size_t bytes() const {
+        size_t b = capacidad * sizeof(Bloque);
+        for (size_t i = 0; i < cuantos; ++i) b += bloques[i].n * (sizeof(int) + 1 + ancho());
+        return b;
+    }
+
+    void vaciar() {
+        for (size_t i = 0; i < cuantos; ++i) delete[] (unsigned char*)bloques[i].deltaMs;
+        delete[] bloques;
+        bloques = NULL;
+        cuantos = capacidad = vivas = 0;
+    }
+
+    /**
+     * @brief Cuantiza n lecturas (n <= BLOQUE) en un bloque nuevo y mide el
+     *        error contra los valores originales. El desfase de cada marca
+     *        se guarda en 32 bits: si una se aleja más de ±24 días de la
+     *        primera, el bloque se cierra antes y el resto abre otro.
+     * @param recarga Las lecturas ya pasaron por un archivo (desborde,
+     *        migración): su error se acumula aparte hasta cerrarRecarga().
+     */
+    void archivar(const float* v, const unsigned char* b, const long long* m, size_t n, bool recarga = false) {
+        if (n == 0) return;
+        for (size_t i = 1; i < n; ++i) {
+            long long d = m[i] - m[0];
+            if (d <= 0x7FFFFFFFLL && d >= -0x7FFFFFFFLL) continue;
+            archivar(v, b, m, i, recarga);
+            archivar(v + i, b + i, m + i, n - i, recarga);
+            return;
+        }
+        if (cuantos == capacidad) {
+            size_t nueva = capacidad ? capacidad * 2 : 8;
+            Bloque* mas = new Bloque[nueva];
+            for (size_t i = 0; i < cuantos; ++i) mas[i] = bloques[i];
+            delete[] bloques;
+            bloques = mas;
+            capacidad = nueva;
+        }
+        Bloque& k = bloques[cuantos++];
+        unsigned char* memoria = new unsigned char[n * (sizeof(int) + 1 + ancho())];
+        k.n = n;
+        k.borrados = 0;
+        k.ajuste = 0.0;
+        k.marca0 = m[0];
+        k.deltaMs = (int*)memoria;
+        k.valores = memoria + n * sizeof(int); // antes que las banderas: alineado a 2 con n impar
+        k.banderas = k.valores + n * ancho();
+        float menor = v[0], mayor = v[0];
+        for (size_t i = 1; i < n; ++i) {
+            if (v[i] < menor) menor = v[i];
+            if (v[i] > mayor) mayor = v[i];
+        }
+        double niveles = modo == Q16 ? 65535.0 : 255.0;
+        if (modo != F16) {
+            // Rango en niveles - 2 pasos: con la base redondeada hacia abajo
+            // los valores decuantizados siguen cabiendo en niveles - 1 y la
+            // recarga elige la misma escala o una divisora. La escala no baja
+            // de 2^-22 del mayor módulo para que base + escala * q sea exacto.
+            double modulo = std::fabs((double)menor) > std::fabs((double)mayor) ? std::fabs((double)menor)
+                                                                                 : std::fabs((double)mayor);
+            int ex = 0;
+            std::frexp(modulo, &ex);
+            int e = ex - 22 < -100 ? -100 : ex - 22;
+            while ((double)mayor - (double)menor > (niveles - 2.0) * std::ldexp(1.0, e)) e++;
+            k.escala = (float)std::ldexp(1.0, e);
+            k.base = (float)(std::floor((double)menor / k.escala) * k.escala);
+        } else {
+            k.base = 0.0f;
+            k.escala = 1.0f;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            k.deltaMs[i] = (int)(m[i] - k.marca0);
+            k.banderas[i] = (unsigned char)(b[i] & ~BORRADO);
+            if (modo == F16) {
+                ((unsigned short*)k.valores)[i] = floatAMedio(v[i]);
+            } else {
+                double q = std::floor(((double)v[i] - k.base) / k.escala + 0.5);
+                unsigned qi = q <= 0.0 ? 0u : (q >= niveles ? (unsigned)niveles : (unsigned)q);
+                if (modo == Q16) ((unsigned short*)k.valores)[i] = (unsigned short)qi;
+                else k.valores[i] = (unsigned char)qi;
+            }
+            double e = (double)valor(k, i) - (double)v[i];
+            if (e < 0) e = -e;
+            if (recarga) {
+                if (e > errorRecarga) errorRecarga = e;
+                continue;
+            }
+            if (e > errorMax) errorMax = e;
+            errorCuad += e * e;
+            medidas++;
+        }
+        vivas += n;
+    }
+
+    /**
+     * @brief Suma de las lecturas vivas, bloque por bloque.
+     */
+    double suma() const {
+        double s = 0.0;
+        for (size_t i = 0; i < cuantos; ++i) s += sumaBloque(bloques[i]);
+        return s;
+    }
+
+    /**
+     * @brief Menor lectura viva y su ubicación (para borrar()).
+     */
+    bool minimo(float& out, size_t& bloque, size_t& pos) const {
+        bool hay = false;
+        for (size_t i = 0; i < cuantos; ++i) {
+            const Bloque& b = bloques[i];
+            if (b.borrados == b.n) continue;
+            for (size_t j = 0; j < b.n; ++j) {
+                if (b.banderas[j] & BORRADO) continue;
+                float x = valor(b, j);
+                if (!hay || x < out) {
+                    out = x;
+                    bloque = i;
+                    pos = j;
+                    hay = true;
+                }
+            }
+        }
+        return hay;
+    }
+
+    void borrar(size_t bloque, size_t pos) {
+        Bloque& b = bloques[bloque];
+        if (b.banderas[pos] & BORRADO) return;
+        b.banderas[pos] |= BORRADO;
+        b.ajuste += valor(b, pos);
+        b.borrados++;
+        vivas--;
+    }
+
+    /**
+     * @brief Recorre las lecturas vivas en orden sin expandir el archivo:
+     *        f(valor, banderas, marcaMs) por cada una.
+     */
+    template <typename F>
+    void recorrer(F& f) const {
+        for (size_t i = 0; i < cuantos; ++i) {
+            const Bloque& b = bloques[i];
+            if (b.borrados == b.n) continue;
+            for (size_t j = 0; j < b.n; ++j) {
+                if (b.banderas[j] & BORRADO) continue;
+                f(valor(b, j), b.banderas[j], b.marca0 + b.deltaMs[j]);
+            }
+        }
+    }
+
+    /**
+     * @brief Agrega a `destino` las lecturas vivas decuantizadas, en orden.
+     */
+    void volcarEn(ListaSensor<float>& destino) const {
+        for (size_t i = 0; i < cuantos; ++i) {
+            const Bloque& b = bloques[i];
+            for (size_t j = 0; j < b.n; ++j) {
+                if (b.banderas[j] & BORRADO) continue;
+                destino.push_back(valor(b, j), b.banderas[j], b.marca0 + b.deltaMs[j]);
+            }
+        }
+    }
+
+    /**
+     * @brief Escribe las lecturas vivas desde la posición `desde` con el
+     *        formato de ListaSensor<float>::volcar().
+     */
+    bool escribir(FILE* f, size_t desde) const {
+        size_t idx = 0;
+        for (size_t i = 0; i < cuantos; ++i) {
+            const Bloque& b = bloques[i];
+            if (idx + (b.n - b.borrados) <= desde) {
+                idx += b.n - b.borrados;
+                continue;
+            }
+            for (size_t j = 0; j < b.n; ++j) {
+                if (b.banderas[j] & BORRADO) continue;
+                if (idx++ < desde) continue;
+                float x = valor(b, j);
+                long long m = b.marca0 + b.deltaMs[j];
+                if (std::fwrite(&x, sizeof(x), 1, f) != 1) return false;
+                if (std::fputc(b.banderas[j], f) == EOF) return false;
+                if (std::fwrite(&m, sizeof(m), 1, f) != 1) return false;
+            }
+        }
+        return true;
+    }
+
+    void imprimir() const {
+        printf("    Archivo %s: %zu lecturas en %zu bloques (%zu bytes, %.1f por lectura)\n",
+               nombreModo(), vivas, cuantos, bytes(), vivas ? (double)bytes() / (double)vivas : 0.0);
+        printf("    Error de cuantizacion: max %.5f, rms %.5f\n", getErrorMax(),
+               medidas ? std::sqrt(errorCuad / (double)medidas) : 0.0);
+    }
+};
+
+/* ============================================================
+ *     Bocetos probabilísticos por sensor (HLL + count-min)
+ * ============================================================*/
+
+/**
+ * @brief Finalizador de splitmix64: dispersa bien claves parecidas.
+ */
+static inline unsigned long long mezclar64(unsigned long long x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief HyperLogLog (valores distintos) y count-min (frecuencia de un
+ *        valor) de tamaño fijo: 2 KB de registros + 4 KB de contadores.
+ * @details La clave es el valor llevado a float: la ingesta de temperatura
+ *          ve (double)22.1f y una consulta escribe 22.1, y ambos deben caer
+ *          en la misma celda. Así 3 de presión y 3.0 de temperatura cuentan
+ *          como el mismo valor al combinar. Los enteros solo son exactos
+ *          hasta 2^24: por encima, presiones vecinas comparten clave. Los
+ *          registros son bytes contiguos alineados a 64 y los contadores
+ *          filas de uint32: combinar() es un máximo byte a byte y una suma
+ *          por fila, bucles que el compilador vectoriza.
+ *          Error típico de distintos: 1.04/sqrt(2048) = 2.3%. La frecuencia
+ *          nunca se subestima y excede la real en más de e/ANCHO * total
+ *          con probabilidad e^-FILAS (< 2%).
+ */
+struct BocetoSensor {
+    static const int BITS_HLL = 11;
+    static const size_t REGISTROS = 1u << BITS_HLL;
+    static const size_t FILAS = 4;
+    static const size_t ANCHO = 256;
+
+    alignas(64) unsigned char registros[REGISTROS];
+    alignas(64) unsigned contadores[FILAS][ANCHO];
+    unsigned long long total;   ///< Lecturas incorporadas
+
+    BocetoSensor() { clear(); }
+
+    // new de C++11 no respeta alignas(64): se reserva alineado a mano.
+    static void* operator new(size_t bytes) {
+        void* p = NULL;
+        if (posix_memalign(&p, 64, bytes) != 0) throw std::bad_alloc();
+        return p;
+    }
+    // Fuera de línea: inlineado, GCC 12 ve free() sobre un puntero de new
+    // (-Wmismatched-new-delete) aunque venga de posix_memalign.
+    __attribute__((noinline)) static void operator delete(void* p) { std::free(p); }
+
+    void clear() {
+        std::memset(registros, 0, sizeof(registros));
+        std::memset(contadores, 0, sizeof(contadores));
+        total = 0;
+    }
+
+    /// Clave canónica: misma para agregar() y frecuencia().
+    static unsigned long long claveDe(double v) {
+        float f = (float)v;
+        if (f == 0.0f) f = 0.0f; // -0.0 y 0.0 son el mismo valor
+        unsigned bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        return mezclar64(bits);
+    }
+
+    void agregar(double v) {
+        unsigned long long h = claveDe(v);
+        size_t idx = (size_t)(h >> (64 - BITS_HLL));
+        unsigned long long resto = (h << BITS_HLL) | (1ULL << (BITS_HLL - 1)); // centinela: rho <= 64-BITS+1
+        unsigned char rho = (unsigned char)(__builtin_clzll(resto) + 1);
+        if (rho > registros[idx]) registros[idx] = rho;
+
+        unsigned long long g = mezclar64(h ^ 0x9e3779b97f4a7c15ULL);
+        unsigned h1 = (unsigned)g, h2 = (unsigned)(g >> 32) | 1u;
+        for (size_t f = 0; f < FILAS; ++f) {
+            unsigned& c = contadores[f][(h1 + (unsigned)f * h2) & (ANCHO - 1)];
+            if (c != 0xFFFFFFFFu) c++;
+        }
+        total++;
+    }
+
+    /**
+     * @brief Une otro boceto (otro sensor u otro grupo) a este.
+     */
+    void combinar(const BocetoSensor& o) {
+        for (size_t i = 0; i < REGISTROS; ++i)
+            registros[i] = registros[i] > o.registros[i] ? registros[i] : o.registros[i];
+        for (size_t f = 0; f < FILAS; ++f) {
+            for (size_t j = 0; j < ANCHO; ++j) {
+                unsigned s = contadores[f][j] + o.contadores[f][j];
+                contadores[f][j] = s < contadores[f][j] ? 0xFFFFFFFFu : s;
+            }
+        }
+        total += o.total;
+    }
+
+    /**
+     * @brief Estimación HyperLogLog con conteo lineal para cardinalidades
+     *        bajas.
+     */
+    double distintos() const {
+        size_t histograma[66] = { 0 };
+        for (size_t i = 0; i < REGISTROS; ++i) histograma[registros[i]]++;
+        double suma = 0.0, potencia = 1.0;
+        for (int r = 0; r < 66; ++r, potencia *= 0.5) suma += (double)histograma[r] * potencia;
+        double m = (double)REGISTROS;
+        double e = 0.7213 / (1.0 + 1.079 / m) * m * m / suma;
+        if (e <= 2.5 * m && histograma[0]) e = m * std::log(m / (double)histograma[0]);
+        return e;
+    }
+
+    /**
+     * @brief Cota superior de cuántas veces apareció el valor v.
+     */
+    unsigned long long frecuencia(double v) const {
+        unsigned long long g = mezclar64(claveDe(v) ^ 0x9e3779b97f4a7c15ULL);
+        unsigned h1 = (unsigned)g, h2 = (unsigned)(g >> 32) | 1u;
+        unsigned menor = 0xFFFFFFFFu;
+        for (size_t f = 0; f < FILAS; ++f) {
+            unsigned c = contadores[f][(h1 + (unsigned)f * h2) & (ANCHO - 1)];
+            if (c < menor) menor = c;
+        }
+        return menor;
+    }
+
+    /// Exceso máximo (con probabilidad >= 98%) de frecuencia().
+    double errorFrecuencia() const { return 2.718281828 / (double)ANCHO * (double)total; }
+
+    void imprimir() const {
+        printf("    Boceto: %llu lecturas, ~%.0f valores distintos (HLL, %zu bytes)\n", total, distintos(),
+               sizeof(BocetoSensor));
+    }
+};
+
+/* ============================================================
+ *     Supresión de retransmisiones por número de secuencia
+ * ============================================================*/
+
+/**
+ * @brief Ventana deslizante de ANCHO números de secuencia en un bitmap.
+ * @details registrar() es O(1) salvo el borrado de las posiciones que
+ *          entran a la ventana al avanzar, que se amortiza en las lecturas
+ *          que la hicieron avanzar. Una secuencia:
+ *          - mayor que todas: avanza la ventana y se acepta;
+ *          - dentro de la ventana: se acepta si su bit está libre
+ *            (llegó desordenada) o se descarta como duplicada;
+ *          - más vieja que la ventana: se descarta como tardía, salvo que
+ *            esté REINICIO posiciones atrás, que se toma como reinicio del
+ *            puente y reabre la ventana.
+ *          Huecos = secuencias del rango visto que nunca llegaron.
+ */
+struct VentanaSecuencia {
+    static const unsigned ANCHO = 256;
+    static const unsigned long long REINICIO = 4 * ANCHO;
+
+    enum Resultado { NUEVA, DUPLICADA, TARDIA };
+
+    unsigned long long bits[ANCHO / 64];
+    unsigned long long mayor, menor;  ///< Rango aceptado desde el último reinicio
+    unsigned long long aceptadasRango;
+    unsigned long long aceptadas, duplicadas, tardias, desordenadas, reinicios;
+    unsigned long long huecosPrevios; ///< Huecos de los rangos anteriores a un reinicio
+    bool iniciada;
+
+    VentanaSecuencia()
+        : mayor(0), menor(0), aceptadasRango(0), aceptadas(0), duplicadas(0), tardias(0),
+          desordenadas(0), reinicios(0), huecosPrevios(0), iniciada(false) {
+        std::memset(bits, 0, sizeof(bits));
+    }
+
+    /**
+     * @brief Lo que devolvería registrar(seq), sin marcarla ni contarla.
+     */
+    Resultado consultar(unsigned long long seq) const {
+        if (!iniciada || seq > mayor || mayor - seq >= REINICIO) return NUEVA;
+        if (mayor - seq >= ANCHO) return TARDIA;
+        return (bits[(seq % ANCHO) / 64] & (1ULL << (seq % 64))) ? DUPLICADA : NUEVA;
+    }
+
+    Resultado registrar(unsigned long long seq) {
+        if (iniciada && seq < mayor && mayor - seq >= REINICIO) {
+            huecosPrevios += huecosRango();
+            reinicios++;
+            iniciada = false;
+        }
+        if (!iniciada) {
+            std::memset(bits, 0, sizeof(bits));
+            iniciada = true;
+            mayor = menor = seq;
+            aceptadasRango = 0;
+        } else if (seq > mayor) {
+            unsigned long long d = seq - mayor;
+            if (d >= ANCHO) {
+                std::memset(bits, 0, sizeof(bits));
+            } else {
+                for (unsigned long long s = mayor + 1; s <= seq; ++s) bits[(s % ANCHO) / 64] &= ~(1ULL << (s % 64));
+            }
+            mayor = seq;
+        } else if (mayor - seq >= ANCHO) {
+            tardias++;
+            return TARDIA;
+        } else if (bits[(seq % ANCHO) / 64] & (1ULL << (seq % 64))) {
+            duplicadas++;
+            return DUPLICADA;
+        } else {
+            desordenadas++;
+            if (seq < menor) menor = seq;
+        }
+        bits[(seq % ANCHO) / 64] |= 1ULL << (seq % 64);
+        aceptadasRango++;
+        aceptadas++;
+        return NUEVA;
+    }
+
+    unsigned long long huecosRango() const {
+        return iniciada ? (mayor - menor + 1) - aceptadasRango : 0;
+    }
+
+    unsigned long long huecos() const { return huecosPrevios + huecosRango(); }
+
+    void imprimir() const {
+        printf("    Secuencia: ultima %llu | aceptadas %llu | duplicadas %llu | tardias %llu | "
+               "desordenadas %llu | huecos %llu | reinicios %llu\n",
+               mayor, aceptadas, duplicadas, tardias, desordenadas, huecos(), reinicios);
+    }
+};
+
+/* ============================================================
+ *       Pronóstico incremental (Holt-Winters aditivo)
+ * ============================================================*/
+
+/**
+ * @brief Suavizado exponencial doble/triple incremental por sensor.
+ * @details Con periodo 0 es Holt (nivel + tendencia); con periodo > 0 agrega
+ *          una componente estacional aditiva de ese largo. actualizar() es
+ *          O(1) y el estado ocupa sizeof(PronosticoHolt) (256 bytes en x86-64).
+ *          La varianza del error a un paso se sigue con un EWMA y da las
+ *          bandas de confianza del pronóstico.
+ */
+struct PronosticoHolt {
+    static const int MAX_PERIODO = 24;
+
+    double alpha;   ///< Peso del nivel
+    double beta;    ///< Peso de la tendencia
+    double gamma;   ///< Peso de la estación
+    int periodo;    ///< 0 = sin estacionalidad
+    int idx;        ///< Posición estacional de la próxima lectura
+    size_t n;       ///< Lecturas incorporadas
+    double nivel;
+    double tendencia;
+    double varError; ///< Varianza (EWMA) del error de pronóstico a un paso
+    double estacion[MAX_PERIODO];
+
+    PronosticoHolt(double a = 0.5, double b = 0.1, double g = 0.1, int m = 0)
+        : alpha(acotar(a)), beta(acotar(b)), gamma(acotar(g)),
+          periodo((m > 0 && m <= MAX_PERIODO) ? m : 0), idx(0), n(0),
+          nivel(0.0), tendencia(0.0), varError(0.0) {
+        for (int i = 0; i < MAX_PERIODO; ++i) estacion[i] = 0.0;
+    }
+
+    /**
+     * @brief Incorpora una lectura en O(1).
+     */
+    void actualizar(double x) {
+        if (n == 0) {
+            nivel = x;
+            n = 1;
+            avanzar();
+            return;
+        }
+        double s = periodo ? estacion[idx] : 0.0;
+        double err = x - (nivel + tendencia + s);
+        varError = (n == 1) ? err * err : (1.0 - alpha) * varError + alpha * err * err;
+
+        double nivelPrev = nivel;
+        nivel = alpha * (x - s) + (1.0 - alpha) * (nivel + tendencia);
+        tendencia = beta * (nivel - nivelPrev) + (1.0 - beta) * tendencia;
+        if (periodo) estacion[idx] = gamma * (x - nivel) + (1.0 - gamma) * s;
+        n++;
+        avanzar();
+    }
+
+    /**
+     * @brief Pronostica los próximos k valores con banda de confianza del 95%.
+     * @param k Horizonte (número de pasos)
+     * @param media Arreglo de k valores pronosticados
+     * @param inf,sup Arreglos de k límites inferior/superior (pueden ser NULL)
+     * @return false si aún no hay lecturas.
+     */
+    bool pronosticar(int k, double* media, double* inf, double* sup) const {
+        if (n == 0 || k <= 0 || !media) return false;
+        double acum = 0.0; // suma de coeficientes psi_j^2 (Holt lineal)
+        for (int h = 1; h <= k; ++h) {
+            double s = periodo ? estacion[(idx + h - 1) % periodo] : 0.0;
+            double m = nivel + (double)h * tendencia + s;
+            media[h - 1] = m;
+            if (h > 1) {
+                double psi = alpha * (1.0 + (double)(h - 1) * beta);
+                acum += psi * psi;
+            }
+            double d = 1.96 * std::sqrt(varError * (1.0 + acum));
+            if (inf) inf[h - 1] = m - d;
+            if (sup) sup[h - 1] = m + d;
+        }
+        return true;
+    }
+
+private:
+    void avanzar() {
+        if (periodo) idx = (idx + 1) % periodo;
+    }
+
+    static double acotar(double v) {
+        if (v <= 0.0) return 0.01;
+        if (v > 1.0) return 1.0;
+        return v;
+    }
+};
+
+/* ============================================================
+ *          Calidad de datos en la ingesta
+ * ============================================================*/
+
+/**
+ * @brief Etapa de calidad con estado O(1) por sensor.
+ * @details Detecta valores pegados (racha de lecturas idénticas), huecos de
+ *          llegada (intervalo muy superior al medio, estadística de Welford)
+ *          y picos (desvío > UMBRAL_PICO sigmas de un EWMA). Cada lectura
+ *          recibe un byte de banderas que se guarda en su nodo.
+ */
+struct CalidadDatos {
+    enum Bandera {
+        REPETIDO = 1 << 0, ///< Forma parte de una racha de valores idénticos
+        HUECO    = 1 << 1, ///< Llegó tras un intervalo anómalamente largo
+        PICO     = 1 << 2  ///< Se aleja demasiado de la media móvil
+    };
+
+    static const size_t UMBRAL_REPETIDO = 5;  ///< Lecturas iguales seguidas
+    static const size_t MIN_MUESTRAS = 8;     ///< Antes de esto no se marca
+    static const double FACTOR_HUECO;         ///< Veces el intervalo medio
+    static const double UMBRAL_PICO;          ///< Sigmas respecto del EWMA
+    static const double ALPHA_PICO;
+
+    size_t lecturas;
+    double ultimoValor;
+    size_t racha;         ///< Lecturas idénticas consecutivas (actual)
+    size_t rachaMax;
+    size_t repetidas;     ///< Lecturas marcadas REPETIDO
+    size_t huecos;
+    size_t picos;
+    unsigned long long ultimaLlegadaNs;
+    double mediaLlegada;  ///< Intervalo medio entre lecturas (ns, Welford)
+    double m2Llegada;
+    double mediaValor;    ///< EWMA del valor
+    double varValor;      ///< EWMA de la varianza
+
+    CalidadDatos()
+        : lecturas(0), ultimoValor(0.0), racha(0), rachaMax(0), repetidas(0),
+          huecos(0), picos(0), ultimaLlegadaNs(0), mediaLlegada(0.0),
+          m2Llegada(0.0), mediaValor(0.0), varValor(0.0) {}
+
+    /**
+     * @brief Evalúa una lectura y devuelve sus banderas.
+     */
+    unsigned char evaluar(double x, unsigned long long ahoraNs) {
+        unsigned char b = 0;
+
+        if (lecturas > 0 && x == ultimoValor) racha++;
+        else racha = 1;
+        if (racha > rachaMax) rachaMax = racha;
+        if (racha >= UMBRAL_REPETIDO) { b |= REPETIDO; repetidas++; }
+
+        if (lecturas > 0) {
+            double dt = (double)(ahoraNs - ultimaLlegadaNs);
+            size_t k = lecturas; // número de intervalos tras este
+            if (k > MIN_MUESTRAS && dt > FACTOR_HUECO * mediaLlegada) { b |= HUECO; huecos++; }
+            double d = dt - mediaLlegada;
+            mediaLlegada += d / (double)k;
+            m2Llegada += d * (dt - mediaLlegada);
+
+            double dv = x - mediaValor;
+            if (lecturas >= MIN_MUESTRAS && dv * dv > UMBRAL_PICO * UMBRAL_PICO * varValor
+                && varValor > 0.0) {
+                b |= PICO;
+                picos++;
+            }
+            mediaValor += ALPHA_PICO * dv;
+            varValor = (1.0 - ALPHA_PICO) * (varValor + ALPHA_PICO * dv * dv);
+        } else {
+            mediaValor = x;
+        }
+
+        ultimoValor = x;
+        ultimaLlegadaNs = ahoraNs;
+        lecturas++;
+        return b;
+    }
+
+    double desvioLlegada() const {
+        return lecturas > 2 ? std::sqrt(m2Llegada / (double)(lecturas - 2)) : 0.0;
+    }
+
+    void imprimir() const {
+        printf("    Calidad: %zu lecturas | racha igual %zu (max %zu) | repetidas %zu | "
+               "huecos %zu | picos %zu | llegada media %.1f ms (desv %.1f ms)\n",
+               lecturas, racha, rachaMax, repetidas, huecos, picos,
+               mediaLlegada / 1e6, desvioLlegada() / 1e6);
+    }
+};
+
+const double CalidadDatos::FACTOR_HUECO = 3.0;
+const double CalidadDatos::UMBRAL_PICO = 4.0;
+const double CalidadDatos::ALPHA_PICO = 0.1;
+
+/* ============================================================
+ *      Presupuesto de memoria y desborde a disco
+ * ============================================================*/
+
+/**
+ * @brief Archivo de desborde para historiales fríos y su contabilidad.
+ * @details Cada historial desalojado ocupa una extensión contigua. Al volver
+ *          a memoria o descartarse, su extensión pasa a una lista de huecos
+ *          ordenada por offset (fusionando vecinos) que las escrituras
+ *          siguientes reutilizan con primer ajuste; un hueco al final acorta
+ *          el archivo. Así el archivo no crece sin límite con ciclos de
+ *          desalojo y carga, y se rebobina cuando no queda nada desbordado.
+ *          Mientras un hijo de fork() copia extensiones con pread() el
+ *          almacén está congelado: lo liberado se difiere hasta que termina.
+ */
+class AlmacenDesborde {
+private:
+    struct Hueco {
+        long offset;
+        size_t bytes;
+    };
+
+    FILE* archivo;
+    size_t presupuesto;       ///< 0 = sin límite
+    size_t bytesDesbordados;  ///< Bytes vivos en el archivo
+    size_t desalojos;
+    size_t cargas;
+    size_t reutilizados;      ///< Escrituras ubicadas en un hueco
+    long fin;                 ///< Fin lógico del archivo
+    Hueco* huecos;            ///< Ordenados por offset, sin vecinos contiguos
+    size_t nHuecos;
+    size_t capHuecos;
+    Hueco* diferidos;         ///< Liberados durante un congelamiento
+    size_t nDiferidos;
+    size_t capDiferidos;
+    bool congelado;
+    HistogramaLatencia latenciaCarga;
+
+    AlmacenDesborde(const AlmacenDesborde&);
+    AlmacenDesborde& operator=(const AlmacenDesborde&);
+
+    /// Vacía el archivo cuando ya no queda nada desbordado.
+    void rebobinar() {
+        std::fflush(archivo);
+        if (std::freopen(NULL, "w+b", archivo) == NULL) archivo = std::tmpfile();
+        fin = 0;
+        nHuecos = 0;
+    }
+
+    /// Devuelve una extensión a la lista de huecos, fusionándola con sus vecinos.
+    void liberar(long offset, size_t bytes) {
+        if (bytes == 0) return;
+        size_t i = 0;
+        while (i < nHuecos && huecos[i].offset < offset) ++i;
+        bool conPrevio = i > 0 && huecos[i - 1].offset + (long)huecos[i - 1].bytes == offset;
+        bool conSiguiente = i < nHuecos && offset + (long)bytes == huecos[i].offset;
+        if (conPrevio && conSiguiente) {
+            huecos[i - 1].bytes += bytes + huecos[i].bytes;
+            for (size_t j = i; j + 1 < nHuecos; ++j) huecos[j] = huecos[j + 1];
+            nHuecos--;
+        } else if (conPrevio) {
+            huecos[i - 1].bytes += bytes;
+        } else if (conSiguiente) {
+            huecos[i].offset = offset;
+            huecos[i].bytes += bytes;
+        } else {
+            if (nHuecos == capHuecos) {
+                size_t nuevaCap = capHuecos ? capHuecos * 2 : 16;
+                Hueco* nuevo = new Hueco[nuevaCap];
+                for (size_t j = 0; j < nHuecos; ++j) nuevo[j] = huecos[j];
+                delete[] huecos;
+                huecos = nuevo;
+                capHuecos = nuevaCap;
+            }
+            for (size_t j = nHuecos; j > i; --j) huecos[j] = huecos[j - 1];
+            huecos[i].offset = offset;
+            huecos[i].bytes = bytes;
+            nHuecos++;
+        }
+        // Un hueco final no es un hueco: el archivo se acorta.
+        if (nHuecos && huecos[nHuecos - 1].offset + (long)huecos[nHuecos - 1].bytes == fin) {
+            fin = huecos[--nHuecos].offset;
+            if (ftruncate(fileno(archivo), (off_t)fin) != 0) { /* solo espacio en disco */ }
+        }
+    }
+
+public:
+    AlmacenDesborde()
+        : archivo(NULL), presupuesto(0), bytesDesbordados(0), desalojos(0), cargas(0),
+          reutilizados(0), fin(0), huecos(NULL), nHuecos(0), capHuecos(0), diferidos(NULL),
+          nDiferidos(0), capDiferidos(0), congelado(false) {}
+    ~AlmacenDesborde() {
+        if (archivo) std::fclose(archivo);
+        delete[] huecos;
+        delete[] diferidos;
+    }
+
+    /// Un hijo de fork() va a leer extensiones: no reutilizar lo que se libere.
+    void congelar() { congelado = true; }
+
+    /// El hijo terminó: lo liberado mientras tanto pasa a ser reutilizable.
+    void descongelar() {
+        if (!congelado) return;
+        congelado = false;
+        size_t n = nDiferidos;
+        nDiferidos = 0;
+        if (bytesDesbordados == 0) {
+            rebobinar();
+            return;
+        }
+        for (size_t i = 0; i < n; ++i) liberar(diferidos[i].offset, diferidos[i].bytes);
+    }
+
+    /**
+     * @brief Fija el presupuesto; abre el archivo (ruta o temporal) si hace falta.
+     */
+    bool configurar(size_t bytes, const char* ruta = NULL) {
+        presupuesto = bytes;
+        if (archivo || bytes == 0) return true;
+        archivo = ruta ? std::fopen(ruta, "w+b") : std::tmpfile();
+        if (!archivo) {
+            printf("[Memoria] No se pudo abrir el archivo de desborde.\n");
+            presupuesto = 0;
+            return false;
+        }
+        return true;
+    }
+
+    size_t getPresupuesto() const { return presupuesto; }
+    bool excedido() const { return presupuesto && bytesNodosResidentes() > presupuesto; }
+    size_t getBytesDesbordados() const { return bytesDesbordados; }
+
+    size_t getBytesArchivo() const { return (size_t)fin; }
+
+    /**
+     * @brief Reserva una extensión de `bytes` (primer hueco que alcance o el
+     *        final) y posiciona el archivo en ella; devuelve su offset.
+     */
+    long abrirEscritura(size_t bytes) {
+        if (!archivo) return -1;
+        long off = fin;
+        size_t i = 0;
+        while (i < nHuecos && huecos[i].bytes < bytes) ++i;
+        if (i < nHuecos) {
+            off = huecos[i].offset;
+            huecos[i].offset += (long)bytes;
+            huecos[i].bytes -= bytes;
+            if (huecos[i].bytes == 0) {
+                for (size_t j = i; j + 1 < nHuecos; ++j) huecos[j] = huecos[j + 1];
+                nHuecos--;
+            }
+            reutilizados++;
+        } else {
+            fin += (long)bytes;
+        }
+        if (std::fseek(archivo, off, SEEK_SET) != 0) {
+            liberar(off, bytes);
+            return -1;
+        }
+        return off;
+    }
+
+    /// Confirma la extensión reservada por abrirEscritura().
+    void cerrarEscritura(size_t bytes) {
+        std::fflush(archivo);
+        bytesDesbordados += bytes;
+        desalojos++;
+    }
+
+    /// Devuelve una extensión reservada que no llegó a usarse.
+    void cancelarEscritura(long offset, size_t bytes) { liberar(offset, bytes); }
+
+    FILE* abrirLectura(long offset) {
+        if (!archivo || std::fseek(archivo, offset, SEEK_SET) != 0) return NULL;
+        return archivo;
+    }
+
+    void cerrarLectura(long offset, size_t bytes, unsigned long long latenciaNs) {
+        cargas++;
+        latenciaCarga.registrar(latenciaNs);
+        descartar(offset, bytes);
+    }
+
+    /**
+     * @brief Copia bytes crudos del archivo a `out` sin mover su offset
+     *        (pread), seguro en un hijo de fork() que comparte el descriptor.
+     */
+    bool copiarCrudo(long offset, size_t bytes, FILE* out) const {
+        if (!archivo) return false;
+        int fd = fileno(archivo);
+        char buf[4096];
+        while (bytes > 0) {
+            size_t m = bytes < sizeof(buf) ? bytes : sizeof(buf);
+            ssize_t r = pread(fd, buf, m, (off_t)offset);
+            if (r <= 0) return false;
+            if (std::fwrite(buf, 1, (size_t)r, out) != (size_t)r) return false;
+            offset += r;
+            bytes -= (size_t)r;
+        }
+        return true;
+    }
+
+    /// Un historial desalojado se descarta sin volver a memoria.
+    void descartar(long offset, size_t bytes) {
+        bytesDesbordados -= bytes;
+        if (!archivo) return;
+        if (congelado) {
+            if (nDiferidos == capDiferidos) {
+                size_t nuevaCap = capDiferidos ? capDiferidos * 2 : 16;
+                Hueco* nuevo = new Hueco[nuevaCap];
+                for (size_t j = 0; j < nDiferidos; ++j) nuevo[j] = diferidos[j];
+                delete[] diferidos;
+                diferidos = nuevo;
+                capDiferidos = nuevaCap;
+            }
+            diferidos[nDiferidos].offset = offset;
+            diferidos[nDiferidos].bytes = bytes;
+            nDiferidos++;
+            return;
+        }
+        if (bytesDesbordados == 0) rebobinar();
+        else liberar(offset, bytes);
+    }
+
+    void imprimirReporte() const {
+        printf("\n--- Memoria de historiales ---\n");
+        if (presupuesto) printf("  Presupuesto: %zu bytes\n", presupuesto);
+        else             printf("  Presupuesto: sin limite\n");
+        printf("  Residentes: %zu bytes | Desbordados: %zu bytes en disco\n",
+               bytesNodosResidentes(), bytesDesbordados);
+        printf("  Desalojos: %zu | Cargas desde disco: %zu\n", desalojos, cargas);
+        printf("  Archivo: %ld bytes | Huecos libres: %zu | Escrituras en huecos: %zu\n",
+               fin, nHuecos, reutilizados);
+        latenciaCarga.imprimir("Latencia de carga:");
+    }
+};
+
+/* ============================================================
+ *   Almacenamiento persistente mapeado en memoria (mmap)
+ * ============================================================*/
+
+/// Tipos concretos de sensor (para persistencia y reconstrucción).
+enum TipoSensor {
+    TIPO_TEMPERATURA = 1,
+    TIPO_PRESION = 2
+};
+
+/**
+ * @brief Archivo mapeado con la tabla de sensores y sus lecturas enlazadas
+ *        por offsets (no punteros), válido en cualquier dirección de mapeo.
+ * @details Diseño: [Cabecera][Entrada x capacidad][Registro ...]. Cada
+ *          lectura es un registro de 32 bytes con el offset del siguiente y
+ *          una suma de verificación; las eliminaciones (pop_min) son lápidas
+ *          que se ubican en O(1) con un índice en memoria por (sensor, valor)
+ *          y se compactan reescribiendo el archivo cuando superan a las
+ *          vivas. La cabecera marca `abierto` de forma durable antes de
+ *          escribir y cerrar() lo limpia tras msync(): un arranque limpio no
+ *          recorre nada; tras un corte, abrir() valida cada cadena y la corta
+ *          en el primer registro roto (p. ej. una página que el núcleo no
+ *          llegó a escribir aunque su enlace sí), en O(registros).
+ *          Alcance: es una copia de escritura directa, no el historial en
+ *          sí. Tras reiniciar, los recorridos de solo lectura leen los
+ *          registros en su lugar, pero el primer acceso que necesita la
+ *          ListaSensor (consulta, mutación, instantánea) la reconstruye en
+ *          O(n) y desde ahí cada lectura vive dos veces: en el heap y aquí.
+ */
+class AlmacenMapeado {
+public:
+    static const unsigned VERSION = 3;
+    static const unsigned char BORRADO = 0x80; ///< Bit de lápida en banderas
+    static const unsigned long long MIN_COMPACTAR = 4096; ///< Lápidas mínimas para compactar
+
+    struct Cabecera {
+        char magia[8];
+        unsigned version;
+        unsigned capacidad;          ///< Entradas reservadas en la tabla
+        unsigned sensores;           ///< Entradas confirmadas
+        unsigned abierto;            ///< 1 mientras un proceso lo usa (0 = cierre limpio)
+        unsigned long long usado;    ///< Próximo offset libre de registros
+        unsigned long long reparaciones;
+        unsigned long long muertos;  ///< Registros con lápida o huérfanos
+        char reservado[16];
+    };
+
+    struct Entrada {
+        char nombre[50];
+        unsigned char tipo;
+        unsigned char reservado;
+        unsigned vivas;              ///< Lecturas vivas
+        unsigned long long cabeza;   ///< Offset del primer registro (0 = vacía)
+        unsigned long long cola;
+    };
+
+    struct Registro {
+        unsigned char valor[4];      ///< float o int, según el tipo del sensor
+        unsigned char banderas;
+        unsigned char reservado[3];
+        unsigned suma;               ///< Verificación de valor, marca y offset
+        unsigned reservado2;
+        unsigned long long siguiente;
+        long long marcaMs;
+    };
+
+private:
+    /// Lecturas vivas de un sensor con el mismo valor, en orden de llegada.
+    struct ColaIgual {
+        unsigned long long clave;    ///< (índice + 1) << 32 | bits del valor; 0 = libre
+        unsigned long long primero;
+        unsigned long long ultimo;
+    };
+
+    int fd;
+    unsigned char* base;
+    unsigned long long tamano;
+    char ruta[256];
+    bool trasCorte;              ///< La última apertura encontró un cierre no limpio
+    size_t compactaciones;
+
+    // Índice de lápidas (solo en memoria; se arma por sensor al primer borrado).
+    ColaIgual* colas;
+    size_t capColas;
+    size_t usadasColas;
+    unsigned* enlaces;           ///< Por ranura: ranura siguiente + 1 con igual valor
+    size_t capEnlaces;
+    bool* indexada;              ///< Por entrada
+
+    AlmacenMapeado(const AlmacenMapeado&);
+    AlmacenMapeado& operator=(const AlmacenMapeado&);
+
+    Cabecera* cab() const { return (Cabecera*)base; }
+    Entrada* entradas() const { return (Entrada*)(base + sizeof(Cabecera)); }
+
+    unsigned long long inicioRegistros(unsigned capacidad) const {
+        unsigned long long f = sizeof(Cabecera) + (unsigned long long)capacidad * sizeof(Entrada);
+        return (f + 15) & ~15ULL;
+    }
+
+    bool offsetValido(unsigned long long off) const {
+        return off >= inicioRegistros(cab()->capacidad) && off + sizeof(Registro) <= cab()->usado &&
+               off + sizeof(Registro) <= tamano &&
+               (off - inicioRegistros(cab()->capacidad)) % sizeof(Registro) == 0;
+    }
+
+    size_t ranura(unsigned long long off) const {
+        return (size_t)((off - inicioRegistros(cab()->capacidad)) / sizeof(Registro));
+    }
+
+    unsigned long long registrosTotales() const {
+        return (cab()->usado - inicioRegistros(cab()->capacidad)) / sizeof(Registro);
+    }
+
+    static unsigned sumaRegistro(const Registro* r, unsigned long long off) {
+        unsigned v;
+        std::memcpy(&v, r->valor, sizeof(v));
+        unsigned long long h = mezclar64(((unsigned long long)v << 8 | (r->banderas & ~BORRADO)) ^
+                                         mezclar64((unsigned long long)r->marcaMs ^ off));
+        return (unsigned)(h ^ (h >> 32));
+    }
+
+    bool mapear(unsigned long long bytes) {
+        void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return false;
+        base = (unsigned char*)p;
+        tamano = bytes;
+        return true;
+    }
+
+    bool crecer(unsigned long long minimo) {
+        unsigned long long nuevo = tamano;
+        while (nuevo < minimo) nuevo *= 2;
+        if (ftruncate(fd, (off_t)nuevo) != 0) return false;
+        munmap(base, tamano);
+        base = NULL;
+        return mapear(nuevo);
+    }
+
+    static void barrera() { __sync_synchronize(); }
+
+    /// msync() síncrono de [desde, desde+bytes), alineado a página.
+    void sincronizar(unsigned long long desde, unsigned long long bytes) const {
+        unsigned long long pagina = (unsigned long long)sysconf(_SC_PAGESIZE);
+        unsigned long long ini = desde & ~(pagina - 1);
+        msync(base + ini, (size_t)(desde + bytes - ini), MS_SYNC);
+    }
+
+    void olvidarIndice() {
+        delete[] colas;
+        delete[] enlaces;
+        delete[] indexada;
+        colas = NULL;
+        enlaces = NULL;
+        indexada = NULL;
+        capColas = usadasColas = capEnlaces = 0;
+    }
+
+    ColaIgual* buscarCola(unsigned idx, const void* valor, bool crear) {
+        unsigned v;
+        std::memcpy(&v, valor, sizeof(v));
+        unsigned long long clave = ((unsigned long long)idx + 1) << 32 | v;
+        if (crear && (usadasColas + 1) * 2 > capColas) {
+            size_t nuevaCap = capColas ? capColas * 2 : 1024;
+            ColaIgual* nuevo = new ColaIgual[nuevaCap];
+            std::memset(nuevo, 0, nuevaCap * sizeof(ColaIgual));
+            for (size_t i = 0; i < capColas; ++i) {
+                if (!colas[i].clave) continue;
+                size_t j = (size_t)mezclar64(colas[i].clave) & (nuevaCap - 1);
+                while (nuevo[j].clave) j = (j + 1) & (nuevaCap - 1);
+                nuevo[j] = colas[i];
+            }
+            delete[] colas;
+            colas = nuevo;
+            capColas = nuevaCap;
+        }
+        if (capColas == 0) return NULL;
+        size_t j = (size_t)mezclar64(clave) & (capColas - 1);
+        while (colas[j].clave && colas[j].clave != clave) j = (j + 1) & (capColas - 1);
+        if (colas[j].clave) return &colas[j];
+        if (!crear) return NULL;
+        colas[j].clave = clave;
+        colas[j].primero = colas[j].ultimo = 0;
+        usadasColas++;
+        return &colas[j];
+    }
+
+    void encolarIgual(unsigned idx, unsigned long long off) {
+        size_t r = ranura(off);
+        if (r >= capEnlaces) {
+            size_t nuevaCap = capEnlaces ? capEnlaces : 4096;
+            while (nuevaCap <= r) nuevaCap *= 2;
+            unsigned* nuevo = new unsigned[nuevaCap];
+            for (size_t i = 0; i < capEnlaces; ++i) nuevo[i] = enlaces[i];
+            delete[] enlaces;
+            enlaces = nuevo;
+            capEnlaces = nuevaCap;
+        }
+        enlaces[r] = 0;
+        ColaIgual* c = buscarCola(idx, ((const Registro*)(base + off))->valor, true);
+        if (c->ultimo) enlaces[ranura(c->ultimo)] = (unsigned)(r + 1);
+        else c->primero = off;
+        c->ultimo = off;
+    }
+
+    /// Arma el índice de lápidas de un sensor recorriendo su cadena una vez.
+    void indexar(unsigned idx) {
+        if (!indexada) {
+            indexada = new bool[cab()->capacidad];
+            std::memset(indexada, 0, cab()->capacidad);
+        }
+        for (unsigned long long off = entradas()[idx].cabeza; off && offsetValido(off);) {
+            const Registro* r = (const Registro*)(base + off);
+            if (!(r->banderas & BORRADO)) encolarIgual(idx, off);
+            off = r->siguiente;
+        }
+        indexada[idx] = true;
+    }
+
+    /**
+     * @brief Validación completa tras un cierre no limpio (O(registros)).
+     * @details Corta cada cadena en el primer enlace fuera de rango o
+     *          registro con suma inválida, recalcula vivas/cola y cuenta como
+     *          muertos los registros que quedan fuera de toda cadena.
+     */
+    size_t recuperar() {
+        size_t reparadas = 0;
+        unsigned long long vivas = 0;
+        for (unsigned i = 0; i < cab()->sensores; ++i) {
+            Entrada& e = entradas()[i];
+            e.nombre[sizeof(e.nombre) - 1] = '\0';
+            unsigned long long previo = 0;
+            unsigned cuenta = 0;
+            unsigned long long off = e.cabeza;
+            while (off) {
+                const Registro* r = (const Registro*)(base + off);
+                if (!offsetValido(off) || r->suma != sumaRegistro(r, off)) {
+                    if (previo) ((Registro*)(base + previo))->siguiente = 0;
+                    else e.cabeza = 0;
+                    reparadas++;
+                    break;
+                }
+                if (!(r->banderas & BORRADO)) cuenta++;
+                previo = off;
+                off = r->siguiente;
+            }
+            if (e.cola != previo || e.vivas != cuenta) reparadas++;
+            e.cola = previo;
+            e.vivas = cuenta;
+            vivas += cuenta;
+        }
+        cab()->muertos = registrosTotales() - vivas;
+        return reparadas;
+    }
+
+public:
+    AlmacenMapeado()
+        : fd(-1), base(NULL), tamano(0), trasCorte(false), compactaciones(0), colas(NULL),
+          capColas(0), usadasColas(0), enlaces(NULL), capEnlaces(0), indexada(NULL) {
+        ruta[0] = '\0';
+    }
+    ~AlmacenMapeado() { cerrar(); }
+
+    bool abierto() const { return base != NULL; }
+    bool recuperadoTrasCorte() const { return trasCorte; }
+    size_t getCompactaciones() const { return compactaciones; }
+    unsigned numSensores() const { return base ? cab()->sensores : 0; }
+    const Entrada& entrada(unsigned i) const { return entradas()[i]; }
+    const Registro* registro(unsigned long long off) const {
+        return offsetValido(off) ? (const Registro*)(base + off) : NULL;
+    }
+    unsigned long long bytesArchivo() const { return tamano; }
+    unsigned long long lapidas() const { return base ? cab()->muertos : 0; }
+
+    /**
+     * @brief Abre (o crea) el archivo; si el anterior proceso no lo cerró
+     *        limpio, valida y repara todas las cadenas.
+     * @param capacidad Entradas de la tabla si el archivo es nuevo
+     * @param reparadas Cadenas cortadas o entradas corregidas
+     */
+    bool abrir(const char* rutaArchivo, unsigned capacidad, size_t& reparadas) {
+        reparadas = 0;
+        cerrar();
+        fd = open(rutaArchivo, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) return false;
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+            printf("[Persistencia] %s esta en uso por otro proceso.\n", rutaArchivo);
+            cerrar();
+            return false;
+        }
+        std::snprintf(ruta, sizeof(ruta), "%s", rutaArchivo);
+        struct stat st;
+        if (fstat(fd, &st) != 0) { cerrar(); return false; }
+
+        trasCorte = false;
+        if (st.st_size == 0) {
+            if (capacidad == 0) capacidad = 1024;
+            unsigned long long ini = inicioRegistros(capacidad);
+            unsigned long long bytes = ini + (1ULL << 20);
+            if (ftruncate(fd, (off_t)bytes) != 0 || !mapear(bytes)) { cerrar(); return false; }
+            Cabecera* c = cab();
+            std::memcpy(c->magia, "IOTMAP1", 8);
+            c->version = VERSION;
+            c->capacidad = capacidad;
+            c->sensores = 0;
+            c->usado = ini;
+            c->reparaciones = 0;
+            c->muertos = 0;
+        } else {
+            if ((unsigned long long)st.st_size < sizeof(Cabecera) ||
+                !mapear((unsigned long long)st.st_size)) { cerrar(); return false; }
+            Cabecera* c = cab();
+            if (std::memcmp(c->magia, "IOTMAP1", 8) != 0 || c->version != VERSION ||
+                inicioRegistros(c->capacidad) > tamano || c->sensores > c->capacidad) {
+                printf("[Persistencia] Archivo %s invalido o de otra version.\n", rutaArchivo);
+                cerrar();
+                return false;
+            }
+            if (c->usado < inicioRegistros(c->capacidad) || c->usado > tamano) {
+                printf("[Persistencia] Cabecera corrupta en %s.\n", rutaArchivo);
+                cerrar();
+                return false;
+            }
+            if (c->abierto) {
+                // Nadie más lo tiene (flock): el proceso anterior no cerró limpio.
+                trasCorte = true;
+                reparadas = recuperar();
+                c->reparaciones += reparadas;
+            }
+        }
+        // El estado "abierto" se vuelve durable antes de cualquier escritura.
+        cab()->abierto = 1;
+        sincronizar(0, sizeof(Cabecera));
+        return true;
+    }
+
+    void cerrar() {
+        if (base) {
+            msync(base, tamano, MS_SYNC);
+            cab()->abierto = 0;
+            sincronizar(0, sizeof(Cabecera));
+            munmap(base, tamano);
+        }
+        if (fd >= 0) close(fd); // libera el flock
+        base = NULL;
+        fd = -1;
+        tamano = 0;
+        olvidarIndice();
+    }
+
+    /**
+     * @brief Agrega una entrada a la tabla. Devuelve su índice o -1.
+     * @details La entrada se sincroniza antes de confirmar el contador: tras
+     *          un corte nunca se publica una entrada a medio escribir.
+     */
+    long registrar(const char* nombre, unsigned char tipo) {
+        if (!base || cab()->sensores >= cab()->capacidad) return -1;
+        unsigned i = cab()->sensores;
+        Entrada& e = entradas()[i];
+        std::memset(&e, 0, sizeof(e));
+        size_t largo = std::strlen(nombre);
+        if (largo > sizeof(e.nombre) - 1) largo = sizeof(e.nombre) - 1;
+        std::memcpy(e.nombre, nombre, largo);
+        e.nombre[largo] = '\0';
+        e.tipo = tipo;
+        sincronizar((unsigned long long)((unsigned char*)&e - base), sizeof(e));
+        cab()->sensores = i + 1; // confirmación
+        return (long)i;
+    }
+
+    /**
+     * @brief Anexa una lectura (4 bytes crudos) al final de la entrada idx.
+     */
+    bool anexar(unsigned idx, const void* valor, unsigned char banderas, long long marcaMs) {
+        if (!base || idx >= cab()->sensores) return false;
+        unsigned long long off = cab()->usado;
+        if (off + sizeof(Registro) > tamano && !crecer(off + sizeof(Registro))) return false;
+
+        Registro* r = (Registro*)(base + off);
+        std::memcpy(r->valor, valor, sizeof(r->valor));
+        r->banderas = banderas;
+        r->reservado2 = 0;
+        r->siguiente = 0;
+        r->marcaMs = marcaMs;
+        r->suma = sumaRegistro(r, off);
+        barrera();
+        cab()->usado = off + sizeof(Registro);
+        barrera();
+
+        Entrada& e = entradas()[idx];
+        if (e.cola) ((Registro*)(base + e.cola))->siguiente = off;
+        else e.cabeza = off;
+        barrera();
+        e.cola = off;
+        e.vivas++;
+        if (indexada && indexada[idx]) encolarIgual(idx, off);
+        return true;
+    }
+
+    /**
+     * @brief Pone lápida a la primera lectura viva con esos 4 bytes (O(1)
+     *        con el índice del sensor armado); compacta si las lápidas
+     *        superan a las lecturas vivas.
+     */
+    bool marcarBorrado(unsigned idx, const void* valor) {
+        if (!base || idx >= cab()->sensores) return false;
+        if (!indexada || !indexada[idx]) indexar(idx);
+        ColaIgual* c = buscarCola(idx, valor, false);
+        if (!c || !c->primero) return false;
+        unsigned long long off = c->primero;
+        unsigned sig = enlaces[ranura(off)];
+        c->primero = sig ? inicioRegistros(cab()->capacidad) + (unsigned long long)(sig - 1) * sizeof(Registro) : 0;
+        if (!c->primero) c->ultimo = 0;
+
+        ((Registro*)(base + off))->banderas |= BORRADO;
+        Entrada& e = entradas()[idx];
+        if (e.vivas) e.vivas--;
+        cab()->muertos++;
+        unsigned long long muertos = cab()->muertos;
+        if (muertos >= MIN_COMPACTAR && muertos > registrosTotales() - muertos) compactar();
+        return true;
+    }
+
+    /**
+     * @brief Reescribe el archivo solo con las lecturas vivas (agrupadas por
+     *        sensor) en ruta.tmp y lo reemplaza con rename().
+     * @return false si no se pudo; el archivo original queda intacto.
+     */
+    bool compactar() {
+        if (!base) return false;
+        char tmp[300];
+        std::snprintf(tmp, sizeof(tmp), "%s.tmp", ruta);
+        unsigned capacidad = cab()->capacidad;
+        unsigned long long ini = inicioRegistros(capacidad);
+        unsigned long long vivas = registrosTotales() - cab()->muertos;
+        unsigned long long bytes = ini + vivas * sizeof(Registro) + (1ULL << 20);
+
+        int nfd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (nfd < 0) return false;
+        void* p = MAP_FAILED;
+        if (ftruncate(nfd, (off_t)bytes) == 0)
+            p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, nfd, 0);
+        if (p == MAP_FAILED) {
+            close(nfd);
+            unlink(tmp);
+            printf("[Persistencia] No se pudo compactar %s.\n", ruta);
+            return false;
+        }
+        unsigned char* nb = (unsigned char*)p;
+        std::memcpy(nb, base, (size_t)ini);
+        Cabecera* nc = (Cabecera*)nb;
+        Entrada* ne = (Entrada*)(nb + sizeof(Cabecera));
+        unsigned long long pos = ini;
+        for (unsigned i = 0; i < nc->sensores; ++i) {
+            ne[i].cabeza = ne[i].cola = 0;
+            ne[i].vivas = 0;
+            for (unsigned long long off = entradas()[i].cabeza; off && offsetValido(off);) {
+                const Registro* r = (const Registro*)(base + off);
+                off = r->siguiente;
+                if (r->banderas & BORRADO) continue;
+                Registro* w = (Registro*)(nb + pos);
+                *w = *r;
+                w->siguiente = 0;
+                w->suma = sumaRegistro(w, pos);
+                if (ne[i].cola) ((Registro*)(nb + ne[i].cola))->siguiente = pos;
+                else ne[i].cabeza = pos;
+                ne[i].cola = pos;
+                ne[i].vivas++;
+                pos += sizeof(Registro);
+            }
+        }
+        nc->usado = pos;
+        nc->muertos = 0;
+        nc->abierto = 1;
+        bool ok = msync(nb, (size_t)bytes, MS_SYNC) == 0 && flock(nfd, LOCK_EX | LOCK_NB) == 0 &&
+                  std::rename(tmp, ruta) == 0;
+        if (!ok) {
+            munmap(nb, (size_t)bytes);
+            close(nfd);
+            unlink(tmp);
+            printf("[Persistencia] No se pudo compactar %s.\n", ruta);
+            return false;
+        }
+        munmap(base, tamano);
+        close(fd);
+        fd = nfd;
+        base = nb;
+        tamano = bytes;
+        olvidarIndice();
+        compactaciones++;
+        return true;
+    }
+};
+
+/* ============================================================
+ *        Replicación primario -> standby (envío de registros)
+ * ============================================================*/
+
+/// Escribe exactamente `n` bytes en un socket; false si el otro extremo cayó.
+inline bool escribirCompleto(int fd, const void* buf, size_t n) {
+    const char* p = (const char*)buf;
+    while (n > 0) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w <= 0) return false;
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+/// Lee exactamente `n` bytes de un socket; false en EOF o error.
+inline bool leerCompleto(int fd, void* buf, size_t n) {
+    char* p = (char*)buf;
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r <= 0) return false;
+        p += r;
+        n -= (size_t)r;
+    }
+    return true;
+}
+
+/**
+ * @brief Lado primario de la replicación: cada cambio aplicado (alta de
+ *        sensor, lectura, eliminación de la mínima) recibe un LSN y se
+ *        acumula en un lote que se envía por un socket Unix sin esperar la
+ *        confirmación del anterior. El standby confirma el último LSN
+ *        aplicado de cada lote; con eso se mide el retraso de replicación.
+ */
+class ReplicadorPrimario {
+public:
+    enum TipoOperacion { OP_ALTA = 1, OP_LECTURA = 2, OP_CARGA = 3, OP_PROCESADO = 4 };
+
+    /// Encabezado de cada operación; le siguen `bytes` de carga útil.
+    struct Operacion {
+        unsigned long long lsn;
+        unsigned handle;
+        unsigned char op;
+        unsigned char tipo;        ///< TipoSensor (solo OP_ALTA)
+        unsigned short banderas;   ///< Banderas de calidad (solo OP_LECTURA)
+        unsigned bytes;
+        unsigned cnt;              ///< Lecturas en la carga (OP_CARGA)
+    };
+
+    struct Lote {
+        unsigned magia;
+        unsigned bytes;
+        unsigned long long ultimoLsn;
+    };
+
+    static const unsigned MAGIA_LOTE = 0x4C4F5445; // "LOTE"
+    static const size_t MAX_LOTE = 64 * 1024;
+    static const size_t MAX_EN_VUELO = 1024;
+    static const unsigned MAX_HANDLES = 1u << 24;
+
+private:
+    int fdEscucha;
+    int fd;
+    char ruta[108];
+    unsigned char* buffer;         ///< Lote en construcción (sin el encabezado)
+    size_t usado;
+    unsigned long long lsn;
+    unsigned long long lsnEnviado;
+    unsigned long long lsnConfirmado;
+    unsigned long long inicioLote; ///< relojNs() de la primera operación del lote
+
+    struct EnVuelo {
+        unsigned long long lsn;
+        unsigned long long inicio;
+    };
+    EnVuelo enVuelo[MAX_EN_VUELO];
+    size_t vueloCabeza, vueloCola;
+
+    HistogramaLatencia retraso;    ///< Operación anexada -> confirmada por el standby
+    unsigned long long nsCosto;    ///< Tiempo del primario dentro de la replicación
+    unsigned long long lotes;
+    unsigned long long bytesEnviados;
+
+    ReplicadorPrimario(const ReplicadorPrimario&);
+    ReplicadorPrimario& operator=(const ReplicadorPrimario&);
+
+    void drenarConfirmaciones(bool esperar) {
+        unsigned long long ack;
+        while (fd >= 0) {
+            ssize_t r = recv(fd, &ack, sizeof(ack), esperar ? 0 : MSG_DONTWAIT);
+            if (r < 0 && !esperar && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+            if (r <= 0 || !leerCompleto(fd, (char*)&ack + r, sizeof(ack) - (size_t)r)) {
+                desconectar();
+                return;
+            }
+            if (ack > lsnConfirmado) lsnConfirmado = ack;
+            unsigned long long ahora = relojNs();
+            while (vueloCola != vueloCabeza && enVuelo[vueloCola].lsn <= lsnConfirmado) {
+                retraso.registrar(ahora - enVuelo[vueloCola].inicio);
+                vueloCola = (vueloCola + 1) % MAX_EN_VUELO;
+            }
+            if (esperar && (vueloCabeza + 1) % MAX_EN_VUELO != vueloCola) return; // hay lugar otra vez
+        }
+    }
+
+    void desconectar() {
+        if (fd < 0) return;
+        printf("[Replica] Standby desconectado (LSN confirmado %llu de %llu).\n", lsnConfirmado, lsn);
+        close(fd);
+        fd = -1;
+    }
+
+    /// Reserva espacio para una operación; envía el lote si no cabe.
+    unsigned char* reservar(unsigned handle, unsigned char op, size_t bytes, unsigned cnt = 0,
+                            unsigned char tipo = 0, unsigned short banderas = 0) {
+        if (usado + sizeof(Operacion) + bytes > MAX_LOTE) enviarLote();
+        if (usado == 0) inicioLote = relojNs();
+        Operacion o;
+        o.lsn = ++lsn;
+        o.handle = handle;
+        o.op = op;
+        o.tipo = tipo;
+        o.banderas = banderas;
+        o.bytes = (unsigned)bytes;
+        o.cnt = cnt;
+        std::memcpy(buffer + usado, &o, sizeof(o));
+        usado += sizeof(o) + bytes;
+        return buffer + usado - bytes;
+    }
+
+public:
+    ReplicadorPrimario()
+        : fdEscucha(-1), fd(-1), buffer(NULL), usado(0), lsn(0), lsnEnviado(0), lsnConfirmado(0),
+          inicioLote(0), vueloCabeza(0), vueloCola(0), nsCosto(0), lotes(0), bytesEnviados(0) {
+        ruta[0] = '\0';
+    }
+
+    ~ReplicadorPrimario() {
+        if (fd >= 0) close(fd);
+        if (fdEscucha >= 0) close(fdEscucha);
+        if (ruta[0]) unlink(ruta);
+        delete[] buffer;
+    }
+
+    bool activo() const { return fd >= 0; }
+    bool huboActividad() const { return lsn > 0; }
+
+    /**
+     * @brief Escucha en `ruta` y espera (bloqueando) a que el standby se conecte.
+     */
+    bool esperarStandby(const char* r) {
+        sockaddr_un dir;
+        std::memset(&dir, 0, sizeof(dir));
+        dir.sun_family = AF_UNIX;
+        if (std::strlen(r) >= sizeof(dir.sun_path)) return false;
+        std::strcpy(dir.sun_path, r);
+        unlink(r);
+        fdEscucha = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fdEscucha < 0) return false;
+        if (bind(fdEscucha, (sockaddr*)&dir, sizeof(dir)) != 0 || listen(fdEscucha, 1) != 0) {
+            close(fdEscucha);
+            fdEscucha = -1;
+            return false;
+        }
+        std::strcpy(ruta, r);
+        printf("[Replica] Esperando standby en %s...\n", ruta);
+        fd = accept(fdEscucha, NULL, NULL);
+        if (fd < 0) return false;
+        if (!buffer) buffer = new unsigned char[MAX_LOTE];
+        printf("[Replica] Standby conectado.\n");
+        return true;
+    }
+
+    void alta(unsigned handle, unsigned char tipo, const char* nombre) {
+        if (fd < 0) return;
+        unsigned long long t0 = relojNs();
+        char* p = (char*)reservar(handle, OP_ALTA, 50, 0, tipo);
+        size_t largo = std::strlen(nombre);
+        if (largo > 49) largo = 49;
+        std::memset(p, 0, 50);
+        std::memcpy(p, nombre, largo);
+        nsCosto += relojNs() - t0;
+    }
+
+    void lectura(unsigned handle, const void* valor, unsigned char banderas, long long marcaMs) {
+        if (fd < 0) return;
+        unsigned long long t0 = relojNs();
+        unsigned char* p = reservar(handle, OP_LECTURA, 4 + sizeof(marcaMs), 1, 0, banderas);
+        std::memcpy(p, valor, 4);
+        std::memcpy(p + 4, &marcaMs, sizeof(marcaMs));
+        nsCosto += relojNs() - t0;
+    }
+
+    void procesado(unsigned handle) {
+        if (fd < 0) return;
+        unsigned long long t0 = relojNs();
+        reservar(handle, OP_PROCESADO, 0);
+        nsCosto += relojNs() - t0;
+    }
+
+    /**
+     * @brief Copia base de un historial ya existente (registros crudos con
+     *        banderas), partida en trozos que caben en un lote.
+     */
+    void carga(unsigned handle, const unsigned char* registros, size_t cnt, size_t bytesPorLectura) {
+        if (fd < 0 || cnt == 0) return;
+        unsigned long long t0 = relojNs();
+        size_t porTrozo = (MAX_LOTE - sizeof(Operacion)) / bytesPorLectura;
+        for (size_t i = 0; i < cnt; i += porTrozo) {
+            size_t m = (cnt - i < porTrozo) ? cnt - i : porTrozo;
+            std::memcpy(reservar(handle, OP_CARGA, m * bytesPorLectura, (unsigned)m),
+                        registros + i * bytesPorLectura, m * bytesPorLectura);
+        }
+        nsCosto += relojNs() - t0;
+    }
+
+    /**
+     * @brief Envía el lote en construcción (si lo hay) y procesa las
+     *        confirmaciones que ya llegaron. No espera al standby.
+     */
+    void enviarLote() {
+        if (fd < 0 || usado == 0) return;
+        unsigned long long t0 = relojNs();
+        if ((vueloCabeza + 1) % MAX_EN_VUELO == vueloCola) drenarConfirmaciones(true); // ventana llena
+        Lote l = { MAGIA_LOTE, (unsigned)usado, lsn };
+        if (fd < 0 || !escribirCompleto(fd, &l, sizeof(l)) || !escribirCompleto(fd, buffer, usado)) {
+            usado = 0;
+            desconectar();
+            return;
+        }
+        enVuelo[vueloCabeza].lsn = lsn;
+        enVuelo[vueloCabeza].inicio = inicioLote;
+        vueloCabeza = (vueloCabeza + 1) % MAX_EN_VUELO;
+        lsnEnviado = lsn;
+        lotes++;
+        bytesEnviados += sizeof(l) + usado;
+        usado = 0;
+        drenarConfirmaciones(false);
+        nsCosto += relojNs() - t0;
+    }
+
+    /**
+     * @brief Envía lo pendiente y espera (hasta `esperaMs`) a que el standby
+     *        confirme el último LSN enviado. Es el punto de durabilidad: lo
+     *        confirmado sobrevive a una conmutación.
+     * @return true si no se replica o si el standby confirmó todo; false si
+     *         se desconectó o no confirmó a tiempo.
+     */
+    bool sincronizar(unsigned esperaMs = 1000) {
+        if (ruta[0] == '\0') return true;
+        enviarLote();
+        unsigned long long t0 = relojNs();
+        unsigned long long fin = t0 + esperaMs * 1000000ull;
+        while (fd >= 0 && lsnConfirmado < lsnEnviado) {
+            unsigned long long ahora = relojNs();
+            if (ahora >= fin) break;
+            pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, (int)((fin - ahora + 999999ull) / 1000000ull)) > 0) drenarConfirmaciones(false);
+        }
+        nsCosto += relojNs() - t0;
+        return fd >= 0 && lsnConfirmado >= lsn;
+    }
+
+    /// Envía lo pendiente y espera hasta `esperaMs` la confirmación final.
+    void cerrar(unsigned esperaMs = 1000) { sincronizar(esperaMs); }
+
+    void imprimirReporte() const {
+        printf("\n--- Replicacion (%s) ---\n", activo() ? "standby conectado" : "sin standby");
+        printf("  LSN: generado %llu, enviado %llu, confirmado %llu (retraso %llu operaciones)\n",
+               lsn, lsnEnviado, lsnConfirmado, lsn - lsnConfirmado);
+        printf("  Lotes: %llu (%llu bytes, %.1f operaciones por lote)\n", lotes, bytesEnviados,
+               lotes ? (double)lsnEnviado / (double)lotes : 0.0);
+        printf("  Costo en el primario: %.1f ms en total, %.0f ns por operacion\n",
+               nsCosto / 1e6, lsn ? (double)nsCosto / (double)lsn : 0.0);
+        retraso.imprimir("Retraso de replicacion:");
+    }
+};
+
+/* ============================================================
+ *        Exportación columnar (formato de archivo Arrow IPC)
+ * ============================================================*/
+
+/**
+ * @brief Constructor mínimo de FlatBuffers hacia adelante: cada objeto se
+ *        escribe antes que sus hijos y los offsets (siempre hacia adelante)
+ *        se enlazan cuando el hijo ya tiene posición.
+ */
+class ConstructorFlatbuffer {
+private:
+    unsigned char* buf;
+    size_t n, capacidad;
+
+    ConstructorFlatbuffer(const ConstructorFlatbuffer&);
+    ConstructorFlatbuffer& operator=(const ConstructorFlatbuffer&);
+
+    void asegurar(size_t extra) {
+        if (n + extra <= capacidad) return;
+        size_t nueva = capacidad ? capacidad * 2 : 512;
+        while (nueva < n + extra) nueva *= 2;
+        unsigned char* mayor = new unsigned char[nueva];
+        if (n) std::memcpy(mayor, buf, n);
+        delete[] buf;
+        buf = mayor;
+        capacidad = nueva;
+    }
+
+public:
+    ConstructorFlatbuffer() : buf(NULL), n(0), capacidad(0) {
+        poner(NULL, 4); // offset a la tabla raíz
+    }
+    ~ConstructorFlatbuffer() { delete[] buf; }
+
+    size_t tam() const { return n; }
+    const unsigned char* datos() const { return buf; }
+
+    size_t poner(const void* p, size_t bytes) {
+        asegurar(bytes);
+        if (p) std::memcpy(buf + n, p, bytes);
+        else std::memset(buf + n, 0, bytes);
+        n += bytes;
+        return n - bytes;
+    }
+
+    void alinear(size_t a) {
+        while (n % a) poner(NULL, 1);
+    }
+
+    template <typename U>
+    void escribir(size_t pos, U v) { std::memcpy(buf + pos, &v, sizeof(v)); }
+
+    /// uoffset del campo en `posCampo` hacia el objeto en `posObjeto`.
+    void enlazar(size_t posCampo, size_t posObjeto) {
+        escribir<unsigned>(posCampo, (unsigned)(posObjeto - posCampo));
+    }
+
+    void raiz(size_t tabla) { enlazar(0, tabla); }
+
+    /**
+     * @brief Escribe vtable + tabla. `tamanos[i]` son los bytes del campo i
+     *        (0 = ausente); `pos[i]` recibe su posición absoluta.
+     */
+    size_t tabla(int campos, const unsigned char* tamanos, size_t* pos) {
+        unsigned short rel[16] = { 0 };
+        unsigned short fin = 4;
+        bool ocho = false;
+        for (unsigned tam = 8; tam >= 1; tam /= 2) {
+            for (int i = 0; i < campos; ++i) {
+                if (tamanos[i] != tam) continue;
+                if (tam == 8) ocho = true;
+                rel[i] = fin;
+                fin = (unsigned short)(fin + tam);
+            }
+        }
+        while (fin % 4) fin++;
+        alinear(2);
+        size_t vt = poner(NULL, 4 + 2 * (size_t)campos);
+        escribir<unsigned short>(vt, (unsigned short)(4 + 2 * campos));
+        escribir<unsigned short>(vt + 2, fin);
+        for (int i = 0; i < campos; ++i) escribir<unsigned short>(vt + 4 + 2 * i, rel[i]);
+        alinear(4);
+        if (ocho && n % 8 != 4) poner(NULL, 4); // campos de 8 bytes alineados
+        size_t t = poner(NULL, fin);
+        escribir<int>(t, (int)(t - vt));
+        for (int i = 0; i < campos; ++i) pos[i] = rel[i] ? t + rel[i] : 0;
+        return t;
+    }
+
+    size_t cadena(const char* texto) {
+        alinear(4);
+        unsigned largo = (unsigned)std::strlen(texto);
+        size_t p = poner(&largo, 4);
+        poner(texto, largo + 1);
+        return p;
+    }
+
+    /// Vector de offsets: los elementos se enlazan luego en p + 4 + 4*i.
+    size_t vectorOffsets(unsigned cuenta) {
+        alinear(4);
+        size_t p = poner(&cuenta, 4);
+        poner(NULL, 4 * (size_t)cuenta);
+        return p;
+    }
+
+    /// Vector de structs con alineación de 8 bytes.
+    size_t vectorStructs(const void* elementos, unsigned cuenta, size_t tamElemento) {
+        alinear(4);
+        if (n % 8 != 4) poner(NULL, 4);
+        size_t p = poner(&cuenta, 4);
+        if (cuenta) poner(elementos, cuenta * tamElemento);
+        return p;
+    }
+};
+
+/**
+ * @brief Escritor del formato de archivo Arrow IPC (metadatos V5) para el
+ *        historial de los sensores: un lote (record batch) por sensor con
+ *        las columnas sensor (utf8), marca (timestamp ms UTC), valor
+ *        (float64) y banderas (uint8), cada una con su bitmap de validez.
+ * @details Las listas enlazadas no se pueden exponer como buffers
+ *          contiguos; cada buffer se escribe en una pasada sobre los nodos
+ *          usando un bloque fijo de la pila, sin copia intermedia del
+ *          historial.
+ */
+class EscritorArrow {
+public:
+    static const int COLUMNAS = 4;
+    static const int BUFFERS = 9;   ///< utf8 usa 3 (validez, offsets, datos); el resto 2
+
+    struct Bloque {                 ///< Struct Block del pie de archivo
+        long long offset;
+        int metaDatos;
+        int relleno;
+        long long cuerpo;
+    };
+
+private:
+    FILE* f;
+    long long posicion;
+    Bloque* lotes;
+    unsigned numLotes, capLotes;
+    unsigned long long filas;
+
+    EscritorArrow(const EscritorArrow&);
+    EscritorArrow& operator=(const EscritorArrow&);
+
+    static size_t relleno8(size_t v) { return (v + 7) & ~(size_t)7; }
+
+    bool poner(const void* p, size_t bytes) {
+        if (bytes && std::fwrite(p, bytes, 1, f) != 1) return false;
+        posicion += (long long)bytes;
+        return true;
+    }
+
+    bool ceros(size_t bytes) {
+        static const unsigned char cero[8] = { 0 };
+        while (bytes) {
+            size_t m = bytes < 8 ? bytes : 8;
+            if (!poner(cero, m)) return false;
+            bytes -= m;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Campos del esquema; reutilizado en el mensaje y en el pie.
+     */
+    static size_t esquema(ConstructorFlatbuffer& b) {
+        static const char* nombres[COLUMNAS] = { "sensor", "marca", "valor", "banderas" };
+        static const unsigned char tipos[COLUMNAS] = { 5, 10, 3, 2 }; // Utf8, Timestamp, FloatingPoint, Int
+        const unsigned char tamEsquema[2] = { 0, 4 };
+        size_t posEsquema[2];
+        size_t tEsquema = b.tabla(2, tamEsquema, posEsquema);
+        size_t vec = b.vectorOffsets(COLUMNAS);
+        b.enlazar(posEsquema[1], vec);
+        for (int c = 0; c < COLUMNAS; ++c) {
+            const unsigned char tamCampo[6] = { 4, 1, 1, 4, 0, 4 };
+            size_t pc[6];
+            size_t campo = b.tabla(6, tamCampo, pc);
+            b.enlazar(vec + 4 + 4 * (size_t)c, campo);
+            b.escribir<unsigned char>(pc[1], c == 2 ? 1 : 0); // solo valor admite nulos
+            b.escribir<unsigned char>(pc[2], tipos[c]);
+            b.enlazar(pc[0], b.cadena(nombres[c]));
+            size_t pt[2];
+            if (c == 0) {
+                b.enlazar(pc[3], b.tabla(0, NULL, pt));
+            } else if (c == 1) {
+                const unsigned char tam[2] = { 2, 4 };
+                b.enlazar(pc[3], b.tabla(2, tam, pt));
+                b.escribir<short>(pt[0], 1); // MILLISECOND
+                b.enlazar(pt[1], b.cadena("UTC"));
+            } else if (c == 2) {
+                const unsigned char tam[1] = { 2 };
+                b.enlazar(pc[3], b.tabla(1, tam, pt));
+                b.escribir<short>(pt[0], 2); // DOUBLE
+            } else {
+                const unsigned char tam[2] = { 4, 1 };
+                b.enlazar(pc[3], b.tabla(2, tam, pt));
+                b.escribir<int>(pt[0], 8);
+                b.escribir<unsigned char>(pt[1], 0);
+            }
+            b.enlazar(pc[5], b.vectorOffsets(0));
+        }
+        return tEsquema;
+    }
+
+    /**
+     * @brief Mensaje encapsulado: 0xFFFFFFFF, largo, flatbuffer rellenado a 8.
+     * @return Bytes de metadatos (incluye el prefijo de 8), o -1.
+     */
+    int escribirMensaje(ConstructorFlatbuffer& b) {
+        b.alinear(8);
+        unsigned prefijo[2] = { 0xFFFFFFFFu, (unsigned)b.tam() };
+        if (!poner(prefijo, sizeof(prefijo)) || !poner(b.datos(), b.tam())) return -1;
+        return (int)(8 + b.tam());
+    }
+
+    /// Tabla Message con su encabezado (union) y bodyLength.
+    static size_t mensaje(ConstructorFlatbuffer& b, unsigned char tipoEncabezado, long long cuerpo,
+                          size_t& posEncabezado) {
+        const unsigned char tam[4] = { 2, 1, 4, 8 };
+        size_t pm[4];
+        size_t t = b.tabla(4, tam, pm);
+        b.escribir<short>(pm[0], 4); // MetadataVersion V5
+        b.escribir<unsigned char>(pm[1], tipoEncabezado);
+        b.escribir<long long>(pm[3], cuerpo);
+        posEncabezado = pm[2];
+        return t;
+    }
+
+    /**
+     * @brief Escribe un buffer recorriendo la lista con un bloque fijo y lo
+     *        rellena hasta múltiplo de 8 (`previos` = bytes ya escritos de él).
+     */
+    template <typename T, typename Conv>
+    bool columna(const ListaSensor<T>& h, size_t tamElemento, Conv conv, size_t previos = 0) {
+        unsigned char bloque[4096];
+        size_t usado = 0, total = previos;
+        for (const typename ListaSensor<T>::Nodo* x = h.primero(); x; x = x->siguiente) {
+            if (usado + tamElemento > sizeof(bloque)) {
+                if (!poner(bloque, usado)) return false;
+                usado = 0;
+            }
+            conv(x, bloque + usado);
+            usado += tamElemento;
+            total += tamElemento;
+        }
+        return poner(bloque, usado) && ceros(relleno8(total) - total);
+    }
+
+    /// Bitmap de validez con todas las filas presentes.
+    bool validez(size_t filasLote) {
+        unsigned char bloque[512];
+        std::memset(bloque, 0xFF, sizeof(bloque));
+        size_t completos = filasLote / 8;
+        for (size_t i = 0; i < completos; i += sizeof(bloque)) {
+            size_t m = completos - i < sizeof(bloque) ? completos - i : sizeof(bloque);
+            if (!poner(bloque, m)) return false;
+        }
+        size_t bytes = (filasLote + 7) / 8;
+        if (filasLote % 8) {
+            unsigned char ultimo = (unsigned char)((1u << (filasLote % 8)) - 1);
+            if (!poner(&ultimo, 1)) return false;
+        }
+        return ceros(relleno8(bytes) - bytes);
+    }
+
+    struct ConvMarca {
+        template <typename N> void operator()(const N* x, unsigned char* out) const {
+            std::memcpy(out, &x->marcaMs, 8);
+        }
+    };
+    struct ConvValor {
+        template <typename N> void operator()(const N* x, unsigned char* out) const {
+            double v = (double)x->dato;
+            std::memcpy(out, &v, 8);
+        }
+    };
+    struct ConvBanderas {
+        template <typename N> void operator()(const N* x, unsigned char* out) const { *out = x->banderas; }
+    };
+    struct ConvOffset {
+        mutable int acumulado;
+        int largo;
+        ConvOffset(int l) : acumulado(0), largo(l) {}
+        template <typename N> void operator()(const N*, unsigned char* out) const {
+            acumulado += largo;
+            std::memcpy(out, &acumulado, 4);
+        }
+    };
+
+public:
+    EscritorArrow() : f(NULL), posicion(0), lotes(NULL), numLotes(0), capLotes(0), filas(0) {}
+    ~EscritorArrow() {
+        if (f) std::fclose(f);
+        delete[] lotes;
+    }
+
+    unsigned long long filasEscritas() const { return filas; }
+    long long bytesEscritos() const { return posicion; }
+
+    bool abrir(const char* ruta) {
+        f = std::fopen(ruta, "wb");
+        if (!f) return false;
+        ConstructorFlatbuffer b;
+        size_t posEsquema;
+        b.raiz(mensaje(b, 1, 0, posEsquema));
+        b.enlazar(posEsquema, esquema(b));
+        return poner("ARROW1\0\0", 8) && escribirMensaje(b) > 0;
+    }
+
+    /**
+     * @brief Agrega el historial de un sensor como un lote.
+     */
+    template <typename T>
+    bool agregarLote(const char* nombre, const ListaSensor<T>& h) {
+        size_t nf = h.size();
+        if (nf == 0) return true;
+        int largoNombre = (int)std::strlen(nombre);
+        long long largos[BUFFERS] = {
+            (long long)((nf + 7) / 8), (long long)(4 * (nf + 1)), (long long)nf * largoNombre, // sensor
+            (long long)((nf + 7) / 8), (long long)(8 * nf),                                   // marca
+            (long long)((nf + 7) / 8), (long long)(8 * nf),                                   // valor
+            (long long)((nf + 7) / 8), (long long)nf                                          // banderas
+        };
+        long long desplaz[BUFFERS * 2];
+        long long cuerpo = 0;
+        for (int i = 0; i < BUFFERS; ++i) {
+            desplaz[2 * i] = cuerpo;
+            desplaz[2 * i + 1] = largos[i];
+            cuerpo += (long long)relleno8((size_t)largos[i]);
+        }
+        long long nodos[COLUMNAS * 2];
+        for (int c = 0; c < COLUMNAS; ++c) {
+            nodos[2 * c] = (long long)nf;
+            nodos[2 * c + 1] = 0;
+        }
+
+        ConstructorFlatbuffer b;
+        size_t posLote;
+        b.raiz(mensaje(b, 3, cuerpo, posLote)); // RecordBatch
+        const unsigned char tam[3] = { 8, 4, 4 };
+        size_t pl[3];
+        b.enlazar(posLote, b.tabla(3, tam, pl));
+        b.escribir<long long>(pl[0], (long long)nf);
+        b.enlazar(pl[1], b.vectorStructs(nodos, COLUMNAS, 16));
+        b.enlazar(pl[2], b.vectorStructs(desplaz, BUFFERS, 16));
+
+        long long inicio = posicion;
+        int meta = escribirMensaje(b);
+        if (meta < 0) return false;
+
+        // Cuerpo: mismos buffers y orden que `largos`.
+        int cero = 0;
+        bool ok = validez(nf) && poner(&cero, 4) && columna(h, 4, ConvOffset(largoNombre), 4);
+        for (size_t i = 0; ok && i < nf; ++i) ok = poner(nombre, (size_t)largoNombre);
+        ok = ok && ceros(relleno8(nf * largoNombre) - nf * largoNombre);
+        ok = ok && validez(nf) && columna(h, 8, ConvMarca());
+        ok = ok && validez(nf) && columna(h, 8, ConvValor());
+        ok = ok && validez(nf) && columna(h, 1, ConvBanderas());
+        if (!ok) return false;
+
+        if (numLotes == capLotes) {
+            unsigned nueva = capLotes ? capLotes * 2 : 16;
+            Bloque* mayor = new Bloque[nueva];
+            if (numLotes) std::memcpy(mayor, lotes, numLotes * sizeof(Bloque));
+            delete[] lotes;
+            lotes = mayor;
+            capLotes = nueva;
+        }
+        Bloque bl = { inicio, meta, 0, cuerpo };
+        lotes[numLotes++] = bl;
+        filas += nf;
+        return true;
+    }
+
+    /**
+     * @brief Marca de fin de flujo, pie (esquema + bloques) y cierre.
+     */
+    bool cerrar() {
+        if (!f) return false;
+        unsigned fin[2] = { 0xFFFFFFFFu, 0 };
+        ConstructorFlatbuffer b;
+        const unsigned char tam[4] = { 2, 4, 4, 4 };
+        size_t pp[4];
+        b.raiz(b.tabla(4, tam, pp));
+        b.escribir<short>(pp[0], 4);
+        b.enlazar(pp[1], esquema(b));
+        b.enlazar(pp[2], b.vectorStructs(NULL, 0, sizeof(Bloque)));
+        b.enlazar(pp[3], b.vectorStructs(lotes, numLotes, sizeof(Bloque)));
+        int largo = (int)b.tam();
+        bool ok = poner(fin, sizeof(fin)) && poner(b.datos(), b.tam()) && poner(&largo, 4) &&
+                  poner("ARROW1", 6);
+        ok = std::fclose(f) == 0 && ok;
+        f = NULL;
+        return ok;
+    }
+};
+
+/* ============================================================
+ *        Top-K incremental de sensores por métrica
+ * ============================================================*/
+
+/**
+ * @brief Montículo binario de handles con la posición de cada handle
+ *        indexada, para actualizar o quitar cualquiera en O(log n).
+ */
+class MonticuloIndexado {
+private:
+    unsigned* handles;
+    double* valores;
+    size_t n, cap;
+    int* pos;        ///< Posición por handle (-1 = ausente)
+    size_t capPos;
+    bool mayorArriba;
+
+    // No copiable: posee sus arreglos.
+    MonticuloIndexado(const MonticuloIndexado&);
+    MonticuloIndexado& operator=(const MonticuloIndexado&);
+
+    bool antes(size_t a, size_t b) const {
+        return mayorArriba ? valores[a] > valores[b] : valores[a] < valores[b];
+    }
+
+    void intercambiar(size_t a, size_t b) {
+        unsigned h = handles[a]; handles[a] = handles[b]; handles[b] = h;
+        double v = valores[a]; valores[a] = valores[b]; valores[b] = v;
+        pos[handles[a]] = (int)a;
+        pos[handles[b]] = (int)b;
+    }
+
+    void subir(size_t i) {
+        while (i > 0 && antes(i, (i - 1) / 2)) {
+            intercambiar(i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+    }
+
+    void bajar(size_t i) {
+        for (;;) {
+            size_t m = i, izq = 2 * i + 1, der = 2 * i + 2;
+            if (izq < n && antes(izq, m)) m = izq;
+            if (der < n && antes(der, m)) m = der;
+            if (m == i) return;
+            intercambiar(i, m);
+            i = m;
+        }
+    }
+
+    void asegurarHandle(unsigned h) {
+        if (h < capPos) return;
+        size_t nueva = capPos ? capPos : 64;
+        while (nueva <= h) nueva *= 2;
+        int* mayor = new int[nueva];
+        for (size_t i = 0; i < nueva; ++i) mayor[i] = i < capPos ? pos[i] : -1;
+        delete[] pos;
+        pos = mayor;
+        capPos = nueva;
+    }
+
+public:
+    explicit MonticuloIndexado(bool mayorArriba)
+        : handles(NULL), valores(NULL), n(0), cap(0), pos(NULL), capPos(0), mayorArriba(mayorArriba) {}
+
+    ~MonticuloIndexado() {
+        delete[] handles;
+        delete[] valores;
+        delete[] pos;
+    }
+
+    size_t size() const { return n; }
+
+    bool contiene(unsigned h) const { return h < capPos && pos[h] >= 0; }
+
+    unsigned tope() const { return handles[0]; }
+    double valorTope() const { return valores[0]; }
+
+    unsigned handleEn(size_t i) const { return handles[i]; }
+    double valorEn(size_t i) const { return valores[i]; }
+
+    /**
+     * @brief Inserta el handle o actualiza su valor.
+     */
+    void poner(unsigned h, double v) {
+        asegurarHandle(h);
+        if (pos[h] >= 0) {
+            size_t i = (size_t)pos[h];
+            valores[i] = v;
+            subir(i);
+            bajar((size_t)pos[h]);
+            return;
+        }
+        if (n == cap) {
+            size_t nueva = cap ? cap * 2 : 16;
+            unsigned* hs = new unsigned[nueva];
+            double* vs = new double[nueva];
+            for (size_t i = 0; i < n; ++i) { hs[i] = handles[i]; vs[i] = valores[i]; }
+            delete[] handles;
+            delete[] valores;
+            handles = hs;
+            valores = vs;
+            cap = nueva;
+        }
+        handles[n] = h;
+        valores[n] = v;
+        pos[h] = (int)n;
+        subir(n++);
+    }
+
+    void quitar(unsigned h) {
+        if (!contiene(h)) return;
+        size_t i = (size_t)pos[h];
+        pos[h] = -1;
+        if (i == --n) return;
+        handles[i] = handles[n];
+        valores[i] = valores[n];
+        pos[handles[i]] = (int)i;
+        subir(i);
+        bajar((size_t)pos[handles[i]]);
+    }
+
+    void clear() {
+        for (size_t i = 0; i < n; ++i) pos[handles[i]] = -1;
+        n = 0;
+    }
+};
+
+/**
+ * @brief Los K sensores con mayor valor de una métrica, exacto en todo
+ *        momento.
+ * @details `top` es un montículo de mínimo con los K mejores (su raíz es
+ *          el umbral de entrada) y `resto` uno de máximo con los demás. Una
+ *          lectura de un sensor del top cuesta O(log K); la de un sensor
+ *          fuera del top, O(log N) en `resto`, que es lo que permite
+ *          reponer el top cuando el último valor de un miembro baja.
+ *          copiaOrdenada() copia y ordena solo los K del top.
+ */
+class RankingSensores {
+public:
+    enum Metrica { ULTIMO = 1, PROMEDIO = 2, MAXIMO = 3 };
+
+private:
+    Metrica metrica;
+    int tipo;     ///< TipoSensor filtrado (0 = todos)
+    size_t k;
+    MonticuloIndexado top;
+    MonticuloIndexado resto;
+
+    RankingSensores(const RankingSensores&);
+    RankingSensores& operator=(const RankingSensores&);
+
+    void equilibrar() {
+        double v;
+        while (top.size() < k && resto.size()) {
+            unsigned h = resto.tope();
+            v = resto.valorTope();
+            resto.quitar(h);
+            top.poner(h, v);
+        }
+        while (top.size() && resto.size() && resto.valorTope() > top.valorTope()) {
+            unsigned sube = resto.tope(), baja = top.tope();
+            double vs = resto.valorTope(), vb = top.valorTope();
+            resto.quitar(sube);
+            top.quitar(baja);
+            top.poner(sube, vs);
+            resto.poner(baja, vb);
+        }
+    }
+
+public:
+    RankingSensores(Metrica m, int tipo, size_t k)
+        : metrica(m), tipo(tipo), k(k ? k : 1), top(false), resto(true) {}
+
+    Metrica getMetrica() const { return metrica; }
+    int getTipo() const { return tipo; }
+    size_t getK() const { return k; }
+
+    const char* nombreMetrica() const {
+        switch (metrica) {
+            case ULTIMO:   return "ultimo valor";
+            case PROMEDIO: return "promedio";
+            default:       return "maximo";
+        }
+    }
+
+    void actualizar(unsigned h, double v) {
+        if (top.contiene(h)) top.poner(h, v);
+        else resto.poner(h, v);
+        equilibrar();
+    }
+
+    void quitar(unsigned h) {
+        top.quitar(h);
+        resto.quitar(h);
+        equilibrar();
+    }
+
+    void clear() {
+        top.clear();
+        resto.clear();
+    }
+
+    /**
+     * @brief Copia el top de mayor a menor, en O(K log K): la copia ya es
+     *        un montículo de mínimo, así que basta la fase de extracción de
+     *        heapsort (cada mínimo va al final de lo que queda).
+     * @return Cuántos escribió (<= K).
+     */
+    size_t copiaOrdenada(unsigned* handles, double* valores) const {
+        size_t m = top.size();
+        for (size_t i = 0; i < m; ++i) {
+            handles[i] = top.handleEn(i);
+            valores[i] = top.valorEn(i);
+        }
+        for (size_t fin = m; fin > 1;) {
+            --fin;
+            unsigned h = handles[0]; handles[0] = handles[fin]; handles[fin] = h;
+            double v = valores[0]; valores[0] = valores[fin]; valores[fin] = v;
+            for (size_t i = 0;;) {
+                size_t menor = i, izq = 2 * i + 1, der = 2 * i + 2;
+                if (izq < fin && valores[izq] < valores[menor]) menor = izq;
+                if (der < fin && valores[der] < valores[menor]) menor = der;
+                if (menor == i) break;
+                h = handles[i]; handles[i] = handles[menor]; handles[menor] = h;
+                v = valores[i]; valores[i] = valores[menor]; valores[menor] = v;
+                i = menor;
+            }
+        }
+        return m;
+    }
+};
+
+/**
+ * @brief Métricas corrientes por handle y los rankings que las siguen.
+ * @details ListaGeneral registra cada sensor y notificarLectura() informa
+ *          cada lectura; el promedio y el máximo son los de lo ingresado
+ *          (no cambian con pop_min). Un ranking nuevo se siembra con el
+ *          estado de todos los sensores registrados.
+ */
+class IndiceRanking {
+public:
+    static const int MAX_RANKINGS = 8;
+
+    struct Estado {
+        double ultimo, suma, maximo;
+        unsigned long long lecturas;
+        SensorBase* sensor;
+        int tipo;            ///< 0 si el handle no está registrado
+    };
+
+private:
+    RankingSensores* rankings[MAX_RANKINGS];
+    int cuantos;
+    Estado* estados;
+    size_t capacidad;
+
+    IndiceRanking(const IndiceRanking&);
+    IndiceRanking& operator=(const IndiceRanking&);
+
+    static double valorMetrica(const Estado& e, RankingSensores::Metrica m) {
+        if (m == RankingSensores::ULTIMO) return e.ultimo;
+        if (m == RankingSensores::PROMEDIO) return e.suma / (double)e.lecturas;
+        return e.maximo;
+    }
+
+public:
+    IndiceRanking() : cuantos(0), estados(NULL), capacidad(0) {}
+
+    ~IndiceRanking() {
+        for (int i = 0; i < cuantos; ++i) delete rankings[i];
+        delete[] estados;
+    }
+
+    int getCuantos() const { return cuantos; }
+    const RankingSensores& ranking(int i) const { return *rankings[i]; }
+
+    void registrar(SensorBase* s, unsigned h, int tipo) {
+        if (h >= capacidad) {
+            size_t nueva = capacidad ? capacidad : 64;
+            while (nueva <= h) nueva *= 2;
+            Estado* mayor = new Estado[nueva];
+            for (size_t i = 0; i < nueva; ++i) {
+                if (i < capacidad) {
+                    mayor[i] = estados[i];
+                } else {
+                    mayor[i].ultimo = mayor[i].suma = mayor[i].maximo = 0.0;
+                    mayor[i].lecturas = 0;
+                    mayor[i].sensor = NULL;
+                    mayor[i].tipo = 0;
+                }
+            }
+            delete[] estados;
+            estados = mayor;
+            capacidad = nueva;
+        }
+        Estado& e = estados[h];
+        e.ultimo = e.suma = e.maximo = 0.0;
+        e.lecturas = 0;
+        e.sensor = s;
+        e.tipo = tipo;
+    }
+
+    void quitar(unsigned h) {
+        if (h >= capacidad || !estados[h].tipo) return;
+        estados[h].tipo = 0;
+        for (int i = 0; i < cuantos; ++i) rankings[i]->quitar(h);
+    }
+
+    /// Todos los sensores se liberaron: se conservan los rankings, vacíos.
+    void olvidarTodos() {
+        for (size_t h = 0; h < capacidad; ++h) estados[h].tipo = 0;
+        for (int i = 0; i < cuantos; ++i) rankings[i]->clear();
+    }
+
+    /**
+     * @brief Incorpora una lectura: O(R log K) si el sensor ya está en el
+     *        top de los R rankings que lo siguen.
+     */
+    void lectura(unsigned h, double v) {
+        if (h >= capacidad || !estados[h].tipo) return;
+        Estado& e = estados[h];
+        e.ultimo = v;
+        e.suma += v;
+        if (e.lecturas == 0 || v > e.maximo) e.maximo = v;
+        e.lecturas++;
+        for (int i = 0; i < cuantos; ++i) {
+            RankingSensores* r = rankings[i];
+            if (r->getTipo() && r->getTipo() != e.tipo) continue;
+            r->actualizar(h, valorMetrica(e, r->getMetrica()));
+        }
+    }
+
+    /**
+     * @brief Crea un ranking y lo siembra con los sensores que ya tienen
+     *        lecturas. @return Su índice, o -1 si no hay lugar.
+     */
+    int crear(RankingSensores::Metrica m, int tipo, size_t k) {
+        if (cuantos == MAX_RANKINGS) return -1;
+        RankingSensores* r = new RankingSensores(m, tipo, k);
+        for (size_t h = 0; h < capacidad; ++h) {
+            const Estado& e = estados[h];
+            if (!e.tipo || !e.lecturas || (tipo && tipo != e.tipo)) continue;
+            r->actualizar((unsigned)h, valorMetrica(e, m));
+        }
+        rankings[cuantos] = r;
+        return cuantos++;
+    }
+
+    void imprimir(int i) const;
+};
+
+/* ============================================================
+ *            Jerarquía polimórfica de sensores
+ * ============================================================*/
+
+/**
+ * @brief Clase base abstracta de sensores.
+ *
+ * Además de la interfaz polimórfica, concentra las etapas opcionales que se
+ * aplican a cada lectura al ingresar (notificarLectura), de modo que las
+ * derivadas solo almacenan su historial tipado.
+ */
+class SensorBase {
+protected:
+    char nombre[50]; ///< Identificador del sensor (e.g., "T-001")
+
+    int ranuraFiltro;              ///< Ranura en BancoFiltros::global() (-1 = sin suavizado)
+    SerieSuavizada suavizado;      ///< Serie suavizada, paralela a la cruda
+    PronosticoHolt* pronostico;    ///< NULL si no hay modelo de pronóstico
+    CompresorHistorial* compresor; ///< NULL si el historial guarda toda lectura
+    BocetoSensor* boceto;          ///< NULL si no se mantienen bocetos
+    VentanaSecuencia* secuencia;   ///< Se crea con la primera línea numerada
+    unsigned long long ultimaLecturaMs; ///< Reloj monotónico de la última lectura
+    MonitorLatidos* monitor;       ///< NULL si el sensor no está vigilado
+    Temporizador latido;
+    PlanificadorProcesamiento* planificador; ///< NULL si no está planificado
+    Planificacion plan;
+    CalidadDatos calidad;
+
+    AlmacenDesborde* desborde;  ///< No NULL mientras el historial está en disco
+    long offsetDesborde;
+    size_t desbordadasHistorial;
+    size_t desbordadasSuavizado;
+    size_t bytesEnDisco;
+    bool referenciado;          ///< Bit de uso para el reloj (CLOCK) de desalojo
+
+    /**
+     * @brief Escribe el historial tipado en f (dato + banderas por lectura).
+     * @return Lecturas escritas, o (size_t)-1 si falló la escritura.
+     */
+    virtual size_t escribirHistorial(FILE* f, size_t desde = 0) const = 0;
+
+    virtual void vaciarHistorial() = 0;
+
+    virtual bool cargarHistorial(FILE* f, size_t cnt) = 0;
+
+    virtual size_t bytesPorLectura() const = 0;
+
+    bool modificado;            ///< Cambió desde el último checkpoint
+    bool reescribir;            ///< Hubo eliminaciones: el delta no es solo anexar
+    size_t lecturasCheckpoint;  ///< Prefijo del historial ya cubierto por checkpoints
+
+    /// El historial perdió lecturas intermedias (pop_min): el próximo
+    /// checkpoint lo reescribe completo.
+    void marcarReescritura() {
+        modificado = true;
+        reescribir = true;
+    }
+
+    bool escribirIdentidad(FILE* out) const {
+        unsigned char tipo = (unsigned char)tipoSensor();
+        return std::fwrite(&tipo, 1, 1, out) == 1 && std::fwrite(nombre, sizeof(nombre), 1, out) == 1;
+    }
+
+    /**
+     * @brief Escribe la cuenta y las lecturas desde la posición `desde`.
+     * @details Pensado también para el hijo de fork(): un historial desbordado
+     *          se copia con pread() para no mover el offset del FILE* que
+     *          comparte con el padre; uno mapeado se hidrata en la copia
+     *          privada del hijo.
+     */
+    long long escribirLecturasDesde(FILE* out, size_t desde) {
+        if (porHidratar) hidratar();
+        size_t total = desborde ? desbordadasHistorial : lecturasHistorial();
+        if (desde > total) return -1;
+        unsigned long long cnt = total - desde;
+        if (std::fwrite(&cnt, sizeof(cnt), 1, out) != 1) return -1;
+        bool ok = desborde
+            ? desborde->copiarCrudo(offsetDesborde + (long)(desde * bytesPorLectura()),
+                                    (size_t)cnt * bytesPorLectura(), out)
+            : escribirHistorial(out, desde) != (size_t)-1;
+        return ok ? (long long)cnt : -1;
+    }
+
+    /**
+     * @brief Trae el historial de vuelta si está desbordado y marca el uso.
+     *        Toda ruta que lea o modifique el historial la invoca primero.
+     */
+    void asegurarResidente() {
+        referenciado = true;
+        if (porHidratar) hidratar();
+        if (!desborde) return;
+        unsigned long long t0 = relojNs();
+        AlmacenDesborde* a = desborde;
+        desborde = NULL;
+        FILE* f = a->abrirLectura(offsetDesborde);
+        bool ok = f && cargarHistorial(f, desbordadasHistorial) &&
+                  suavizado.restaurar(f, desbordadasSuavizado);
+        if (!ok) printf("[Memoria] Error al cargar el historial de %s desde disco.\n", nombre);
+        a->cerrarLectura(offsetDesborde, bytesEnDisco, relojNs() - t0);
+        bytesEnDisco = 0;
+    }
+
+    AlmacenMapeado* persistente;  ///< NULL si el sensor no se persiste
+    unsigned indicePersistente;   ///< Entrada en la tabla del archivo mapeado
+    bool porHidratar;             ///< Historial aún solo en el archivo mapeado
+
+    /**
+     * @brief Agrega al historial tipado una lectura cruda (4 bytes) sin pasar
+     *        por las etapas de ingesta; se usa al hidratar desde el archivo.
+     */
+    virtual void cargarCrudo(const unsigned char* valor, unsigned char banderas, long long marcaMs) = 0;
+
+    /**
+     * @brief Guarda un quiebre del compresor en el historial tipado, el
+     *        archivo mapeado y la réplica.
+     */
+    virtual void guardarQuiebre(const CompresorHistorial::PuntoQuiebre& q) = 0;
+
+    /**
+     * @brief Copia la lectura en el archivo mapeado (si el sensor se persiste).
+     */
+    void persistirLectura(const void* valor, unsigned char banderas, long long marcaMs) {
+        if (persistente) persistente->anexar(indicePersistente, valor, banderas, marcaMs);
+    }
+
+    void persistirBorrado(const void* valor) {
+        if (persistente) persistente->marcarBorrado(indicePersistente, valor);
+    }
+
+    /**
+     * @brief Construye el historial en memoria recorriendo los registros
+     *        mapeados del sensor, en O(n); se difiere hasta el primer acceso
+     *        que necesita la lista.
+     */
+    void hidratar() {
+        porHidratar = false;
+        const AlmacenMapeado::Entrada& e = persistente->entrada(indicePersistente);
+        const AlmacenMapeado::Registro* r = persistente->registro(e.cabeza);
+        while (r) {
+            if (!(r->banderas & AlmacenMapeado::BORRADO)) cargarCrudo(r->valor, r->banderas, r->marcaMs);
+            r = r->siguiente ? persistente->registro(r->siguiente) : NULL;
+        }
+    }
+
+    /**
+     * @brief f(valor, banderas, marcaMs) sobre los registros mapeados, sin
+     *        hidratar, si el historial aún no se cargó.
+     * @return false si ya está en memoria (el llamador recorre la lista).
+     */
+    template <typename T, typename F>
+    bool recorrerMapeado(F& f) const {
+        if (!porHidratar) return false;
+        const AlmacenMapeado::Entrada& e = persistente->entrada(indicePersistente);
+        for (const AlmacenMapeado::Registro* r = persistente->registro(e.cabeza); r;
+             r = r->siguiente ? persistente->registro(r->siguiente) : NULL) {
+            if (r->banderas & AlmacenMapeado::BORRADO) continue;
+            T v;
+            std::memcpy(&v, r->valor, sizeof(v));
+            f(v, r->banderas, r->marcaMs);
+        }
+        return true;
+    }
+
+    unsigned handle;              ///< Identificador compacto asignado por ListaGeneral
+    AnilloCompartido* anillo;     ///< NULL si no se publican las lecturas
+    ReplicadorPrimario* replica;  ///< NULL si no hay standby
+    IndiceRanking* ranking;       ///< NULL si el sensor no participa de rankings
+    unsigned long long pendienteDesdeTsc; ///< Llegada de la lectura más vieja sin procesar (trazas)
+
+    void replicarLectura(const void* valor, unsigned char banderas, long long marcaMs) {
+        if (replica) replica->lectura(handle, valor, banderas, marcaMs);
+    }
+
+    void replicarProcesado() {
+        if (replica) replica->procesado(handle);
+    }
+
+    friend class PlanificadorProcesamiento;
+
+    /**
+     * @brief Etapas comunes de ingesta; las derivadas la invocan en agregar().
+     */
+    void notificarLectura(double v, long long marcaMs) {
+        modificado = true;
+        registrarLatido();
+        if (planificador) planificador->lecturaRegistrada(this);
+        if (ranuraFiltro >= 0) BancoFiltros::global().filtrar((unsigned)ranuraFiltro, v, marcaMs);
+        if (pronostico) pronostico->actualizar(v);
+        if (boceto) boceto->agregar(v);
+        if (anillo) anillo->publicar(handle, v, relojNs());
+        if (ranking) ranking->lectura(handle, v);
+    }
+
+    /**
+     * @brief Etapa de calidad: se evalúa antes de guardar la lectura para que
+     *        sus banderas viajen en el mismo nodo.
+     */
+    unsigned char evaluarCalidad(double v) {
+        return calidad.evaluar(v, relojNs());
+    }
+
+    void registrarLatido() {
+        ultimaLecturaMs = relojMs();
+        if (!monitor) return;
+        if (latido.disparado) printf("[Latido] Sensor %s volvio a reportar.\n", nombre);
+        monitor->rearmar(&latido);
+    }
+
+    void imprimirSuavizado() const {
+        if (ranuraFiltro < 0) return;
+        BancoFiltros& banco = BancoFiltros::global();
+        float ultimo = 0.0f;
+        if (suavizado.back(ultimo)) {
+            printf("    Suavizado %s: %zu valores, ultimo %.3f\n",
+                   banco.nombreTipo((unsigned)ranuraFiltro), suavizado.size(), ultimo);
+        } else {
+            printf("    Suavizado %s: sin valores\n", banco.nombreTipo((unsigned)ranuraFiltro));
+        }
+    }
+
+private:
+    // No copiable: posee el pronóstico, el compresor y los bocetos por puntero.
+    SensorBase(const SensorBase&);
+    SensorBase& operator=(const SensorBase&);
+
+public:
+    SensorBase(const char* id = "UNNAMED")
+        : ranuraFiltro(-1), pronostico(NULL), compresor(NULL), boceto(NULL), secuencia(NULL), ultimaLecturaMs(relojMs()), monitor(NULL),
+          planificador(NULL), desborde(NULL), offsetDesborde(0), desbordadasHistorial(0),
+          desbordadasSuavizado(0), bytesEnDisco(0), referenciado(false), modificado(true),
+          reescribir(true), lecturasCheckpoint(0), persistente(NULL), indicePersistente(0),
+          porHidratar(false), handle(0), anillo(NULL), replica(NULL), ranking(NULL),
+          pendienteDesdeTsc(0) {
+        latido.sensor = this;
+        std::strncpy(nombre, id, sizeof(nombre));
+        nombre[sizeof(nombre) - 1] = '\0';
+    }
+
+    virtual ~SensorBase() { // VIRTUAL para liberar derivadas
+        if (monitor) monitor->olvidar(&latido);
+        if (planificador) planificador->quitar(this);
+        if (desborde) desborde->descartar(offsetDesborde, bytesEnDisco);
+        if (ranuraFiltro >= 0) BancoFiltros::global().baja((unsigned)ranuraFiltro);
+        delete pronostico;
+        delete compresor;
+        delete boceto;
+        delete secuencia;
+    }
+
+    const char* getNombre() const { return nombre; }
+
+    unsigned long long getUltimaLecturaMs() const { return ultimaLecturaMs; }
+
+    /**
+     * @brief Vigila el silencio del sensor: si pasan plazoMs sin lecturas,
+     *        el monitor emite una alerta. Con plazoMs 0 deja de vigilarlo.
+     */
+    void vigilarLatido(MonitorLatidos& m, unsigned long long plazoMs) {
+        if (monitor) monitor->olvidar(&latido);
+        monitor = NULL;
+        if (plazoMs == 0) return;
+        monitor = &m;
+        latido.plazoMs = plazoMs;
+        m.rearmar(&latido);
+    }
+
+    /**
+     * @brief Configura (o reemplaza) el filtro de suavizado de ingesta.
+     *        Con tipo NINGUNO se desactiva y se descarta la serie suavizada.
+     */
+    void configurarFiltro(const FiltroSuavizado& f) {
+        BancoFiltros& banco = BancoFiltros::global();
+        if (ranuraFiltro >= 0) banco.baja((unsigned)ranuraFiltro);
+        ranuraFiltro = -1;
+        suavizado.clear();
+        if (f.tipo != FiltroSuavizado::NINGUNO) ranuraFiltro = (int)banco.alta(f, &suavizado);
+    }
+
+    bool tieneFiltro() const { return ranuraFiltro >= 0; }
+
+    /**
+     * @brief Configura (o reemplaza) la compresión del historial. Lo ya
+     *        guardado se conserva: cada lectura previa cuenta como quiebre,
+     *        y el extremo pendiente del compresor anterior se guarda antes.
+     *        Con tipo NINGUNO se vuelve a guardar toda lectura.
+     */
+    void configurarCompresion(const CompresorHistorial& c) {
+        cerrarTramoComprimido();
+        delete compresor;
+        compresor = NULL;
+        if (c.tipo != CompresorHistorial::NINGUNO) compresor = new CompresorHistorial(c);
+    }
+
+    const CompresorHistorial* getCompresor() const { return compresor; }
+
+    /**
+     * @brief Guarda el extremo pendiente del compresor para que historial,
+     *        archivo mapeado y réplica lleguen hasta la última lectura.
+     */
+    void cerrarTramoComprimido() {
+        CompresorHistorial::PuntoQuiebre q;
+        if (!compresor || !compresor->cerrarTramo(q)) return;
+        asegurarResidente();
+        guardarQuiebre(q);
+        modificado = true;
+    }
+
+    /**
+     * @brief Activa (vacío) o descarta los bocetos HLL + count-min.
+     */
+    void configurarBoceto(bool activo) {
+        delete boceto;
+        boceto = activo ? new BocetoSensor() : NULL;
+    }
+
+    const BocetoSensor* getBoceto() const { return boceto; }
+
+    /// Activa los bocetos con el contenido de `b` (sensor migrado).
+    void adoptarBoceto(const BocetoSensor& b) {
+        configurarBoceto(true);
+        *boceto = b;
+    }
+
+    /**
+     * @brief ¿Sería nueva la secuencia? No la marca: una línea cuyo valor
+     *        no se puede aplicar no debe ocupar su número.
+     */
+    VentanaSecuencia::Resultado consultarSecuencia(unsigned long long seq) const {
+        return secuencia ? secuencia->consultar(seq) : VentanaSecuencia::NUEVA;
+    }
+
+    /**
+     * @brief Marca la secuencia como vista (y cuenta duplicadas/tardías);
+     *        para una nueva, después de aplicar su valor.
+     */
+    VentanaSecuencia::Resultado aceptarSecuencia(unsigned long long seq) {
+        if (!secuencia) secuencia = new VentanaSecuencia();
+        return secuencia->registrar(seq);
+    }
+
+    const VentanaSecuencia* getSecuencia() const { return secuencia; }
+
+    /**
+     * @brief Serie suavizada (vacía si no hay filtro configurado).
+     */
+    const SerieSuavizada& getSuavizado() const {
+        return suavizado;
+    }
+
+    const CalidadDatos& getCalidad() const { return calidad; }
+
+    bool estaDesbordado() const { return desborde != NULL; }
+
+    /**
+     * @brief Serializa el sensor (tipo, nombre, historial) para una instantánea.
+     * @return Lecturas escritas, o -1 si hubo error.
+     */
+    long long escribirInstantanea(FILE* out) {
+        if (!escribirIdentidad(out)) return -1;
+        return escribirLecturasDesde(out, 0);
+    }
+
+    /**
+     * @brief Registro de checkpoint incremental: solo lo agregado desde el
+     *        último checkpoint, o el historial completo si hubo una
+     *        eliminación (pop_min) o el sensor es nuevo.
+     * @return Lecturas escritas, o -1 si hubo error.
+     */
+    long long escribirDelta(FILE* out) {
+        if (!escribirIdentidad(out)) return -1;
+        size_t total = desborde ? desbordadasHistorial : lecturasHistorial();
+        unsigned char completo = (reescribir || lecturasCheckpoint > total) ? 1 : 0;
+        if (std::fwrite(&completo, 1, 1, out) != 1) return -1;
+        return escribirLecturasDesde(out, completo ? 0 : lecturasCheckpoint);
+    }
+
+    bool estaModificado() const { return modificado; }
+
+    /**
+     * @brief Marca el estado actual como cubierto por el último checkpoint.
+     */
+    void marcarCheckpoint() {
+        modificado = false;
+        reescribir = false;
+        lecturasCheckpoint = desborde ? desbordadasHistorial
+                           : porHidratar ? persistente->entrada(indicePersistente).vivas
+                           : lecturasHistorial();
+    }
+
+    /**
+     * @brief Lee el historial de una instantánea (formato de escribirHistorial).
+     */
+    bool leerInstantanea(FILE* in, size_t cnt) { return cargarHistorial(in, cnt); }
+
+    /**
+     * @brief Aplica un registro de checkpoint incremental.
+     */
+    bool aplicarDelta(FILE* in, bool completo, size_t cnt) {
+        asegurarResidente();
+        if (completo) {
+            vaciarHistorial();
+        }
+        return cargarHistorial(in, cnt);
+    }
+
+    virtual size_t lecturasHistorial() const = 0;
+
+    virtual TipoSensor tipoSensor() const = 0;
+
+    unsigned getHandle() const { return handle; }
+    void asignarHandle(unsigned h) { handle = h; }
+
+    /// Marca de llegada (ciclos del Trazador) de una lectura aún sin procesar.
+    void marcarLlegada(unsigned long long tsc) {
+        if (!pendienteDesdeTsc) pendienteDesdeTsc = tsc;
+    }
+
+    /**
+     * @brief procesarLectura() con su tramo en las trazas, si están activas.
+     */
+    void procesarConTraza() {
+        Trazador& tr = Trazador::global();
+        if (!tr.estaActivo()) {
+            procesarLectura();
+            return;
+        }
+        unsigned long long inicio = Trazador::ciclos();
+        procesarLectura();
+        tr.procesado(nombre, pendienteDesdeTsc, inicio, Trazador::ciclos());
+        pendienteDesdeTsc = 0;
+    }
+
+    /// Publica cada lectura nueva en el anillo (NULL para dejar de hacerlo).
+    void adjuntarAnillo(AnilloCompartido* a) { anillo = a; }
+
+    /// Envía cada cambio del historial al standby (NULL para dejar de hacerlo).
+    void adjuntarReplica(ReplicadorPrimario* r) { replica = r; }
+
+    /// Informa cada lectura a los rankings top-K (NULL para dejar de hacerlo).
+    void adjuntarRanking(IndiceRanking* r) { ranking = r; }
+
+    /**
+     * @brief Aplica en el standby una lectura replicada: mismas etapas que
+     *        agregar(), pero con las banderas de calidad que calculó el primario.
+     */
+    virtual void reproducirLectura(const unsigned char* valor, unsigned char banderas, long long marcaMs) = 0;
+
+    bool tienePersistencia() const { return persistente != NULL; }
+
+    /**
+     * @brief Vincula el sensor a su entrada del archivo mapeado.
+     * @param hidratarDespues true si la entrada ya tiene lecturas (reinicio):
+     *        el historial se carga de forma diferida en el primer acceso.
+     */
+    void adjuntarPersistencia(AlmacenMapeado* a, unsigned indice, bool hidratarDespues) {
+        persistente = a;
+        indicePersistente = indice;
+        porHidratar = hidratarDespues;
+    }
+
+    /**
+     * @brief Consulta y limpia el bit de uso (segunda oportunidad de CLOCK).
+     */
+    bool tomarReferencia() {
+        bool r = referenciado;
+        referenciado = false;
+        return r;
+    }
+
+    /**
+     * @brief Bytes de nodos en memoria (historial + serie suavizada).
+     */
+    virtual size_t bytesResidentes() const = 0;
+
+    /**
+     * @brief Desaloja el historial y la serie suavizada al archivo de desborde.
+     *        El sensor queda como cascarón hasta el próximo acceso.
+     */
+    bool desbordar(AlmacenDesborde& a) {
+        if (desborde) return true;
+        size_t nSuav = suavizado.size();
+        size_t bytes = lecturasHistorial() * bytesPorLectura() +
+                       nSuav * ListaSensor<float>::bytesPorRegistro();
+        long off = a.abrirEscritura(bytes);
+        if (off < 0) return false;
+        FILE* f = a.abrirLectura(off);
+        size_t nHist = escribirHistorial(f);
+        if (nHist == (size_t)-1 || !suavizado.volcar(f)) {
+            a.cancelarEscritura(off, bytes);
+            printf("[Memoria] Error al desbordar %s; se mantiene en memoria.\n", nombre);
+            return false;
+        }
+        vaciarHistorial();
+        suavizado.clear();
+        bytesEnDisco = bytes;
+        a.cerrarEscritura(bytesEnDisco);
+        desborde = &a;
+        offsetDesborde = off;
+        desbordadasHistorial = nHist;
+        desbordadasSuavizado = nSuav;
+        return true;
+    }
+
+    /**
+     * @brief Activa (o reinicia) el pronóstico Holt-Winters del sensor.
+     *        Solo aprende de las lecturas que lleguen a partir de ahora.
+     */
+    void habilitarPronostico(double alpha, double beta, double gamma, int periodo) {
+        delete pronostico;
+        pronostico = new PronosticoHolt(alpha, beta, gamma, periodo);
+    }
+
+    void deshabilitarPronostico() {
+        delete pronostico;
+        pronostico = NULL;
+    }
+
+    /**
+     * @brief Pronostica los próximos k valores y su banda de confianza.
+     * @return false si el pronóstico no está habilitado o no tiene lecturas.
+     */
+    bool pronosticar(int k, double* media, double* inf, double* sup) const {
+        return pronostico && pronostico->pronosticar(k, media, inf, sup);
+    }
+
+    /**
+     * @brief Procesa las lecturas internas de cada sensor (polimórfico).
+     */
+    virtual void procesarLectura() = 0;
+
+    /**
+     * @brief Imprime información resumen del sensor.
+     */
+    virtual void imprimirInfo() const = 0;
+
+    /**
+     * @brief Registra una lectura desde texto (general para menú/serial).
+     *        Cada derivada la parsea a su tipo.
+     */
+    virtual bool registrarDesdeTexto(const char* texto) = 0;
+};
+
+/**
+ * @brief Sensor concreto: Temperatura (usa float).
+ *  - Contiene ListaSensor<float> historial
+ *  - Procesamiento: Elimina la lectura mínima y muestra promedio restante.
+ */
+class SensorTemperatura : public SensorBase {
+private:
+    ListaSensor<float> historial;
+    ArchivoCuantizado* archivo; ///< NULL si todo el historial va en nodos float
+    size_t archivadasAlVaciar;  ///< Lecturas del archivo al desbordar: las primeras al recargar
+    mutable ListaSensor<float> vista; ///< Archivo decuantizado + lista para getHistorial(); vacía = sin armar
+
+    /// Todo cambio del historial descarta la vista armada por getHistorial().
+    void invalidarVista() {
+        if (vista.size()) vista.clear();
+    }
+
+    /**
+     * @brief Pasa al archivo cuantizado los bloques más viejos, dejando en
+     *        la lista entre BLOQUE y 2*BLOQUE lecturas recientes.
+     */
+    void archivarFrio(bool recarga = false) {
+        const size_t B = ArchivoCuantizado::BLOQUE;
+        float v[B];
+        unsigned char b[B];
+        long long m[B];
+        while (historial.size() >= 2 * B) {
+            size_t k = historial.extraerFrente(v, b, m, B);
+            archivo->archivar(v, b, m, k, recarga);
+        }
+    }
+
+    /**
+     * @brief Devuelve el tramo archivado (decuantizado) al frente de la lista.
+     *        Solo al cambiar de modo: los lectores usan recorrerHistorial()
+     *        o la vista, para no cuantizar dos veces la misma lectura.
+     */
+    void desarchivar() {
+        invalidarVista();
+        ListaSensor<float> previas;
+        archivo->volcarEn(previas);
+        archivo->vaciar();
+        previas.anexarLista(historial);
+        historial.anexarLista(previas);
+    }
+
+    double sumaHistorial() const {
+        return (double)historial.sum() + (archivo ? archivo->suma() : 0.0);
+    }
+
+public:
+    SensorTemperatura(const char* id) : SensorBase(id), archivo(NULL), archivadasAlVaciar(0) {}
+
+    virtual ~SensorTemperatura() {
+        printf("  [Destructor Sensor %s] Liberando Lista Interna (float)...\n", nombre);
+        // historial.clear() se llama en su destructor automáticamente.
+        delete archivo;
+    }
+
+    /**
+     * @brief Guarda el tramo frío del historial cuantizado (modo 0 lo
+     *        devuelve a nodos float). No se combina con el archivo mapeado,
+     *        que borra por valor exacto, ni con la compresión por quiebres.
+     *        La configuración no viaja en las instantáneas (como el filtro
+     *        y el compresor); la migración la reaplica con la cota del
+     *        origen en `errorHeredado`.
+     * @return false si el sensor no admite la cuantización.
+     */
+    bool configurarCuantizacion(int modo, double errorHeredado = 0.0) {
+        if (modo != 0 && (persistente || compresor)) return false;
+        asegurarResidente();
+        double errorPrevio = errorHeredado;
+        if (archivo) {
+            errorPrevio = archivo->getErrorMax();
+            desarchivar();
+            delete archivo;
+            archivo = NULL;
+        }
+        if (modo == 0) return true;
+        archivo = new ArchivoCuantizado((ArchivoCuantizado::Modo)modo);
+        archivo->heredarError(errorPrevio);
+        archivarFrio();
+        marcarReescritura();
+        return true;
+    }
+
+    bool estaCuantizado() const { return archivo != NULL; }
+
+    int modoCuantizacion() const { return archivo ? (int)archivo->getModo() : 0; }
+
+    double errorCuantizacion() const { return archivo ? archivo->getErrorMax() : 0.0; }
+
+    void agregar(float v) {
+        asegurarResidente();
+        if (registroDetallado()) printf("[Log] Insertando Nodo<float> en %s.\n", nombre);
+        unsigned char b = evaluarCalidad((double)v);
+        long long marca = relojEpochMs();
+        guardar(v, b, marca);
+        notificarLectura((double)v, marca);
+    }
+
+    /**
+     * @brief Guarda la lectura (o los quiebres que libera el compresor) en el
+     *        historial, el archivo mapeado y la réplica.
+     */
+    void guardar(float v, unsigned char b, long long& marca) {
+        invalidarVista();
+        if (!compresor) {
+            historial.push_back(v, b, marca);
+            persistirLectura(&v, b, marca);
+            replicarLectura(&v, b, marca);
+            if (archivo && historial.size() >= 2 * ArchivoCuantizado::BLOQUE) archivarFrio();
+            return;
+        }
+        CompresorHistorial::PuntoQuiebre q[2];
+        int n = compresor->agregar((double)v, b, marca, q);
+        for (int i = 0; i < n; ++i) guardarQuiebre(q[i]);
+    }
+
+    virtual void guardarQuiebre(const CompresorHistorial::PuntoQuiebre& q) {
+        invalidarVista();
+        float x = (float)q.valor;
+        historial.push_back(x, q.banderas, q.marcaMs);
+        persistirLectura(&x, q.banderas, q.marcaMs);
+        replicarLectura(&x, q.banderas, q.marcaMs);
+    }
+
+    virtual void reproducirLectura(const unsigned char* valor, unsigned char banderas, long long marcaMs) {
+        asegurarResidente();
+        invalidarVista();
+        float v;
+        std::memcpy(&v, valor, sizeof(v));
+        historial.push_back(v, banderas, marcaMs);
+        persistirLectura(&v, banderas, marcaMs);
+        notificarLectura((double)v, marcaMs);
+    }
+
+    /**
+     * @brief Historial crudo; si estaba desbordado vuelve a memoria. Con
+     *        archivo cuantizado devuelve una vista decuantizada que se arma
+     *        una vez por cambio del historial; el archivo queda intacto.
+     *        Para solo recorrer, recorrerHistorial() no expande nada.
+     */
+    const ListaSensor<float>& getHistorial() const {
+        const_cast<SensorTemperatura*>(this)->asegurarResidente(); // paginación lógica, no cambia el valor
+        if (!archivo || !archivo->size()) return historial;
+        if (!vista.size()) {
+            archivo->volcarEn(vista);
+            for (const ListaSensor<float>::Nodo* x = historial.primero(); x; x = x->siguiente)
+                vista.push_back(x->dato, x->banderas, x->marcaMs);
+        }
+        return vista;
+    }
+
+    /**
+     * @brief f(valor, banderas, marcaMs) por cada lectura en orden: primero
+     *        el archivo bloque a bloque, luego la lista.
+     */
+    template <typename F>
+    void recorrerHistorial(F& f) const {
+        if (recorrerMapeado<float>(f)) return;
+        const_cast<SensorTemperatura*>(this)->asegurarResidente();
+        if (archivo) archivo->recorrer(f);
+        for (const ListaSensor<float>::Nodo* x = historial.primero(); x; x = x->siguiente)
+            f(x->dato, x->banderas, x->marcaMs);
+    }
+
+    virtual size_t lecturasHistorial() const { return historial.size() + (archivo ? archivo->size() : 0); }
+
+    virtual size_t bytesResidentes() const {
+        return historial.bytes() + suavizado.bytes() + vista.bytes() + (archivo ? archivo->bytes() : 0);
+    }
+
+    virtual TipoSensor tipoSensor() const { return TIPO_TEMPERATURA; }
+
+    virtual bool registrarDesdeTexto(const char* texto) {
+        // Texto esperado: número float, e.g. "45.3"
+        if (!texto) return false;
+        float v = 0.0f;
+        if (std::sscanf(texto, "%f", &v) == 1) {
+            agregar(v);
+            return true;
+        }
+        return false;
+    }
+
+    virtual void procesarLectura() {
+        asegurarResidente();
+        printf("-> Procesando Sensor %s (Temperatura)...\n", nombre);
+        if (lecturasHistorial() == 0) {
+            printf("[Sensor Temp] No hay lecturas.\n");
+            return;
+        }
+
+        // Con compresión no hay lecturas sueltas que eliminar: se promedia la
+        // señal reconstruida recorriendo solo los quiebres.
+        if (compresor) {
+            double promedio = 0.0;
+            compresor->promedioReconstruido(historial, promedio);
+            printf("[Sensor Temp] Promedio de la senal reconstruida: %.3f (%zu quiebres, %zu lecturas).\n",
+                   promedio, historial.size(), compresor->crudas);
+            return;
+        }
+
+        // Eliminar mínima y reportar promedio del resto
+        float eliminado = 0.0f;
+        bool ok;
+        size_t bloque = 0, pos = 0;
+        float enLista = 0.0f;
+        invalidarVista();
+        if (archivo && archivo->minimo(eliminado, bloque, pos) &&
+            !(historial.minimo(enLista) && enLista < eliminado)) {
+            archivo->borrar(bloque, pos);
+            ok = true;
+        } else {
+            ok = historial.pop_min(eliminado);
+        }
+        if (ok) {
+            persistirBorrado(&eliminado);
+            replicarProcesado();
+            marcarReescritura();
+            size_t n = lecturasHistorial();
+            float promedio = (n > 0) ? (float)(sumaHistorial() / (double)n) : 0.0f;
+            printf("[Sensor Temp] Lectura más baja (%.3f) eliminada. Promedio restante: %.3f.\n",
+                   eliminado, promedio);
+        } else {
+            // Si no pudo eliminar, solo computa promedio
+            size_t n = lecturasHistorial();
+            float promedio = (n > 0) ? (float)(sumaHistorial() / (double)n) : 0.0f;
+            printf("[Sensor Temp] Promedio calculado sobre %zu lectura(s): %.3f.\n", n, promedio);
+        }
+    }
+
+    virtual void imprimirInfo() const {
+        printf("[%s] (Temperatura)\n", nombre);
+        imprimirSuavizado();
+        calidad.imprimir();
+        if (compresor) compresor->imprimir();
+        if (boceto) boceto->imprimir();
+        if (secuencia) secuencia->imprimir();
+        if (porHidratar) {
+            printf("    Historial persistente sin cargar: %u lecturas\n",
+                   persistente->entrada(indicePersistente).vivas);
+            return;
+        }
+        if (desborde) {
+            printf("    Historial en disco: %zu lecturas (%zu bytes)\n",
+                   desbordadasHistorial, bytesEnDisco);
+            return;
+        }
+        printf("    Marcadas en historial: %zu de %zu\n",
+               historial.contarConBandera(CalidadDatos::REPETIDO | CalidadDatos::HUECO |
+                                          CalidadDatos::PICO),
+               historial.size());
+        if (archivo) archivo->imprimir();
+    }
+
+protected:
+    virtual size_t escribirHistorial(FILE* f, size_t desde = 0) const {
+        size_t archivadas = archivo ? archivo->size() : 0;
+        size_t total = archivadas + historial.size();
+        if (desde > total) return (size_t)-1;
+        bool ok = desde < archivadas
+            ? archivo->escribir(f, desde) && historial.volcar(f, 0)
+            : historial.volcar(f, desde - archivadas);
+        return ok ? total - desde : (size_t)-1;
+    }
+
+    virtual void vaciarHistorial() {
+        invalidarVista();
+        historial.clear();
+        archivadasAlVaciar = archivo ? archivo->size() : 0;
+        if (archivo) archivo->vaciar();
+    }
+
+    /**
+     * @brief Con archivo cuantizado (vuelta del desborde) las lecturas que
+     *        estaban archivadas vuelven directo al archivo, sin pasar por
+     *        nodos float; las demás siguen el camino de agregar().
+     */
+    virtual bool cargarHistorial(FILE* f, size_t cnt) {
+        invalidarVista();
+        if (!archivo) return historial.restaurar(f, cnt);
+        const size_t B = ArchivoCuantizado::BLOQUE;
+        float v[B];
+        unsigned char b[B];
+        long long m[B];
+        bool ok = true;
+        size_t archivadas = historial.size() == 0 && archivadasAlVaciar < cnt ? archivadasAlVaciar : 0;
+        archivadasAlVaciar = 0;
+        while (ok && archivadas) {
+            size_t k = archivadas < B ? archivadas : B;
+            for (size_t i = 0; ok && i < k; ++i) ok = ListaSensor<float>::leerRegistro(f, v[i], b[i], m[i]);
+            if (ok) archivo->archivar(v, b, m, k, true);
+            archivadas -= k;
+            cnt -= k;
+        }
+        archivo->cerrarRecarga();
+        ok = ok && historial.restaurar(f, cnt);
+        archivarFrio();
+        return ok;
+    }
+
+    virtual size_t bytesPorLectura() const { return ListaSensor<float>::bytesPorRegistro(); }
+
+    virtual void cargarCrudo(const unsigned char* valor, unsigned char banderas, long long marcaMs) {
+        invalidarVista();
+        float v;
+        std::memcpy(&v, valor, sizeof(v));
+        historial.push_back(v, banderas, marcaMs);
+    }
+};
+
+/**
+ * @brief Sensor concreto: Presión (usa int).
+ *  - Contiene ListaSensor<int> historial
+ *  - Procesamiento: Calcula promedio de lecturas (sin eliminar).
+ */
+class SensorPresion : public SensorBase {
+private:
+    ListaSensor<int> historial;
+
+public:
+    SensorPresion(const char* id) : SensorBase(id) {}
+
+    virtual ~SensorPresion() {
+        printf("  [Destructor Sensor %s] Liberando Lista Interna (int)...\n", nombre);
+        // historial.clear() en destructor
+    }
+
+    void agregar(int v) {
+        asegurarResidente();
+        if (registroDetallado()) printf("[Log] Insertando Nodo<int> en %s.\n", nombre);
+        unsigned char b = evaluarCalidad((double)v);
+        long long marca = relojEpochMs();
+        guardar(v, b, marca);
+        notificarLectura((double)v, marca);
+    }
+
+    /**
+     * @brief Guarda la lectura (o los quiebres que libera el compresor) en el
+     *        historial, el archivo mapeado y la réplica.
+     */
+    void guardar(int v, unsigned char b, long long& marca) {
+        if (!compresor) {
+            historial.push_back(v, b, marca);
+            persistirLectura(&v, b, marca);
+            replicarLectura(&v, b, marca);
+            return;
+        }
+        CompresorHistorial::PuntoQuiebre q[2];
+        int n = compresor->agregar((double)v, b, marca, q);
+        for (int i = 0; i < n; ++i) guardarQuiebre(q[i]);
+    }
+
+    virtual void guardarQuiebre(const CompresorHistorial::PuntoQuiebre& q) {
+        int x = (int)q.valor;
+        historial.push_back(x, q.banderas, q.marcaMs);
+        persistirLectura(&x, q.banderas, q.marcaMs);
+        replicarLectura(&x, q.banderas, q.marcaMs);
+    }
+
+    virtual void reproducirLectura(const unsigned char* valor, unsigned char banderas, long long marcaMs) {
+        asegurarResidente();
+        int v;
+        std::memcpy(&v, valor, sizeof(v));
+        historial.push_back(v, banderas, marcaMs);
+        persistirLectura(&v, banderas, marcaMs);
+        notificarLectura((double)v, marcaMs);
+    }
+
+    /**
+     * @brief Historial crudo; si estaba desbordado vuelve a memoria.
+     */
+    const ListaSensor<int>& getHistorial() const {
+        const_cast<SensorPresion*>(this)->asegurarResidente(); // paginación lógica, no cambia el valor
+        return historial;
+    }
+
+    /// f(valor, banderas, marcaMs) por cada lectura en orden.
+    template <typename F>
+    void recorrerHistorial(F& f) const {
+        if (recorrerMapeado<int>(f)) return;
+        const ListaSensor<int>& h = getHistorial();
+        for (const ListaSensor<int>::Nodo* x = h.primero(); x; x = x->siguiente) f(x->dato, x->banderas, x->marcaMs);
+    }
+
+    virtual size_t lecturasHistorial() const { return historial.size(); }
+
+    virtual size_t bytesResidentes() const { return historial.bytes() + suavizado.bytes(); }
+
+    virtual TipoSensor tipoSensor() const { return TIPO_PRESION; }
+
+    virtual bool registrarDesdeTexto(const char* texto) {
+        // Texto esperado: número entero, e.g. "85"
+        if (!texto) return false;
+        int v = 0;
+        if (std::sscanf(texto, "%d", &v) == 1) {
+            agregar(v);
+            return true;
+        }
+        return false;
+    }
+
+    virtual void procesarLectura() {
+        asegurarResidente();
+        printf("-> Procesando Sensor %s (Presion)...\n", nombre);
+        size_t n = historial.size();
+        if (n == 0) {
+            printf("[Sensor Presion] No hay lecturas.\n");
+            return;
+        }
+        if (compresor) {
+            double promedio = 0.0;
+            compresor->promedioReconstruido(historial, promedio);
+            printf("[Sensor Presion] Promedio de la senal reconstruida: %.3f (%zu quiebres, %zu lecturas).\n",
+                   promedio, n, compresor->crudas);
+            return;
+        }
+        int s = historial.sum();
+        float promedio = (float)s / (float)n;
+        printf("[Sensor Presion] Promedio de lecturas: %.3f (sobre %zu lecturas).\n", promedio, n);
+    }
+
+    virtual void imprimirInfo() const {
+        printf("[%s] (Presion)\n", nombre);
+        imprimirSuavizado();
+        calidad.imprimir();
+        if (compresor) compresor->imprimir();
+        if (boceto) boceto->imprimir();
+        if (secuencia) secuencia->imprimir();
+        if (porHidratar) {
+            printf("    Historial persistente sin cargar: %u lecturas\n",
+                   persistente->entrada(indicePersistente).vivas);
+            return;
+        }
+        if (desborde) {
+            printf("    Historial en disco: %zu lecturas (%zu bytes)\n",
+                   desbordadasHistorial, bytesEnDisco);
+            return;
+        }
+        printf("    Marcadas en historial: %zu de %zu\n",
+               historial.contarConBandera(CalidadDatos::REPETIDO | CalidadDatos::HUECO |
+                                          CalidadDatos::PICO),
+               historial.size());
+    }
+
+protected:
+    virtual size_t escribirHistorial(FILE* f, size_t desde = 0) const {
+        if (desde > historial.size()) return (size_t)-1;
+        return historial.volcar(f, desde) ? historial.size() - desde : (size_t)-1;
+    }
+
+    virtual void vaciarHistorial() { historial.clear(); }
+
+    virtual bool cargarHistorial(FILE* f, size_t cnt) { return historial.restaurar(f, cnt); }
+
+    virtual size_t bytesPorLectura() const { return ListaSensor<int>::bytesPorRegistro(); }
+
+    virtual void cargarCrudo(const unsigned char* valor, unsigned char banderas, long long marcaMs) {
+        int v;
+        std::memcpy(&v, valor, sizeof(v));
+        historial.push_back(v, banderas, marcaMs);
+    }
+};
+
+/**
+ * @brief Fábrica de sensores concretos por tipo (reconstrucción y réplicas).
+ */
+inline SensorBase* crearSensor(TipoSensor tipo, const char* id) {
+    if (tipo == TIPO_TEMPERATURA) return new SensorTemperatura(id);
+    if (tipo == TIPO_PRESION) return new SensorPresion(id);
+    return NULL;
+}
+
+/**
+ * @brief Lee un sensor serializado con escribirInstantanea() (tipo, nombre,
+ *        cuenta, historial). Retorna NULL si el registro está incompleto.
+ */
+inline SensorBase* leerSensorInstantanea(FILE* f) {
+    unsigned char tipo = 0;
+    char id[50];
+    unsigned long long cnt = 0;
+    if (std::fread(&tipo, 1, 1, f) != 1 || std::fread(id, sizeof(id), 1, f) != 1 ||
+        std::fread(&cnt, sizeof(cnt), 1, f) != 1) return NULL;
+    id[sizeof(id) - 1] = '\0';
+    SensorBase* s = crearSensor((TipoSensor)tipo, id);
+    if (s && !s->leerInstantanea(f, (size_t)cnt)) {
+        delete s;
+        return NULL;
+    }
+    return s;
+}
+
+/* ============================================================
+ *        Alineación temporal de series (as-of y remuestreo)
+ * ============================================================*/
+
+/**
+ * @brief Join por tiempo de dos historiales ordenados por marcaMs, en una
+ *        sola pasada de mezcla y sin copiar ninguno de los dos.
+ * @details Para cada lectura de `izq` elige la última de `der` con marca
+ *          <= (as-of) o, si `cercano`, la más próxima de cualquier lado.
+ *          Los pares a más de `toleranciaMs` (si es >= 0) se omiten. Cada
+ *          par se entrega a `visitar(marca, valorIzq, valorDer)`, así el
+ *          consumidor (correlación, CSV) decide si materializa algo.
+ * @return Pares entregados.
+ */
+template <typename A, typename B, typename Visitante>
+size_t unirPorTiempo(const ListaSensor<A>& izq, const ListaSensor<B>& der, bool cercano,
+                     long long toleranciaMs, Visitante& visitar) {
+    const typename ListaSensor<B>::Nodo* siguiente = der.primero();
+    const typename ListaSensor<B>::Nodo* previo = NULL;
+    size_t pares = 0;
+    for (const typename ListaSensor<A>::Nodo* i = izq.primero(); i; i = i->siguiente) {
+        while (siguiente && siguiente->marcaMs <= i->marcaMs) {
+            previo = siguiente;
+            siguiente = siguiente->siguiente;
+        }
+        const typename ListaSensor<B>::Nodo* elegido = previo;
+        if (cercano && siguiente &&
+            (!previo || siguiente->marcaMs - i->marcaMs < i->marcaMs - previo->marcaMs)) elegido = siguiente;
+        if (!elegido) continue;
+        long long distancia = elegido->marcaMs - i->marcaMs;
+        if (distancia < 0) distancia = -distancia;
+        if (toleranciaMs >= 0 && distancia > toleranciaMs) continue;
+        visitar(i->marcaMs, (double)i->dato, (double)elegido->dato);
+        pares++;
+    }
+    return pares;
+}
+
+/**
+ * @brief Interpola linealmente el historial en la grilla
+ *        inicio + k * paso (k < n) y escribe los valores en `salida`.
+ * @details Recorre la lista una vez; los puntos de la grilla entre dos
+ *          lecturas se llenan en un bucle aritmético sin ramas que el
+ *          compilador vectoriza. Fuera del rango del historial se repite
+ *          la lectura extrema.
+ * @return Puntos de la grilla dentro del rango del historial.
+ */
+template <typename T>
+size_t remuestrear(const ListaSensor<T>& h, long long inicio, long long paso, size_t n, double* salida) {
+    const typename ListaSensor<T>::Nodo* a = h.primero();
+    if (!a || n == 0 || paso <= 0) return 0;
+    size_t k = 0, dentro = 0;
+    while (k < n && inicio + (long long)k * paso < a->marcaMs) salida[k++] = (double)a->dato;
+    for (const typename ListaSensor<T>::Nodo* b = a->siguiente; b && k < n; a = b, b = b->siguiente) {
+        long long t = inicio + (long long)k * paso;
+        if (t >= b->marcaMs) continue;
+        size_t m = (size_t)((b->marcaMs - t + paso - 1) / paso);
+        if (m > n - k) m = n - k;
+        double va = (double)a->dato;
+        double pendiente = ((double)b->dato - va) / (double)(b->marcaMs - a->marcaMs);
+        double desde = (double)(t - a->marcaMs), dt = (double)paso;
+        double* out = salida + k;
+        for (size_t j = 0; j < m; ++j) out[j] = va + pendiente * (desde + dt * (double)j);
+        k += m;
+        dentro += m;
+    }
+    for (; k < n; ++k) {
+        if (inicio + (long long)k * paso == a->marcaMs) dentro++;
+        salida[k] = (double)a->dato;
+    }
+    return dentro;
+}
+
+/**
+ * @brief Marcas de la primera y la última lectura. false si está vacío.
+ */
+template <typename T>
+bool rangoMarcas(const ListaSensor<T>& h, long long& primera, long long& ultima) {
+    const typename ListaSensor<T>::Nodo* x = h.primero();
+    if (!x) return false;
+    primera = x->marcaMs;
+    for (; x; x = x->siguiente) ultima = x->marcaMs;
+    return true;
+}
+
+/**
+ * @brief Lo mismo que rangoMarcas() como visitante de recorrerHistorial().
+ */
+struct RangoMarcas {
+    bool hay;
+    long long primera, ultima;
+
+    RangoMarcas() : hay(false), primera(0), ultima(0) {}
+
+    template <typename T>
+    void operator()(T, unsigned char, long long m) {
+        if (!hay) primera = m;
+        ultima = m;
+        hay = true;
+    }
+};
+
+/**
+ * @brief Visitante que vuelca cada lectura en un agregado (ResumenCluster
+ *        o ResumenSensorCluster) con su agregar() del tipo del sensor.
+ */
+template <typename R>
+struct AgregarLecturas {
+    R& r;
+    explicit AgregarLecturas(R& destino) : r(destino) {}
+    template <typename T>
+    void operator()(T v, unsigned char, long long) { r.agregar(v); }
+};
+
+/**
+ * @brief Correlación de Pearson acumulada par a par (visitante de
+ *        unirPorTiempo) o sobre columnas ya alineadas.
+ */
+struct CorrelacionAlineada {
+    size_t n;
+    double sa, sb, saa, sbb, sab;
+
+    CorrelacionAlineada() : n(0), sa(0.0), sb(0.0), saa(0.0), sbb(0.0), sab(0.0) {}
+
+    void operator()(long long, double a, double b) {
+        n++;
+        sa += a; sb += b;
+        saa += a * a; sbb += b * b; sab += a * b;
+    }
+
+    void columnas(const double* a, const double* b, size_t cnt) {
+        double xa = 0.0, xb = 0.0, xaa = 0.0, xbb = 0.0, xab = 0.0;
+        for (size_t i = 0; i < cnt; ++i) {
+            xa += a[i]; xb += b[i];
+            xaa += a[i] * a[i]; xbb += b[i] * b[i]; xab += a[i] * b[i];
+        }
+        n += cnt;
+        sa += xa; sb += xb; saa += xaa; sbb += xbb; sab += xab;
+    }
+
+    /// 0 si alguna de las series es constante o hay menos de 2 pares.
+    double pearson() const {
+        if (n < 2) return 0.0;
+        double cov = sab - sa * sb / (double)n;
+        double va = saa - sa * sa / (double)n, vb = sbb - sb * sb / (double)n;
+        return va > 0.0 && vb > 0.0 ? cov / (std::sqrt(va) * std::sqrt(vb)) : 0.0;
+    }
+};
+
+/**
+ * @brief Visitante que escribe los pares alineados como CSV
+ *        (marca_ms,izquierda,derecha).
+ */
+struct CsvAlineado {
+    FILE* f;
+    bool ok;
+
+    explicit CsvAlineado(FILE* f) : f(f), ok(f != NULL) {}
+
+    void operator()(long long marca, double a, double b) {
+        if (ok && std::fprintf(f, "%lld,%.6g,%.6g\n", marca, a, b) < 0) ok = false;
+    }
+};
+
+/// Aplica dos visitantes a cada par en la misma pasada.
+template <typename V1, typename V2>
+struct VisitanteDoble {
+    V1& uno;
+    V2& dos;
+    VisitanteDoble(V1& a, V2& b) : uno(a), dos(b) {}
+    void operator()(long long m, double a, double b) {
+        uno(m, a, b);
+        dos(m, a, b);
+    }
+};
+
+/* ============================================================
+ *     Mezcla k-vías de historiales en orden de tiempo global
+ * ============================================================*/
+
+/**
+ * @brief Iterador por lotes que mezcla K historiales ordenados por marcaMs
+ *        en un único flujo ordenado (empates por handle), con un árbol de
+ *        perdedores.
+ * @details Cada lectura emitida cuesta log2(K) comparaciones contra los
+ *          perdedores guardados en el camino hoja-raíz, sin volver a mirar
+ *          hermanos como un montículo. Con nodos insertados en orden de
+ *          llegada (arena o heap), el recorrido de la mezcla es casi
+ *          secuencial en memoria; además se precarga el nodo siguiente de
+ *          la fuente que avanza. La ventana [desde, hasta) permite partir
+ *          la mezcla por tiempo: particionar() ubica el inicio de cada
+ *          partición en una pasada y volcarParticionado() mezcla cada una
+ *          en un proceso hijo (fork), escribiendo con pwrite() en su tramo
+ *          del archivo.
+ */
+class MezclaKVias {
+public:
+    /// Registro emitido (24 bytes, también el formato en disco).
+    struct Lectura {
+        long long marcaMs;
+        double valor;
+        unsigned handle;
+        unsigned char tipo;      ///< TipoSensor
+        unsigned char banderas;
+    };
+
+    /// Historial de entrada: nodo actual de un ListaSensor<float> o <int>.
+    struct Fuente {
+        const void* nodo;
+        long long marca;         ///< Marca del nodo actual (FIN = agotada)
+        long long ultima;        ///< Marca del último nodo (para particionar)
+        unsigned handle;
+        unsigned char tipo;
+    };
+
+    static const long long FIN = 0x7FFFFFFFFFFFFFFFLL;
+
+private:
+    Fuente* fuentes;
+    size_t k;
+    size_t* perdedores;   ///< [0] = ganador; [1..k-1] = perdedor de cada nodo interno
+    long long hasta;
+    unsigned long long emitidas;
+
+    MezclaKVias(const MezclaKVias&);
+    MezclaKVias& operator=(const MezclaKVias&);
+
+    static long long marcaDe(const void* n, unsigned char tipo) {
+        return tipo == TIPO_TEMPERATURA ? static_cast<const ListaSensor<float>::Nodo*>(n)->marcaMs
+                                        : static_cast<const ListaSensor<int>::Nodo*>(n)->marcaMs;
+    }
+
+    long long marcaVisible(const void* n, unsigned char tipo) const {
+        if (!n) return FIN;
+        long long m = marcaDe(n, tipo);
+        return m < hasta ? m : FIN;
+    }
+
+    bool antes(size_t a, size_t b) const {
+        const Fuente& x = fuentes[a];
+        const Fuente& y = fuentes[b];
+        return x.marca < y.marca || (x.marca == y.marca && x.handle < y.handle);
+    }
+
+    /// Copia la lectura actual de la fuente y avanza al nodo siguiente.
+    void avanzar(Fuente& f, Lectura& out) {
+        out.marcaMs = f.marca;
+        out.handle = f.handle;
+        out.tipo = f.tipo;
+        const void* sig;
+        if (f.tipo == TIPO_TEMPERATURA) {
+            const ListaSensor<float>::Nodo* n = static_cast<const ListaSensor<float>::Nodo*>(f.nodo);
+            out.valor = n->dato;
+            out.banderas = n->banderas;
+            sig = n->siguiente;
+        } else {
+            const ListaSensor<int>::Nodo* n = static_cast<const ListaSensor<int>::Nodo*>(f.nodo);
+            out.valor = n->dato;
+            out.banderas = n->banderas;
+            sig = n->siguiente;
+        }
+        if (sig) __builtin_prefetch(static_cast<const ListaSensor<float>::Nodo*>(sig)->siguiente);
+        f.nodo = sig;
+        f.marca = marcaVisible(sig, f.tipo);
+    }
+
+    void rejugar(size_t hoja) {
+        size_t ganador = hoja;
+        for (size_t nodo = (hoja + k) >> 1; nodo > 0; nodo >>= 1) {
+            if (antes(perdedores[nodo], ganador)) {
+                size_t t = perdedores[nodo];
+                perdedores[nodo] = ganador;
+                ganador = t;
+            }
+        }
+        perdedores[0] = ganador;
+    }
+
+public:
+    /**
+     * @param iniciales Fuentes con `nodo` en la primera lectura >= desde.
+     * @param hasta Marca final exclusiva (FIN = sin límite).
+     */
+    MezclaKVias(const Fuente* iniciales, size_t cuantas, long long hasta = FIN)
+        : fuentes(new Fuente[cuantas ? cuantas : 1]), k(cuantas),
+          perdedores(new size_t[cuantas ? cuantas : 1]), hasta(hasta), emitidas(0) {
+        for (size_t i = 0; i < k; ++i) {
+            fuentes[i] = iniciales[i];
+            fuentes[i].marca = marcaVisible(fuentes[i].nodo, fuentes[i].tipo);
+        }
+        if (k == 0) return;
+        // Torneo inicial de abajo hacia arriba: hojas en [k, 2k).
+        size_t* ganadores = new size_t[2 * k];
+        for (size_t i = 0; i < k; ++i) ganadores[k + i] = i;
+        for (size_t n = k - 1; n > 0; --n) {
+            size_t a = ganadores[2 * n], b = ganadores[2 * n + 1];
+            bool ganaA = antes(a, b);
+            ganadores[n] = ganaA ? a : b;
+            perdedores[n] = ganaA ? b : a;
+        }
+        perdedores[0] = ganadores[k > 1 ? 1 : k];
+        delete[] ganadores;
+    }
+
+    ~MezclaKVias() {
+        delete[] fuentes;
+        delete[] perdedores;
+    }
+
+    unsigned long long getEmitidas() const { return emitidas; }
+
+    /**
+     * @brief Llena `lote` con hasta `max` lecturas en orden global.
+     * @return Lecturas escritas (0 = mezcla terminada).
+     */
+    size_t siguienteLote(Lectura* lote, size_t max) {
+        size_t c = 0;
+        while (c < max && k) {
+            size_t g = perdedores[0];
+            if (fuentes[g].marca == FIN) break;
+            avanzar(fuentes[g], lote[c++]);
+            rejugar(g);
+        }
+        emitidas += c;
+        return c;
+    }
+
+    /**
+     * @brief Divide [primera marca, última marca] en `partes` tramos de igual
+     *        duración y, en una pasada por cada historial, ubica dónde
+     *        empieza cada tramo.
+     * @param limites Salida de partes + 1 marcas (la última, exclusiva).
+     * @param inicios Salida de partes * k fuentes (tramo p en [p*k, (p+1)*k)).
+     * @param cuentas Salida de lecturas por tramo.
+     * @return Índice del primer historial con marcas fuera de orden, o k si
+     *         todos están ordenados (los tramos solo valen en ese caso).
+     */
+    static size_t particionar(const Fuente* f, size_t k, size_t partes, long long* limites, Fuente* inicios,
+                              unsigned long long* cuentas) {
+        long long menor = FIN, mayor = -FIN;
+        for (size_t i = 0; i < k; ++i) {
+            if (!f[i].nodo) continue;
+            long long m = marcaDe(f[i].nodo, f[i].tipo);
+            if (m < menor) menor = m;
+            if (f[i].ultima > mayor) mayor = f[i].ultima;
+        }
+        if (menor > mayor) menor = mayor = 0;
+        double ancho = (double)(mayor - menor + 1) / (double)partes;
+        for (size_t p = 0; p <= partes; ++p) limites[p] = menor + (long long)(ancho * (double)p);
+        limites[partes] = mayor + 1;
+        for (size_t p = 0; p < partes; ++p) cuentas[p] = 0;
+        size_t desordenada = k;
+        for (size_t i = 0; i < k; ++i) {
+            for (size_t p = 0; p < partes; ++p) {
+                inicios[p * k + i] = f[i];
+                inicios[p * k + i].nodo = NULL;
+            }
+            size_t p = 0;
+            bool abierto = false;
+            long long previa = -FIN;
+            for (const void* n = f[i].nodo; n;) {
+                long long m = marcaDe(n, f[i].tipo);
+                if (m < previa && desordenada == k) desordenada = i;
+                previa = m;
+                while (p + 1 < partes && m >= limites[p + 1]) { p++; abierto = false; }
+                if (!abierto) {
+                    inicios[p * k + i].nodo = n;
+                    abierto = true;
+                }
+                cuentas[p]++;
+                n = f[i].tipo == TIPO_TEMPERATURA ? (const void*)static_cast<const ListaSensor<float>::Nodo*>(n)->siguiente
+                                                  : (const void*)static_cast<const ListaSensor<int>::Nodo*>(n)->siguiente;
+            }
+        }
+        return desordenada;
+    }
+
+    /**
+     * @brief Mezcla las fuentes en `partes` procesos hijos por tramo de
+     *        tiempo y escribe el flujo ordenado en fd a partir de `base`.
+     * @details Un historial fuera de orden no cabe en tramos de tiempo: en
+     *          ese caso se mezcla todo en un solo tramo (que emite todas las
+     *          lecturas; el orden global vale solo entre las ordenadas).
+     * @param desordenada Si no es NULL, recibe el índice del primer historial
+     *        fuera de orden, o k si no hay ninguno.
+     * @return Lecturas escritas, o -1 si falló algún tramo.
+     */
+    static long long volcarParticionado(const Fuente* f, size_t k, size_t partes, int fd, off_t base,
+                                        size_t* desordenada = NULL) {
+        if (partes == 0) partes = 1;
+        long long* limites = new long long[partes + 1];
+        Fuente* inicios = new Fuente[partes * (k ? k : 1)];
+        unsigned long long* cuentas = new unsigned long long[partes];
+        size_t fuera = particionar(f, k, partes, limites, inicios, cuentas);
+        if (fuera < k && partes > 1) {
+            partes = 1;
+            particionar(f, k, partes, limites, inicios, cuentas);
+        }
+        // `ultima` es la última marca, no la mayor: sin orden, sin tope.
+        if (fuera < k) limites[1] = FIN;
+        if (desordenada) *desordenada = fuera;
+
+        pid_t* hijos = new pid_t[partes];
+        off_t offset = base;
+        unsigned long long total = 0;
+        bool ok = true;
+        for (size_t p = 0; p < partes; ++p) {
+            hijos[p] = fork();
+            if (hijos[p] == 0) {
+                const size_t LOTE = 4096;
+                Lectura* lote = new Lectura[LOTE];
+                MezclaKVias m(inicios + p * k, k, limites[p + 1]);
+                off_t pos = offset;
+                size_t c;
+                while ((c = m.siguienteLote(lote, LOTE)) > 0) {
+                    size_t bytes = c * sizeof(Lectura);
+                    if (pwrite(fd, lote, bytes, pos) != (ssize_t)bytes) _exit(1);
+                    pos += (off_t)bytes;
+                }
+                _exit(m.getEmitidas() == cuentas[p] ? 0 : 2);
+            }
+            if (hijos[p] < 0) ok = false;
+            offset += (off_t)(cuentas[p] * sizeof(Lectura));
+            total += cuentas[p];
+        }
+        for (size_t p = 0; p < partes; ++p) {
+            int estado = 0;
+            if (hijos[p] > 0 && (waitpid(hijos[p], &estado, 0) < 0 || !WIFEXITED(estado) || WEXITSTATUS(estado) != 0))
+                ok = false;
+        }
+        delete[] hijos;
+        delete[] limites;
+        delete[] inicios;
+        delete[] cuentas;
+        return ok ? (long long)total : -1;
+    }
+};
+
+/**
+ * @brief Agregados combinables de un conjunto de sensores; cada trabajador
+ *        del modo cluster calcula el suyo y el router los combina.
+ */
+struct ResumenCluster {
+    unsigned long long sensores;
+    unsigned long long lecturasTemp, lecturasPres;
+    unsigned long long rechazadas;   ///< Líneas que el trabajador no pudo aplicar
+    double sumaTemp, minTemp, maxTemp;
+    long long sumaPres;
+    int minPres, maxPres;
+    HistogramaLatencia latenciaLote; ///< Tiempo de aplicar cada lote de líneas
+
+    ResumenCluster()
+        : sensores(0), lecturasTemp(0), lecturasPres(0), rechazadas(0), sumaTemp(0.0),
+          minTemp(1e300), maxTemp(-1e300), sumaPres(0), minPres(0x7fffffff), maxPres(-0x7fffffff) {}
+
+    void agregarTemp(float v) {
+        lecturasTemp++;
+        sumaTemp += v;
+        if (v < minTemp) minTemp = v;
+        if (v > maxTemp) maxTemp = v;
+    }
+
+    void agregarPres(int v) {
+        lecturasPres++;
+        sumaPres += v;
+        if (v < minPres) minPres = v;
+        if (v > maxPres) maxPres = v;
+    }
+
+    /// Según el tipo del historial (visitante AgregarLecturas).
+    void agregar(float v) { agregarTemp(v); }
+    void agregar(int v) { agregarPres(v); }
+
+    void combinar(const ResumenCluster& o) {
+        sensores += o.sensores;
+        lecturasTemp += o.lecturasTemp;
+        lecturasPres += o.lecturasPres;
+        rechazadas += o.rechazadas;
+        sumaTemp += o.sumaTemp;
+        sumaPres += o.sumaPres;
+        if (o.minTemp < minTemp) minTemp = o.minTemp;
+        if (o.maxTemp > maxTemp) maxTemp = o.maxTemp;
+        if (o.minPres < minPres) minPres = o.minPres;
+        if (o.maxPres > maxPres) maxPres = o.maxPres;
+        latenciaLote.combinar(o.latenciaLote);
+    }
+
+    void imprimir() const {
+        printf("  Sensores: %llu | lineas rechazadas: %llu\n", sensores, rechazadas);
+        if (lecturasTemp)
+            printf("  Temperatura: %llu lecturas, promedio %.3f, min %.3f, max %.3f\n", lecturasTemp,
+                   sumaTemp / (double)lecturasTemp, minTemp, maxTemp);
+        if (lecturasPres)
+            printf("  Presion: %llu lecturas, promedio %.3f, min %d, max %d\n", lecturasPres,
+                   (double)sumaPres / (double)lecturasPres, minPres, maxPres);
+        latenciaLote.imprimir("Aplicar lote:");
+    }
+};
+
+/**
+ * @brief Agregado combinable de un sensor (cuenta, suma, mínimo, máximo);
+ *        el router combina los de todos los trabajadores por nombre.
+ */
+struct ResumenSensorCluster {
+    char nombre[50];
+    unsigned char tipo;
+    unsigned long long lecturas;
+    double suma, minimo, maximo;
+
+    void agregar(double v) {
+        if (lecturas == 0 || v < minimo) minimo = v;
+        if (lecturas == 0 || v > maximo) maximo = v;
+        lecturas++;
+        suma += v;
+    }
+
+    void combinar(const ResumenSensorCluster& o) {
+        if (o.lecturas == 0) return;
+        if (lecturas == 0 || o.minimo < minimo) minimo = o.minimo;
+        if (lecturas == 0 || o.maximo > maximo) maximo = o.maximo;
+        lecturas += o.lecturas;
+        suma += o.suma;
+    }
+};
+
+inline void IndiceRanking::imprimir(int i) const {
+    const RankingSensores& r = *rankings[i];
+    unsigned* hs = new unsigned[r.getK()];
+    double* vs = new double[r.getK()];
+    size_t m = r.copiaOrdenada(hs, vs);
+    printf("--- Top %zu por %s (%s) ---\n", r.getK(), r.nombreMetrica(),
+           r.getTipo() == TIPO_TEMPERATURA ? "temperatura" : r.getTipo() == TIPO_PRESION ? "presion" : "todos");
+    for (size_t j = 0; j < m; ++j) printf("  %2zu) %-20s %.3f\n", j + 1, estados[hs[j]].sensor->getNombre(), vs[j]);
+    if (m == 0) printf("  (sin sensores con lecturas)\n");
+    delete[] hs;
+    delete[] vs;
+}
+
+inline size_t MonitorLatidos::revisar() {
+    size_t nuevas = 0;
+    Temporizador* t = rueda.avanzar(tickAhora());
+    unsigned long long ahora = relojMs();
+    while (t) {
+        Temporizador* sig = t->next;
+        t->next = NULL;
+        t->disparado = true;
+        printf("[Alerta] Sensor %s silencioso: sin lecturas hace %llu ms (plazo %llu ms).\n",
+               t->sensor->getNombre(), ahora - t->sensor->getUltimaLecturaMs(), t->plazoMs);
+        nuevas++;
+        t = sig;
+    }
+    alertas += nuevas;
+    return nuevas;
+}
+
+inline void PlanificadorProcesamiento::colocar(size_t i, const Entrada& e) {
+    heap[i] = e;
+    e.sensor->plan.posHeap = (long)i;
+}
+
+inline void PlanificadorProcesamiento::subir(size_t i) {
+    Entrada e = heap[i];
+    while (i > 0) {
+        size_t padre = (i - 1) / 2;
+        if (heap[padre].vence <= e.vence) break;
+        colocar(i, heap[padre]);
+        i = padre;
+    }
+    colocar(i, e);
+}
+
+inline void PlanificadorProcesamiento::bajar(size_t i) {
+    Entrada e = heap[i];
+    while (true) {
+        size_t h = 2 * i + 1;
+        if (h >= n) break;
+        if (h + 1 < n && heap[h + 1].vence < heap[h].vence) h++;
+        if (e.vence <= heap[h].vence) break;
+        colocar(i, heap[h]);
+        i = h;
+    }
+    colocar(i, e);
+}
+
+inline void PlanificadorProcesamiento::fijarVencimiento(SensorBase* s, unsigned long long vence) {
+    long pos = s->plan.posHeap;
+    if (pos < 0) {
+        if (n == cap) {
+            size_t nuevaCap = cap ? cap * 2 : 16;
+            Entrada* nuevo = new Entrada[nuevaCap];
+            for (size_t i = 0; i < n; ++i) nuevo[i] = heap[i];
+            delete[] heap;
+            heap = nuevo;
+            cap = nuevaCap;
+        }
+        Entrada e = { vence, s };
+        colocar(n, e);
+        n++;
+        subir(n - 1);
+        return;
+    }
+    unsigned long long antes = heap[pos].vence;
+    heap[pos].vence = vence;
+    if (vence < antes) subir((size_t)pos);
+    else bajar((size_t)pos);
+}
+
+inline void PlanificadorProcesamiento::quitar(SensorBase* s) {
+    long pos = s->plan.posHeap;
+    if (pos >= 0) {
+        s->plan.posHeap = -1;
+        n--;
+        if ((size_t)pos != n) {
+            colocar((size_t)pos, heap[n]);
+            subir((size_t)pos);
+            bajar((size_t)heap[pos].sensor->plan.posHeap);
+        }
+    }
+    s->planificador = NULL;
+    s->plan = Planificacion();
+}
+
+inline void PlanificadorProcesamiento::planificar(SensorBase* s, unsigned long long periodoMs,
+                                                  size_t cadaN) {
+    if (s->planificador && s->planificador != this) s->planificador->quitar(s);
+    quitar(s);
+    if (periodoMs == 0 && cadaN == 0) return;
+
+    s->planificador = this;
+    s->plan.periodoNs = periodoMs * 1000000ULL;
+    s->plan.cadaN = cadaN;
+    if (s->plan.periodoNs) {
+        // Fase escalonada por razón áurea: los periodos iguales no coinciden.
+        unsigned long long fase = (registrados * 2654435761ULL) % 1000ULL;
+        s->plan.vencePeriodo = relojNs() + s->plan.periodoNs * fase / 1000ULL;
+        fijarVencimiento(s, s->plan.vencePeriodo);
+    }
+    registrados++;
+}
+
+inline void PlanificadorProcesamiento::lecturaRegistrada(SensorBase* s) {
+    Planificacion& p = s->plan;
+    p.pendientes++;
+    if (p.cadaN && p.pendientes >= p.cadaN && !p.porCuenta) {
+        p.porCuenta = true;
+        unsigned long long ahora = relojNs();
+        if (p.posHeap < 0 || heap[p.posHeap].vence > ahora) fijarVencimiento(s, ahora);
+    }
+}
+
+inline size_t PlanificadorProcesamiento::ejecutarPendientes(size_t maxPorRonda) {
+    size_t hechos = 0;
+    while (n > 0 && hechos < maxPorRonda) {
+        unsigned long long inicio = relojNs();
+        if (heap[0].vence > inicio) break;
+
+        Entrada e = heap[0];
+        SensorBase* s = e.sensor;
+        jitter.registrar(inicio - e.vence);
+        s->procesarConTraza();
+        unsigned long long fin = relojNs();
+        ciclo.registrar(fin - inicio);
+        Planificacion& p = s->plan;
+        p.pendientes = 0;
+        p.porCuenta = false;
+        hechos++;
+
+        if (p.periodoNs) {
+            // Solo un turno periódico vencido avanza la fase (un disparo por
+            // cuenta la deja intacta); si hubo retraso de varios periodos,
+            // los salta.
+            if (p.vencePeriodo <= inicio) {
+                unsigned long long sig = p.vencePeriodo + p.periodoNs;
+                if (sig <= fin) {
+                    unsigned long long saltos = (fin - sig) / p.periodoNs + 1;
+                    omitidos += (size_t)saltos;
+                    sig += saltos * p.periodoNs;
+                }
+                p.vencePeriodo = sig;
+            }
+            fijarVencimiento(s, p.vencePeriodo);
+        } else {
+            // Solo "cada N lecturas": sale de la cola hasta el próximo disparo.
+            Entrada ultimo = heap[--n];
+            s->plan.posHeap = -1;
+            if (n > 0) {
+                colocar(0, ultimo);
+                bajar(0);
+            }
+        }
+    }
+    return hechos;
+}
+
+inline void PlanificadorProcesamiento::imprimirReporte() const {
+    printf("\n--- Reporte del Planificador ---\n");
+    printf("  Sensores en cola: %zu, ciclos periodicos omitidos por retraso: %zu\n", n, omitidos);
+    jitter.imprimir("Jitter de inicio:");
+    ciclo.imprimir("Latencia de ciclo:");
+}
+
+/* ============================================================
+ *      Instantáneas en segundo plano (fork + copy-on-write)
+ * ============================================================*/
+
+/**
+ * @brief Seguimiento de la instantánea en curso: el hijo de fork() serializa
+ *        su vista copy-on-write mientras el padre sigue atendiendo lecturas.
+ * @details Mide la pausa del padre (duración de fork()), la duración total
+ *          informada por el hijo a través de un pipe y los fallos de página
+ *          menores del padre mientras el hijo vive (cota de páginas copiadas
+ *          por copy-on-write).
+ */
+class GestorInstantaneas {
+public:
+    struct Resultado {
+        unsigned long long duracionNs; ///< Medida en el hijo
+        unsigned long long lecturas;
+        long minfltHijo;
+        int ok;
+    };
+
+private:
+    pid_t pid;
+    int tuberia;
+    unsigned long long inicioNs;
+    unsigned long long pausaNs;
+    long minfltInicio;
+    char ruta[256];
+    bool ultimoOk;
+
+    static long fallosMenores() {
+        struct rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        return ru.ru_minflt;
+    }
+
+    GestorInstantaneas(const GestorInstantaneas&);
+    GestorInstantaneas& operator=(const GestorInstantaneas&);
+
+public:
+    GestorInstantaneas()
+        : pid(-1), tuberia(-1), inicioNs(0), pausaNs(0), minfltInicio(0), ultimoOk(false) {
+        ruta[0] = '\0';
+    }
+
+    ~GestorInstantaneas() {
+        if (pid > 0) waitpid(pid, NULL, 0);
+        if (tuberia >= 0) close(tuberia);
+    }
+
+    bool enCurso() const { return pid > 0; }
+
+    /**
+     * @brief Crea el hijo. Devuelve 0 en el hijo (que debe escribir y llamar
+     *        a terminarHijo), 1 en el padre y -1 si falló.
+     */
+    int iniciar(const char* destino) {
+        if (pid > 0) {
+            printf("[Instantanea] Ya hay una en curso (pid %d).\n", (int)pid);
+            return -1;
+        }
+        int fds[2];
+        if (pipe(fds) != 0) return -1;
+        std::strncpy(ruta, destino, sizeof(ruta) - 1);
+        ruta[sizeof(ruta) - 1] = '\0';
+        std::fflush(NULL); // evita duplicar buffers de stdio en el hijo
+
+        minfltInicio = fallosMenores();
+        inicioNs = relojNs();
+        pid_t p = fork();
+        if (p < 0) {
+            close(fds[0]);
+            close(fds[1]);
+            return -1;
+        }
+        if (p == 0) {
+            close(fds[0]);
+            tuberia = fds[1];
+            return 0;
+        }
+        pausaNs = relojNs() - inicioNs;
+        close(fds[1]);
+        tuberia = fds[0];
+        pid = p;
+        printf("[Instantanea] Hijo %d escribiendo %s (pausa del padre: %.1f us).\n",
+               (int)pid, ruta, pausaNs / 1000.0);
+        return 1;
+    }
+
+    const char* getRuta() const { return ruta; }
+
+    /// Resultado de la última instantánea recogida por revisar().
+    bool ultimaExitosa() const { return ultimoOk; }
+
+    /**
+     * @brief En el hijo: informa el resultado al padre y termina sin ejecutar
+     *        destructores (el estado pertenece al padre).
+     */
+    void terminarHijo(bool ok, unsigned long long lecturas) {
+        Resultado r;
+        r.duracionNs = relojNs() - inicioNs;
+        r.lecturas = lecturas;
+        r.minfltHijo = fallosMenores(); // los contadores del hijo empiezan en 0
+        r.ok = ok ? 1 : 0;
+        ssize_t w = write(tuberia, &r, sizeof(r));
+        (void)w;
+        _exit(ok ? 0 : 1);
+    }
+
+    /**
+     * @brief En el padre: si el hijo terminó, imprime el reporte.
+     * @param esperar true para bloquear hasta que termine.
+     * @return true si había una instantánea y ya concluyó.
+     */
+    bool revisar(bool esperar = false) {
+        if (pid <= 0) return false;
+        int estado = 0;
+        pid_t r = waitpid(pid, &estado, esperar ? 0 : WNOHANG);
+        if (r == 0) return false;
+        long cow = fallosMenores() - minfltInicio;
+        unsigned long long total = relojNs() - inicioNs;
+
+        Resultado res;
+        std::memset(&res, 0, sizeof(res));
+        bool leido = read(tuberia, &res, sizeof(res)) == (ssize_t)sizeof(res);
+        close(tuberia);
+        tuberia = -1;
+        pid = -1;
+
+        printf("\n--- Instantanea %s ---\n", ruta);
+        ultimoOk = leido && res.ok;
+        if (!ultimoOk) {
+            printf("  Fallo la escritura de la instantanea.\n");
+            return true;
+        }
+        printf("  Lecturas: %llu | Duracion en el hijo: %.3f ms (%.3f ms hasta recogerla)\n",
+               res.lecturas, res.duracionNs / 1e6, total / 1e6);
+        printf("  Pausa del padre (fork): %.1f us\n", pausaNs / 1000.0);
+        printf("  Fallos de pagina menores: padre %ld (cota de copias COW), hijo %ld\n",
+               cow, res.minfltHijo);
+        return true;
+    }
+};
+
+/* ============================================================
+ *        Checkpoints incrementales (base + deltas)
+ * ============================================================*/
+
+/**
+ * @brief Cadena de checkpoints: una base completa (IOTSNAP2) más deltas
+ *        numerados con solo los sensores modificados.
+ * @details Archivos: `ruta` (manifiesto de texto), `ruta.g<gen>` (base) y
+ *          `ruta.d<seq>` (deltas). El manifiesto se reemplaza con rename, así
+ *          que siempre describe una cadena completa. La compactación escribe
+ *          una base nueva desde un hijo de fork() y, al terminar, descarta la
+ *          base y los deltas que absorbió.
+ */
+class CadenaCheckpoints {
+public:
+    static const unsigned DELTAS_POR_COMPACTACION = 8;
+
+private:
+    char ruta[200];
+    bool activa;
+    unsigned gen;          ///< Generación de la base vigente
+    unsigned desde;        ///< Primer delta que aplica sobre la base
+    unsigned hasta;        ///< Último delta escrito (desde - 1 si ninguno)
+    unsigned long long periodoNs;
+    unsigned long long ultimoNs;
+    bool compactando;
+    unsigned genNueva;     ///< Base que escribe el hijo
+    unsigned hastaNueva;   ///< Último delta que absorbe esa base
+    unsigned long long bytesEscritos;
+    unsigned long long lecturasEscritas;
+
+public:
+    CadenaCheckpoints()
+        : activa(false), gen(0), desde(1), hasta(0), periodoNs(0), ultimoNs(0),
+          compactando(false), genNueva(0), hastaNueva(0), bytesEscritos(0), lecturasEscritas(0) {
+        ruta[0] = '\0';
+    }
+
+    bool estaActiva() const { return activa; }
+    bool tieneBase() const { return gen > 0; }
+    bool estaCompactando() const { return compactando; }
+    unsigned getGen() const { return gen; }
+    unsigned getDesde() const { return desde; }
+    unsigned getHasta() const { return hasta; }
+    unsigned pendientesDeCompactar() const { return hasta + 1 - desde; }
+
+    void nombreBase(unsigned g, char* out, size_t cap) const {
+        std::snprintf(out, cap, "%s.g%u", ruta, g);
+    }
+
+    void nombreDelta(unsigned seq, char* out, size_t cap) const {
+        std::snprintf(out, cap, "%s.d%u", ruta, seq);
+    }
+
+    /**
+     * @brief Activa la cadena en `r` y lee su manifiesto si existe.
+     * @return true si había una cadena previa que restaurar.
+     */
+    bool activar(const char* r, unsigned long long periodoMs) {
+        std::strncpy(ruta, r, sizeof(ruta) - 1);
+        ruta[sizeof(ruta) - 1] = '\0';
+        activa = true;
+        periodoNs = periodoMs * 1000000ULL;
+        ultimoNs = relojNs();
+        FILE* f = std::fopen(ruta, "r");
+        if (!f) return false;
+        unsigned g = 0, d = 1, h = 0;
+        bool ok = std::fscanf(f, "IOTCKPT1 %u %u %u", &g, &d, &h) == 3 && g > 0;
+        std::fclose(f);
+        if (!ok) return false;
+        gen = g;
+        desde = d;
+        hasta = h;
+        return true;
+    }
+
+    bool escribirManifiesto() const {
+        char tmp[220];
+        std::snprintf(tmp, sizeof(tmp), "%s.tmp", ruta);
+        FILE* f = std::fopen(tmp, "w");
+        if (!f) return false;
+        std::fprintf(f, "IOTCKPT1 %u %u %u\n", gen, desde, hasta);
+        bool ok = std::fflush(f) == 0 && fsync(fileno(f)) == 0;
+        std::fclose(f);
+        return ok && std::rename(tmp, ruta) == 0;
+    }
+
+    /// ¿Venció el periodo de checkpoint automático?
+    bool toca(unsigned long long ahora) const {
+        return activa && periodoNs && ahora - ultimoNs >= periodoNs;
+    }
+
+    /**
+     * @brief Publica la base `g` en el manifiesto.
+     * @return false si no se pudo escribir; la cadena anterior sigue vigente.
+     */
+    bool confirmarBase(unsigned g) {
+        unsigned genPrevia = gen, desdePrevio = desde, hastaPrevio = hasta;
+        gen = g;
+        desde = 1;
+        hasta = 0;
+        if (escribirManifiesto()) return true;
+        gen = genPrevia;
+        desde = desdePrevio;
+        hasta = hastaPrevio;
+        return false;
+    }
+
+    /**
+     * @brief Publica el delta `seq` en el manifiesto.
+     * @return false si no se pudo escribir; el delta no forma parte de la cadena.
+     */
+    bool confirmarDelta(unsigned seq, unsigned long long bytes, unsigned long long lecturas) {
+        unsigned hastaPrevio = hasta;
+        hasta = seq;
+        if (!escribirManifiesto()) {
+            hasta = hastaPrevio;
+            return false;
+        }
+        ultimoNs = relojNs();
+        bytesEscritos += bytes;
+        lecturasEscritas += lecturas;
+        return true;
+    }
+
+    /// Deja de escribir checkpoints (no toca los archivos).
+    void desactivar() {
+        activa = false;
+        gen = 0;
+        desde = 1;
+        hasta = 0;
+    }
+
+    void iniciarCompactacion() {
+        compactando = true;
+        genNueva = gen + 1;
+        hastaNueva = hasta;
+    }
+
+    unsigned getGenNueva() const { return genNueva; }
+
+    /**
+     * @brief Cierra la compactación: si el hijo tuvo éxito, la base nueva
+     *        reemplaza a la vieja y a los deltas que ya contiene.
+     */
+    void terminarCompactacion(bool ok) {
+        compactando = false;
+        char nombre[220];
+        if (!ok) {
+            nombreBase(genNueva, nombre, sizeof(nombre));
+            std::remove(nombre);
+            return;
+        }
+        unsigned genVieja = gen, desdeViejo = desde;
+        gen = genNueva;
+        desde = hastaNueva + 1;
+        if (!escribirManifiesto()) return;
+        nombreBase(genVieja, nombre, sizeof(nombre));
+        std::remove(nombre);
+        for (unsigned k = desdeViejo; k <= hastaNueva; ++k) {
+            nombreDelta(k, nombre, sizeof(nombre));
+            std::remove(nombre);
+        }
+        printf("[Checkpoint] Compactacion lista: base g%u, deltas desde %u.\n", gen, desde);
+    }
+
+    void imprimirReporte() const {
+        printf("\n--- Checkpoints (%s) ---\n", activa ? ruta : "inactivos");
+        if (!activa) return;
+        printf("  Base g%u | deltas %u..%u | compactando: %s\n", gen, desde, hasta,
+               compactando ? "si" : "no");
+        printf("  Escrito en deltas: %llu bytes, %llu lecturas\n", bytesEscritos, lecturasEscritas);
+    }
+};
+
+/* ============================================================
+ *    Lista de gestión polimórfica (SensorBase*)
+ * ============================================================*/
+
+class ListaGeneral {
+public:
+    struct Nodo {
+        SensorBase* sensor;
+        Nodo* siguiente;
+        Nodo(SensorBase* ptr) : sensor(ptr), siguiente(NULL) {}
+    };
+
+private:
+    Nodo* cabeza;
+    Nodo* cola;
+    size_t n;
+    MonitorLatidos latidos; ///< Debe sobrevivir a los sensores (se destruye después)
+    PlanificadorProcesamiento planificador;
+    AlmacenDesborde desborde;
+    Nodo* manecilla; ///< Posición del reloj (CLOCK) de desalojo
+    AlmacenMapeado mapa;
+    GestorInstantaneas instantaneas;
+    CadenaCheckpoints checkpoints;
+    AnilloCompartido anillo;
+    unsigned siguienteHandle;
+    ReplicadorPrimario replica;
+    IndiceRanking rankings;
+
+    /**
+     * @brief Alta del sensor en el standby más la copia base de su historial.
+     */
+    void replicarSensor(SensorBase* s) {
+        replica.alta(s->getHandle(), (unsigned char)s->tipoSensor(), s->getNombre());
+        s->adjuntarReplica(&replica);
+        FILE* f = std::tmpfile();
+        long long cnt = f ? s->escribirInstantanea(f) : -1;
+        if (cnt > 0) {
+            long bytes = std::ftell(f) - (long)(1 + 50 + sizeof(unsigned long long));
+            unsigned char* crudo = new unsigned char[bytes];
+            std::fseek(f, 1 + 50 + (long)sizeof(unsigned long long), SEEK_SET);
+            if (std::fread(crudo, (size_t)bytes, 1, f) == 1)
+                replica.carga(s->getHandle(), crudo, (size_t)cnt, (size_t)bytes / (size_t)cnt);
+            delete[] crudo;
+        }
+        if (f) std::fclose(f);
+    }
+
+    /// f(valor, banderas, marcaMs) por cada lectura de `s`, sin expandir su archivo.
+    template <typename F>
+    static void recorrerSensor(SensorBase* s, F& f) {
+        if (s->tipoSensor() == TIPO_TEMPERATURA) static_cast<SensorTemperatura*>(s)->recorrerHistorial(f);
+        else static_cast<SensorPresion*>(s)->recorrerHistorial(f);
+    }
+
+    static bool rangoSensor(SensorBase* s, long long& primera, long long& ultima) {
+        RangoMarcas r;
+        recorrerSensor(s, r);
+        primera = r.primera;
+        ultima = r.ultima;
+        return r.hay;
+    }
+
+    static void remuestrearSensor(SensorBase* s, long long inicio, long long paso, size_t n, double* out) {
+        if (s->tipoSensor() == TIPO_TEMPERATURA)
+            remuestrear(static_cast<SensorTemperatura*>(s)->getHistorial(), inicio, paso, n, out);
+        else
+            remuestrear(static_cast<SensorPresion*>(s)->getHistorial(), inicio, paso, n, out);
+    }
+
+    static size_t reducirSensor(SensorBase* s, size_t puntos, long long* marcas, double* valores) {
+        if (s->tipoSensor() == TIPO_TEMPERATURA)
+            return static_cast<SensorTemperatura*>(s)->getHistorial().reducirLttb(puntos, marcas, valores);
+        return static_cast<SensorPresion*>(s)->getHistorial().reducirLttb(puntos, marcas, valores);
+    }
+
+    template <typename V>
+    static size_t unirSensores(SensorBase* a, SensorBase* b, bool cercano, long long tol, V& v) {
+        bool ta = a->tipoSensor() == TIPO_TEMPERATURA, tb = b->tipoSensor() == TIPO_TEMPERATURA;
+        SensorTemperatura* at = static_cast<SensorTemperatura*>(a);
+        SensorTemperatura* bt = static_cast<SensorTemperatura*>(b);
+        SensorPresion* ap = static_cast<SensorPresion*>(a);
+        SensorPresion* bp = static_cast<SensorPresion*>(b);
+        if (ta && tb) return unirPorTiempo(at->getHistorial(), bt->getHistorial(), cercano, tol, v);
+        if (ta) return unirPorTiempo(at->getHistorial(), bp->getHistorial(), cercano, tol, v);
+        if (tb) return unirPorTiempo(ap->getHistorial(), bt->getHistorial(), cercano, tol, v);
+        return unirPorTiempo(ap->getHistorial(), bp->getHistorial(), cercano, tol, v);
+    }
+
+public:
+    ListaGeneral() : cabeza(NULL), cola(NULL), n(0), manecilla(NULL), siguienteHandle(0) {}
+
+    ~ListaGeneral() {
+        liberarTodo();
+    }
+
+    void push_back(SensorBase* s) {
+        if (mapa.abierto() && !s->tienePersistencia()) {
+            long idx = mapa.registrar(s->getNombre(), (unsigned char)s->tipoSensor());
+            if (idx >= 0) s->adjuntarPersistencia(&mapa, (unsigned)idx, false);
+            else printf("[Persistencia] Tabla llena: %s no se persistira.\n", s->getNombre());
+        }
+        s->asignarHandle(siguienteHandle++);
+        rankings.registrar(s, s->getHandle(), (int)s->tipoSensor());
+        s->adjuntarRanking(&rankings);
+        if (anillo.abierto()) {
+            anillo.nombrar(s->getHandle(), s->getNombre());
+            s->adjuntarAnillo(&anillo);
+        }
+        if (replica.activo()) replicarSensor(s);
+        Nodo* nuevo = new Nodo(s);
+        if (!cabeza) {
+            cabeza = cola = nuevo;
+        } else {
+            cola->siguiente = nuevo;
+            cola = nuevo;
+        }
+        n++;
+    }
+
+    size_t size() const { return n; }
+
+    /**
+     * @brief Quita el sensor de la lista sin destruirlo (migración entre
+     *        trabajadores). Retorna NULL si no existe.
+     */
+    SensorBase* extraer(const char* id) {
+        Nodo* previo = NULL;
+        for (Nodo* it = cabeza; it; previo = it, it = it->siguiente) {
+            if (std::strcmp(it->sensor->getNombre(), id) != 0) continue;
+            if (previo) previo->siguiente = it->siguiente;
+            else cabeza = it->siguiente;
+            if (cola == it) cola = previo;
+            if (manecilla == it) manecilla = it->siguiente;
+            SensorBase* s = it->sensor;
+            rankings.quitar(s->getHandle());
+            s->adjuntarRanking(NULL);
+            delete it;
+            n--;
+            return s;
+        }
+        return NULL;
+    }
+
+    /**
+     * @brief Agregados de todas las lecturas de la lista.
+     */
+    void resumir(ResumenCluster& r) {
+        for (Nodo* it = cabeza; it; it = it->siguiente) {
+            r.sensores++;
+            AgregarLecturas<ResumenCluster> a(r);
+            recorrerSensor(it->sensor, a);
+            aplicarPresupuesto();
+        }
+    }
+
+    /**
+     * @brief Agregado por sensor de la lista; `out` recibe size() entradas.
+     */
+    void resumirPorSensor(ResumenSensorCluster* out) {
+        size_t i = 0;
+        for (Nodo* it = cabeza; it; it = it->siguiente, ++i) {
+            ResumenSensorCluster& r = out[i];
+            std::memset(&r, 0, sizeof(r));
+            std::memcpy(r.nombre, it->sensor->getNombre(), sizeof(r.nombre));
+            r.tipo = (unsigned char)it->sensor->tipoSensor();
+            AgregarLecturas<ResumenSensorCluster> a(r);
+            recorrerSensor(it->sensor, a);
+            aplicarPresupuesto();
+        }
+    }
+
+    /**
+     * @brief Busca por nombre (id) exacto. Retorna puntero o NULL.
+     */
+    SensorBase* buscarPorNombre(const char* id) {
+        Nodo* it = cabeza;
+        while (it) {
+            if (std::strcmp(it->sensor->getNombre(), id) == 0) {
+                return it->sensor;
+            }
+            it = it->siguiente;
+        }
+        return NULL;
+    }
+
+    /**
+     * @brief Itera y llama procesarLectura() en todos los sensores.
+     */
+    void procesarTodos() {
+        printf("\n--- Ejecutando Polimorfismo ---\n");
+        Nodo* it = cabeza;
+        while (it) {
+            it->sensor->procesarConTraza();
+            aplicarPresupuesto();
+            it = it->siguiente;
+        }
+    }
+
+    /**
+     * @brief Libera nodos y, en cascada, cada SensorBase* (virtual dtor).
+     */
+    void liberarTodo() {
+        if (!cabeza) return;
+        printf("\n--- Liberación de Memoria en Cascada ---\n");
+        Nodo* it = cabeza;
+        while (it) {
+            Nodo* nxt = it->siguiente;
+            printf("[Destructor General] Liberando Nodo: %s.\n", it->sensor->getNombre());
+            delete it->sensor;  // destructor virtual -> baja a derivadas
+            delete it;
+            it = nxt;
+        }
+        cabeza = cola = manecilla = NULL;
+        n = 0;
+        rankings.olvidarTodos();
+        printf("Sistema cerrado. Memoria limpia.\n");
+    }
+
+    MonitorLatidos& getMonitorLatidos() { return latidos; }
+
+    IndiceRanking& getRankings() { return rankings; }
+
+    /**
+     * @brief Activa o descarta los bocetos de los sensores cuyo nombre
+     *        empieza con `prefijo` ("" = todos). @return Sensores afectados.
+     */
+    size_t configurarBocetos(const char* prefijo, bool activo) {
+        size_t c = 0, largo = std::strlen(prefijo);
+        for (Nodo* it = cabeza; it; it = it->siguiente) {
+            if (std::strncmp(it->sensor->getNombre(), prefijo, largo) != 0) continue;
+            it->sensor->configurarBoceto(activo);
+            c++;
+        }
+        return c;
+    }
+
+    /**
+     * @brief Alinea por tiempo dos sensores (p. ej. temperatura y presión de
+     *        un mismo equipo) y reporta la correlación de los pares.
+     * @param modo 1 as-of (última de `b` con marca <= la de `a`), 2 más
+     *        cercana, 3 interpolación lineal de ambas en una grilla regular.
+     * @param parametroMs Modos 1-2: tolerancia (-1 = sin límite); modo 3: paso.
+     * @param rutaCsv Si no es NULL, escribe los pares alineados en CSV.
+     * @return Pares alineados, o -1 si hubo error.
+     */
+    long long alinear(const char* idA, const char* idB, int modo, long long parametroMs, const char* rutaCsv) {
+        SensorBase* a = buscarPorNombre(idA);
+        SensorBase* b = buscarPorNombre(idB);
+        if (!a || !b || (modo == 3 && parametroMs <= 0)) return -1;
+        FILE* f = NULL;
+        if (rutaCsv) {
+            f = std::fopen(rutaCsv, "w");
+            if (!f) return -1;
+            std::fprintf(f, "marca_ms,%s,%s\n", a->getNombre(), b->getNombre());
+        }
+        CorrelacionAlineada corr;
+        CsvAlineado csv(f);
+        long long pares;
+        if (modo == 3) {
+            long long ia, fa, ib, fb;
+            if (!rangoSensor(a, ia, fa) || !rangoSensor(b, ib, fb)) {
+                pares = 0;
+            } else {
+                long long ini = ia > ib ? ia : ib, fin = fa < fb ? fa : fb;
+                size_t n = fin >= ini ? (size_t)((fin - ini) / parametroMs) + 1 : 0;
+                if (n > 10000000) n = 10000000; // tope de las columnas materializadas
+                double* colA = new double[n ? n : 1];
+                double* colB = new double[n ? n : 1];
+                remuestrearSensor(a, ini, parametroMs, n, colA);
+                remuestrearSensor(b, ini, parametroMs, n, colB);
+                corr.columnas(colA, colB, n);
+                for (size_t i = 0; f && i < n; ++i) csv(ini + (long long)i * parametroMs, colA[i], colB[i]);
+                delete[] colA;
+                delete[] colB;
+                pares = (long long)n;
+            }
+        } else {
+            VisitanteDoble<CorrelacionAlineada, CsvAlineado> ambos(corr, csv);
+            pares = (long long)unirSensores(a, b, modo == 2, parametroMs, ambos);
+        }
+        bool ok = !f || (csv.ok && std::fclose(f) == 0);
+        static const char* nombres[4] = { "", "as-of", "mas cercana", "grilla lineal" };
+        printf("[Alinear] %s ~ %s (%s): %lld pares, correlacion %.4f\n", a->getNombre(), b->getNombre(),
+               nombres[modo >= 1 && modo <= 3 ? modo : 0], pares, corr.pearson());
+        return ok ? pares : -1;
+    }
+
+    /**
+     * @brief Resumen visual del historial de un sensor: `puntos` lecturas
+     *        elegidas con LTTB, impresas o exportadas a CSV.
+     * @return Puntos resumidos, o -1 si hubo error.
+     */
+    long long resumirSensor(const char* id, size_t puntos, const char* rutaCsv) {
+        SensorBase* s = buscarPorNombre(id);
+        if (!s || puntos == 0) return -1;
+        unsigned long long t0 = relojNs();
+        if (!rutaCsv) {
+            // En la terminal, el resumen legible de la propia lista.
+            printf("[Resumen] %s: ", s->getNombre());
+            size_t c = s->tipoSensor() == TIPO_TEMPERATURA
+                ? static_cast<SensorTemperatura*>(s)->getHistorial().print_summary(puntos)
+                : static_cast<SensorPresion*>(s)->getHistorial().print_summary(puntos);
+            printf("[Resumen] %.2f ms (con la impresion).\n", (relojNs() - t0) / 1e6);
+            return (long long)c;
+        }
+        long long* marcas = new long long[puntos];
+        double* valores = new double[puntos];
+        size_t c = reducirSensor(s, puntos, marcas, valores);
+        double ms = (relojNs() - t0) / 1e6;
+        FILE* f = std::fopen(rutaCsv, "w");
+        bool ok = f != NULL;
+        if (f) {
+            std::fprintf(f, "marca_ms,%s\n", s->getNombre());
+            for (size_t i = 0; i < c; ++i) std::fprintf(f, "%lld,%.6g\n", marcas[i], valores[i]);
+            ok = std::fclose(f) == 0;
+        }
+        printf("[Resumen] %s: %zu de %zu lecturas (LTTB) en %.2f ms.\n", s->getNombre(), c,
+               s->lecturasHistorial(), ms);
+        delete[] marcas;
+        delete[] valores;
+        return ok ? (long long)c : -1;
+    }
+
+    /**
+     * @brief Duplicados, tardías y huecos de cada sensor con líneas numeradas.
+     */
+    void imprimirSecuencias() const {
+        unsigned long long aceptadas = 0, duplicadas = 0, tardias = 0, huecos = 0;
+        printf("\n--- Secuencias por sensor ---\n");
+        for (Nodo* it = cabeza; it; it = it->siguiente) {
+            const VentanaSecuencia* v = it->sensor->getSecuencia();
+            if (!v) continue;
+            printf("  %-12s", it->sensor->getNombre());
+            v->imprimir();
+            aceptadas += v->aceptadas;
+            duplicadas += v->duplicadas;
+            tardias += v->tardias;
+            huecos += v->huecos();
+        }
+        printf("  Total: aceptadas %llu | duplicadas %llu | tardias %llu | huecos %llu\n", aceptadas,
+               duplicadas, tardias, huecos);
+    }
+
+    /**
+     * @brief Combina en `total` los bocetos del grupo de sensores cuyo
+     *        nombre empieza con `prefijo`. @return Bocetos combinados.
+     */
+    size_t combinarBocetos(const char* prefijo, BocetoSensor& total) const {
+        size_t c = 0, largo = std::strlen(prefijo);
+        for (Nodo* it = cabeza; it; it = it->siguiente) {
+            const BocetoSensor* b = it->sensor->getBoceto();
+            if (!b || std::strncmp(it->sensor->getNombre(), prefijo, largo) != 0) continue;
+            total.combinar(*b);
+            c++;
+        }
+        return c;
+    }
+
+    PlanificadorProcesamiento& getPlanificador() { return planificador; }
+
+    /**
+     * @brief Fija el tope de bytes de historiales en memoria (0 = sin límite).
+     */
+    bool configurarPresupuesto(size_t bytes, const char* rutaDesborde = NULL) {
+        bool ok = desborde.configurar(bytes, rutaDesborde);
+        aplicarPresupuesto();
+        return ok;
+    }
+
+    /**
+     * @brief Desaloja historiales fríos (reloj de segunda oportunidad sobre la
+     *        lista de gestión) hasta volver a quedar dentro del presupuesto.
+     * @return Número de sensores desalojados.
+     */
+    size_t aplicarPresupuesto() {
+        if (!desborde.excedido() || n == 0) return 0;
+        size_t desalojados = 0;
+        size_t vistos = 0;
+        while (desborde.excedido() && vistos < 2 * n) {
+            if (!manecilla) manecilla = cabeza;
+            SensorBase* s = manecilla->sensor;
+            manecilla = manecilla->siguiente;
+            vistos++;
+            if (s->estaDesbordado() || s->bytesResidentes() == 0) continue;
+            if (s->tomarReferencia()) continue;
+            if (s->desbordar(desborde)) desalojados++;
+        }
+        return desalojados;
+    }
+
+    void imprimirMemoria() const {
+        desborde.imprimirReporte();
+        if (ArenaNodos::global().activa()) ArenaNodos::global().imprimirReporte();
+    }
+
+    /**
+     * @brief Guarda el extremo pendiente de cada sensor comprimido; va antes
+     *        de instantáneas, checkpoints, exportaciones y el cierre.
+     */
+    void cerrarTramosComprimidos() {
+        for (Nodo* it = cabeza; it; it = it->siguiente) it->sensor->cerrarTramoComprimido();
+    }
+
+    /**
+     * @brief Serializa la lista completa (formato IOTSNAP2) en f.
+     * @return Total de lecturas escritas, o -1 si hubo error.
+     */
+    long long escribirInstantanea(FILE* f) {
+        unsigned long long cuenta = (unsigned long long)n;
+        if (std::fwrite("IOTSNAP2", 8, 1, f) != 1 || std::fwrite(&cuenta, sizeof(cuenta), 1, f) != 1)
+            return -1;
+        long long lecturas = 0;
+        for (Nodo* it = cabeza; it; it = it->siguiente) {
+            long long c = it->sensor->escribirInstantanea(f);
+            if (c < 0) return -1;
+            lecturas += c;
+        }
+        return lecturas;
+    }
+
+    /**
+     * @brief Toma una instantánea sin detener la ingesta: el hijo de fork()
+     *        serializa su vista copy-on-write en `ruta` (vía ruta.tmp + rename).
+     */
+    bool instantaneaEnSegundoPlano(const char* ruta) {
+        cerrarTramosComprimidos(); // antes de fork(): el hijo ve el historial completo
+        int r = instantaneas.iniciar(ruta);
+        if (r < 0) return false;
+        if (r > 0) {
+            desborde.congelar(); // el hijo copia extensiones con pread()
+            return true;
+        }
+
+        // --- Proceso hijo ---
+        char tmp[300];
+        std::snprintf(tmp, sizeof(tmp), "%s.tmp", ruta);
+        FILE* f = std::fopen(tmp, "wb");
+        long long lecturas = f ? escribirInstantanea(f) : -1;
+        bool ok = f && lecturas >= 0 && std::fflush(f) == 0 && fsync(fileno(f)) == 0;
+        if (f) std::fclose(f);
+        ok = ok && std::rename(tmp, ruta) == 0;
+        instantaneas.terminarHijo(ok, ok ? (unsigned long long)lecturas : 0);
+        return false; // no se alcanza
+    }
+
+    /// Recoge (sin bloquear) la instantánea en curso e imprime su reporte.
+    bool revisarInstantanea(bool esperar = false) {
+        if (!instantaneas.revisar(esperar)) return false;
+        desborde.descongelar();
+        if (checkpoints.estaCompactando()) {
+            checkpoints.terminarCompactacion(instantaneas.ultimaExitosa());
+        }
+        return true;
+    }
+
+    /**
+     * @brief Activa los checkpoints incrementales en `ruta`; si ya existe una
+     *        cadena, la restaura (base + deltas) antes de seguir. Con sensores
+     *        en la lista se niega a restaurar y no activa nada.
+     * @param periodoMs Checkpoint automático cada periodoMs (0 = manual).
+     */
+    bool activarCheckpoints(const char* ruta, unsigned long long periodoMs) {
+        if (!checkpoints.activar(ruta, periodoMs)) return true;
+        if (cabeza) {
+            // Restaurar sobre sensores vivos duplicaría nombres y mezclaría
+            // historiales; seguir sin restaurar pisaría la cadena existente.
+            checkpoints.desactivar();
+            printf("[Checkpoint] %s ya tiene una cadena y la lista no esta vacia: "
+                   "no se restaura ni se activa (use otra ruta o restaure al iniciar).\n", ruta);
+            return false;
+        }
+        char nombre[220];
+        checkpoints.nombreBase(checkpoints.getGen(), nombre, sizeof(nombre));
+        bool ok = cargarInstantanea(nombre);
+        for (unsigned k = checkpoints.getDesde(); ok && k <= checkpoints.getHasta(); ++k) {
+            checkpoints.nombreDelta(k, nombre, sizeof(nombre));
+            ok = aplicarDelta(nombre);
+        }
+        for (Nodo* it = cabeza; it; it = it->siguiente) it->sensor->marcarCheckpoint();
+        printf("[Checkpoint] Cadena restaurada: base g%u + deltas %u..%u%s.\n",
+               checkpoints.getGen(), checkpoints.getDesde(), checkpoints.getHasta(),
+               ok ? "" : " (incompleta)");
+        return ok;
+    }
+
+    /**
+     * @brief Aplica un delta IOTDELT2 sobre la lista actual.
+     */
+    bool aplicarDelta(const char* ruta) {
+        FILE* f = std::fopen(ruta, "rb");
+        if (!f) return false;
+        char magia[8];
+        unsigned long long cuenta = 0;
+        bool ok = std::fread(magia, 8, 1, f) == 1 && std::memcmp(magia, "IOTDELT2", 8) == 0 &&
+                  std::fread(&cuenta, sizeof(cuenta), 1, f) == 1;
+        for (unsigned long long i = 0; ok && i < cuenta; ++i) {
+            unsigned char tipo = 0, completo = 0;
+            char id[50];
+            unsigned long long cnt = 0;
+            ok = std::fread(&tipo, 1, 1, f) == 1 && std::fread(id, sizeof(id), 1, f) == 1 &&
+                 std::fread(&completo, 1, 1, f) == 1 && std::fread(&cnt, sizeof(cnt), 1, f) == 1;
+            if (!ok) break;
+            id[sizeof(id) - 1] = '\0';
+            SensorBase* s = buscarPorNombre(id);
+            if (!s) {
+                s = crearSensor((TipoSensor)tipo, id);
+                if (!s) { ok = false; break; }
+                push_back(s);
+            }
+            ok = s->aplicarDelta(f, completo != 0, (size_t)cnt);
+        }
+        std::fclose(f);
+        return ok;
+    }
+
+    /**
+     * @brief Escribe un checkpoint: la base completa si aún no hay, o un delta
+     *        con solo los sensores modificados. Cada DELTAS_POR_COMPACTACION
+     *        deltas lanza una compactación en segundo plano.
+     */
+    bool checkpoint() {
+        if (!checkpoints.estaActiva()) {
+            printf("[Checkpoint] No hay ruta configurada.\n");
+            return false;
+        }
+        cerrarTramosComprimidos();
+        unsigned long long t0 = relojNs();
+        char nombre[220];
+
+        if (!checkpoints.tieneBase()) {
+            checkpoints.nombreBase(1, nombre, sizeof(nombre));
+            FILE* f = std::fopen(nombre, "wb");
+            long long lecturas = f ? escribirInstantanea(f) : -1;
+            bool ok = f && lecturas >= 0 && std::fflush(f) == 0 && fsync(fileno(f)) == 0;
+            if (f) std::fclose(f);
+            if (!ok || !checkpoints.confirmarBase(1)) {
+                std::remove(nombre);
+                printf("[Checkpoint] No se pudo escribir la base ni su manifiesto.\n");
+                return false;
+            }
+            for (Nodo* it = cabeza; it; it = it->siguiente) it->sensor->marcarCheckpoint();
+            printf("[Checkpoint] Base g1: %lld lecturas en %.3f ms.\n", lecturas, (relojNs() - t0) / 1e6);
+            return true;
+        }
+
+        unsigned seq = checkpoints.getHasta() + 1;
+        checkpoints.nombreDelta(seq, nombre, sizeof(nombre));
+        FILE* f = std::fopen(nombre, "wb");
+        if (!f) return false;
+        unsigned long long sucios = 0;
+        for (Nodo* it = cabeza; it; it = it->siguiente) {
+            if (it->sensor->estaModificado()) sucios++;
+        }
+        bool ok = std::fwrite("IOTDELT2", 8, 1, f) == 1 && std::fwrite(&sucios, sizeof(sucios), 1, f) == 1;
+        long long lecturas = 0;
+        for (Nodo* it = cabeza; ok && it; it = it->siguiente) {
+            if (!it->sensor->estaModificado()) continue;
+            long long c = it->sensor->escribirDelta(f);
+            ok = c >= 0;
+            lecturas += c;
+        }
+        ok = ok && std::fflush(f) == 0 && fsync(fileno(f)) == 0;
+        long bytes = std::ftell(f);
+        std::fclose(f);
+        // Solo un delta publicado en el manifiesto limpia los sensores.
+        if (!ok || !checkpoints.confirmarDelta(seq, (unsigned long long)bytes, (unsigned long long)lecturas)) {
+            std::remove(nombre);
+            printf("[Checkpoint] No se pudo escribir el delta d%u o su manifiesto.\n", seq);
+            return false;
+        }
+        for (Nodo* it = cabeza; it; it = it->siguiente) {
+            if (it->sensor->estaModificado()) it->sensor->marcarCheckpoint();
+        }
+        printf("[Checkpoint] Delta d%u: %llu sensores, %lld lecturas, %ld bytes en %.3f ms.\n",
+               seq, sucios, lecturas, bytes, (relojNs() - t0) / 1e6);
+
+        if (checkpoints.pendientesDeCompactar() >= CadenaCheckpoints::DELTAS_POR_COMPACTACION &&
+            !checkpoints.estaCompactando() && !instantaneas.enCurso()) {
+            checkpoints.iniciarCompactacion();
+            checkpoints.nombreBase(checkpoints.getGenNueva(), nombre, sizeof(nombre));
+            if (!instantaneaEnSegundoPlano(nombre)) checkpoints.terminarCompactacion(false);
+        }
+        return true;
+    }
+
+    /// Checkpoint automático si venció su periodo.
+    void revisarCheckpoint() {
+        if (checkpoints.toca(relojNs())) checkpoint();
+    }
+
+    void imprimirCheckpoints() const { checkpoints.imprimirReporte(); }
+
+    /**
+     * @brief Espera al standby en el socket `ruta`, le envía la copia base de
+     *        los sensores actuales y desde ahí cada cambio aplicado.
+     */
+    bool replicarEn(const char* ruta) {
+        if (!replica.esperarStandby(ruta)) {
+            printf("[Replica] No se pudo escuchar en %s.\n", ruta);
+            return false;
+        }
+        for (Nodo* it = cabeza; it; it = it->siguiente) replicarSensor(it->sensor);
+        replica.enviarLote();
+        return true;
+    }
+
+    /// Envía el lote pendiente; se invoca en cada vuelta del menú.
+    void revisarReplica() { replica.enviarLote(); }
+
+    /**
+     * @brief Envía lo pendiente y espera la confirmación del standby; se
+     *        llama antes de confirmar un cambio al usuario.
+     * @return false si hay standby y no confirmó.
+     */
+    bool sincronizarReplica() {
+        if (replica.sincronizar()) return true;
+        // Si se desconectó ya se informó; aquí solo el vencimiento del plazo.
+        if (replica.activo()) printf("[Replica] El standby no confirmo el cambio a tiempo.\n");
+        return false;
+    }
+
+    void cerrarReplica() {
+        replica.cerrar();
+        if (replica.activo() || replica.huboActividad()) replica.imprimirReporte();
+    }
+
+    void imprimirReplica() const { replica.imprimirReporte(); }
+
+    /**
+     * @brief Exporta el historial de todos los sensores a un archivo Arrow
+     *        IPC (un lote por sensor) para herramientas de análisis.
+     */
+    bool exportarArrow(const char* ruta) {
+        cerrarTramosComprimidos();
+        unsigned long long t0 = relojNs();
+        EscritorArrow w;
+        bool ok = w.abrir(ruta);
+        for (Nodo* it = cabeza; ok && it; it = it->siguiente) {
+            SensorBase* s = it->sensor;
+            if (s->tipoSensor() == TIPO_TEMPERATURA)
+                ok = w.agregarLote(s->getNombre(), static_cast<SensorTemperatura*>(s)->getHistorial());
+            else
+                ok = w.agregarLote(s->getNombre(), static_cast<SensorPresion*>(s)->getHistorial());
+            aplicarPresupuesto();
+        }
+        ok = w.cerrar() && ok;
+        if (!ok) {
+            printf("[Arrow] Error al escribir %s.\n", ruta);
+            return false;
+        }
+        printf("[Arrow] %s: %llu filas de %zu sensores, %lld bytes en %.2f ms.\n", ruta,
+               w.filasEscritas(), n, w.bytesEscritos(), (relojNs() - t0) / 1e6);
+        return true;
+    }
+
+    /**
+     * @brief Mezcla los historiales de todos los sensores en un único flujo
+     *        ordenado por marcaMs y lo escribe en `ruta` (formato IOTMEZC1:
+     *        cabecera, tabla handle/nombre y registros de 24 bytes).
+     * @param particiones Tramos de tiempo mezclados en paralelo (fork).
+     * @return Lecturas escritas, o -1 si hubo error.
+     */
+    long long exportarMezcla(const char* ruta, size_t particiones) {
+        cerrarTramosComprimidos();
+        unsigned long long t0 = relojNs();
+        MezclaKVias::Fuente* fuentes = new MezclaKVias::Fuente[n ? n : 1];
+        size_t k = 0;
+        for (Nodo* it = cabeza; it; it = it->siguiente, ++k) {
+            SensorBase* s = it->sensor;
+            MezclaKVias::Fuente& f = fuentes[k];
+            f.handle = s->getHandle();
+            f.tipo = (unsigned char)s->tipoSensor();
+            f.marca = 0;
+            if (s->tipoSensor() == TIPO_TEMPERATURA) {
+                const ListaSensor<float>& h = static_cast<SensorTemperatura*>(s)->getHistorial();
+                f.nodo = h.primero();
+                f.ultima = h.ultimo() ? h.ultimo()->marcaMs : 0;
+            } else {
+                const ListaSensor<int>& h = static_cast<SensorPresion*>(s)->getHistorial();
+                f.nodo = h.primero();
+                f.ultima = h.ultimo() ? h.ultimo()->marcaMs : 0;
+            }
+        }
+        int fd = open(ruta, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            delete[] fuentes;
+            return -1;
+        }
+        // Cabecera: magia, sensores, tabla (handle, nombre[50]) y total al final.
+        size_t bytesTabla = k * (sizeof(unsigned) + 50);
+        size_t bytesCabecera = 8 + sizeof(unsigned long long) + bytesTabla + sizeof(unsigned long long);
+        unsigned char* cab = new unsigned char[bytesCabecera];
+        std::memset(cab, 0, bytesCabecera);
+        std::memcpy(cab, "IOTMEZC1", 8);
+        unsigned long long sensores = k;
+        std::memcpy(cab + 8, &sensores, sizeof(sensores));
+        size_t off = 8 + sizeof(sensores);
+        for (Nodo* it = cabeza; it; it = it->siguiente) {
+            unsigned h = it->sensor->getHandle();
+            std::memcpy(cab + off, &h, sizeof(h));
+            const char* nombre = it->sensor->getNombre();
+            size_t largo = std::strlen(nombre);
+            if (largo > 49) largo = 49;
+            std::memcpy(cab + off + sizeof(h), nombre, largo); // cab ya está en cero
+            off += sizeof(h) + 50;
+        }
+        std::fflush(stdout);
+        size_t desordenada = k;
+        long long total = MezclaKVias::volcarParticionado(fuentes, k, particiones, fd, (off_t)bytesCabecera,
+                                                          &desordenada);
+        if (desordenada < k) {
+            Nodo* it = cabeza;
+            for (size_t i = 0; i < desordenada; ++i) it = it->siguiente;
+            printf("[Mezcla] El historial de %s no esta ordenado por marca: se mezclo en un solo tramo.\n",
+                   it->sensor->getNombre());
+            particiones = 1;
+        }
+        unsigned long long escritas = total > 0 ? (unsigned long long)total : 0;
+        std::memcpy(cab + off, &escritas, sizeof(escritas));
+        bool ok = total >= 0 && pwrite(fd, cab, bytesCabecera, 0) == (ssize_t)bytesCabecera;
+        ok = close(fd) == 0 && ok;
+        delete[] cab;
+        delete[] fuentes;
+        if (!ok) {
+            printf("[Mezcla] Error al escribir %s.\n", ruta);
+            return -1;
+        }
+        double seg = (relojNs() - t0) / 1e9;
+        printf("[Mezcla] %s: %llu lecturas de %zu sensores en %zu tramo(s), %.2f ms (%.1f MB/s).\n", ruta, escritas,
+               k, particiones ? particiones : 1, seg * 1e3,
+               escritas * sizeof(MezclaKVias::Lectura) / (seg > 0 ? seg : 1e-9) / 1e6);
+        return total;
+    }
+
+    /**
+     * @brief Modo standby: aplica los lotes del primario hasta que este cae;
+     *        entonces la lista queda lista para operar como primario.
+     * @return LSN del último cambio aplicado (y confirmado).
+     */
+    unsigned long long seguirPrimario(const char* ruta) {
+        sockaddr_un dir;
+        std::memset(&dir, 0, sizeof(dir));
+        dir.sun_family = AF_UNIX;
+        std::strncpy(dir.sun_path, ruta, sizeof(dir.sun_path) - 1);
+        int fd = -1;
+        for (int intento = 0; intento < 100 && fd < 0; ++intento) {
+            fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd >= 0 && connect(fd, (sockaddr*)&dir, sizeof(dir)) != 0) {
+                close(fd);
+                fd = -1;
+                timespec ts = { 0, 100000000 };
+                nanosleep(&ts, NULL);
+            }
+        }
+        if (fd < 0) {
+            printf("[Standby] No se pudo conectar a %s.\n", ruta);
+            return 0;
+        }
+        printf("[Standby] Siguiendo al primario en %s.\n", ruta);
+
+        size_t capHandles = 64;
+        SensorBase** porHandle = new SensorBase*[capHandles]();
+        unsigned char* carga = new unsigned char[ReplicadorPrimario::MAX_LOTE];
+        unsigned long long aplicado = 0, operaciones = 0, lotes = 0, nsAplicar = 0;
+        ReplicadorPrimario::Lote l;
+        const char* error = NULL;
+        while (!error && leerCompleto(fd, &l, sizeof(l))) {
+            if (l.magia != ReplicadorPrimario::MAGIA_LOTE || l.bytes > ReplicadorPrimario::MAX_LOTE) {
+                error = "encabezado de lote invalido";
+                break;
+            }
+            if (!leerCompleto(fd, carga, l.bytes)) break;
+            unsigned long long t0 = relojNs();
+            for (size_t off = 0; off < l.bytes;) {
+                // Cada operación (encabezado y carga) debe caber en lo que
+                // queda del lote antes de tocar sus datos.
+                ReplicadorPrimario::Operacion o;
+                if (l.bytes - off < sizeof(o)) { error = "operacion truncada"; break; }
+                std::memcpy(&o, carga + off, sizeof(o));
+                if (o.bytes > l.bytes - off - sizeof(o)) { error = "carga fuera del lote"; break; }
+                if (o.handle >= ReplicadorPrimario::MAX_HANDLES) { error = "handle fuera de rango"; break; }
+                size_t minimo = o.op == ReplicadorPrimario::OP_ALTA      ? 50
+                              : o.op == ReplicadorPrimario::OP_LECTURA   ? 4 + sizeof(long long)
+                              : 0;
+                if (o.bytes < minimo) { error = "carga mas corta que su operacion"; break; }
+                const unsigned char* datos = carga + off + sizeof(o);
+                off += sizeof(o) + o.bytes;
+                if (o.handle >= capHandles) {
+                    size_t nueva = capHandles;
+                    while (nueva <= o.handle) nueva *= 2;
+                    SensorBase** mayor = new SensorBase*[nueva]();
+                    std::memcpy(mayor, porHandle, capHandles * sizeof(SensorBase*));
+                    delete[] porHandle;
+                    porHandle = mayor;
+                    capHandles = nueva;
+                }
+                SensorBase*& s = porHandle[o.handle];
+                if (o.op == ReplicadorPrimario::OP_ALTA) {
+                    char id[50];
+                    std::memcpy(id, datos, sizeof(id));
+                    id[sizeof(id) - 1] = '\0';
+                    s = buscarPorNombre(id);
+                    if (!s && (s = crearSensor((TipoSensor)o.tipo, id)) != NULL) push_back(s);
+                } else if (s && o.op == ReplicadorPrimario::OP_LECTURA) {
+                    long long marca;
+                    std::memcpy(&marca, datos + 4, sizeof(marca));
+                    s->reproducirLectura(datos, (unsigned char)o.banderas, marca);
+                } else if (s && o.op == ReplicadorPrimario::OP_CARGA) {
+                    FILE* f = fmemopen(const_cast<unsigned char*>(datos), o.bytes, "rb");
+                    if (f) {
+                        s->aplicarDelta(f, false, o.cnt);
+                        std::fclose(f);
+                    }
+                } else if (s && o.op == ReplicadorPrimario::OP_PROCESADO) {
+                    s->procesarLectura();
+                }
+                operaciones++;
+            }
+            nsAplicar += relojNs() - t0;
+            if (error) break; // el lote corrupto no se confirma
+            aplicado = l.ultimoLsn;
+            lotes++;
+            if (!escribirCompleto(fd, &aplicado, sizeof(aplicado))) break;
+        }
+        close(fd);
+        delete[] carga;
+        delete[] porHandle;
+        if (error) printf("\n[Standby] Lote rechazado: %s; se corta la replicacion.\n", error);
+        printf("\n[Standby] Primario perdido: promovido con %zu sensores (LSN aplicado %llu).\n", n, aplicado);
+        printf("  %llu operaciones en %llu lotes, %.0f ns por operacion al aplicar\n", operaciones, lotes,
+               operaciones ? (double)nsAplicar / (double)operaciones : 0.0);
+        return aplicado;
+    }
+
+    /**
+     * @brief Publica desde ahora las lecturas de todos los sensores en un
+     *        anillo de memoria compartida para consumidores locales.
+     */
+    bool publicarEnMemoriaCompartida(const char* nombre) {
+        if (!anillo.crear(nombre)) {
+            printf("[Anillo] No se pudo crear %s.\n", nombre);
+            return false;
+        }
+        for (Nodo* it = cabeza; it; it = it->siguiente) {
+            anillo.nombrar(it->sensor->getHandle(), it->sensor->getNombre());
+            it->sensor->adjuntarAnillo(&anillo);
+        }
+        printf("[Anillo] Publicando lecturas en %s.\n", nombre);
+        return true;
+    }
+
+    /**
+     * @brief Agrega a la lista los sensores de una instantánea IOTSNAP2.
+     */
+    bool cargarInstantanea(const char* ruta) {
+        FILE* f = std::fopen(ruta, "rb");
+        if (!f) {
+            printf("[Instantanea] No se pudo abrir %s.\n", ruta);
+            return false;
+        }
+        char magia[8];
+        unsigned long long cuenta = 0;
+        bool ok = std::fread(magia, 8, 1, f) == 1 && std::memcmp(magia, "IOTSNAP2", 8) == 0 &&
+                  std::fread(&cuenta, sizeof(cuenta), 1, f) == 1;
+        unsigned long long cargados = 0;
+        while (ok && cargados < cuenta) {
+            SensorBase* s = leerSensorInstantanea(f);
+            if (!s) { ok = false; break; }
+            push_back(s);
+            cargados++;
+        }
+        std::fclose(f);
+        printf("[Instantanea] %s: %llu sensores cargados%s.\n", ruta, cargados,
+               ok ? "" : " (archivo truncado o invalido)");
+        return ok;
+    }
+
+    /**
+     * @brief Activa el almacenamiento mapeado. Si el archivo ya existe, sus
+     *        sensores vuelven a la lista sin leer sus registros; cada
+     *        historial se hidrata en O(n) cuando se lo necesita.
+     * @param capacidad Tamaño de la tabla de sensores al crear el archivo.
+     */
+    bool abrirPersistente(const char* ruta, unsigned capacidad = 1024) {
+        unsigned long long t0 = relojNs();
+        size_t reparadas = 0;
+        if (!mapa.abrir(ruta, capacidad, reparadas)) {
+            printf("[Persistencia] No se pudo abrir %s.\n", ruta);
+            return false;
+        }
+        for (unsigned i = 0; i < mapa.numSensores(); ++i) {
+            const AlmacenMapeado::Entrada& e = mapa.entrada(i);
+            SensorBase* s = crearSensor((TipoSensor)e.tipo, e.nombre);
+            if (!s) continue;
+            s->adjuntarPersistencia(&mapa, i, e.cabeza != 0);
+            push_back(s);
+        }
+        printf("[Persistencia] %s: %u sensores en linea en %.1f us (%llu bytes, %zu reparaciones%s).\n",
+               ruta, mapa.numSensores(), (relojNs() - t0) / 1000.0, mapa.bytesArchivo(), reparadas,
+               mapa.recuperadoTrasCorte() ? ", cierre anterior no limpio" : "");
+        return true;
+    }
+
+    /**
+     * @brief Procesa los sensores cuyo turno ya venció.
+     */
+    size_t ejecutarPlanificados() { return planificador.ejecutarPendientes(); }
+
+    /**
+     * @brief Ejecuta el planificador durante `segundos`, durmiendo hasta cada
+     *        vencimiento, e imprime el reporte de jitter y latencia.
+     */
+    void ejecutarPlanificadorDurante(double segundos) {
+        unsigned long long fin = relojNs() + (unsigned long long)(segundos * 1e9);
+        while (true) {
+            unsigned long long ahora = relojNs();
+            if (ahora >= fin) break;
+            unsigned long long vence = fin;
+            if (planificador.proximo(vence) && vence > fin) vence = fin;
+            if (vence > ahora) {
+                unsigned long long espera = vence - ahora;
+                timespec ts;
+                ts.tv_sec = (time_t)(espera / 1000000000ULL);
+                ts.tv_nsec = (long)(espera % 1000000000ULL);
+                nanosleep(&ts, NULL);
+            }
+            planificador.ejecutarPendientes();
+        }
+        planificador.imprimirReporte();
+    }
+
+    /**
+     * @brief Emite las alertas de silencio pendientes.
+     */
+    size_t revisarLatidos() { return latidos.revisar(); }
+
+    /**
+     * @brief Milisegundos hasta el próximo temporizador (latidos o turno del
+     *        planificador), para usar como timeout de poll(); -1 si no hay
+     *        ninguno.
+     */
+    int msHastaProximoEvento() const {
+        unsigned long long falta = ~0ULL;
+        unsigned long long vence;
+        if (latidos.proximoMs(vence)) {
+            unsigned long long ahora = relojMs();
+            falta = vence > ahora ? vence - ahora : 0;
+        }
+        if (planificador.proximo(vence)) {
+            unsigned long long ahora = relojNs();
+            // Redondeo hacia arriba: despertar antes solo gira en vacío.
+            unsigned long long ms = vence > ahora ? (vence - ahora + 999999ULL) / 1000000ULL : 0;
+            if (ms < falta) falta = ms;
+        }
+        if (falta == ~0ULL) return -1;
+        return falta > 60000ULL ? 60000 : (int)falta;
+    }
+
+    /**
+     * @brief Atiende los temporizadores vencidos mientras el menú espera.
+     * @return Alertas emitidas más sensores procesados.
+     */
+    size_t atenderTemporizadores() { return revisarLatidos() + ejecutarPlanificados(); }
+
+    void imprimirResumen() const {
+        printf("\n--- Sensores en la lista (%zu) ---\n", n);
+        Nodo* it = cabeza;
+        while (it) {
+            it->sensor->imprimirInfo();
+            it = it->siguiente;
+        }
+    }
+};
+
+/* ============================================================
+ *    Utilidades de “Serial” simulado (opcional)
+ * ============================================================*/
+
+/**
+ * @brief Parsea una línea con formato "ID,valor[,secuencia]" y registra en el
+ *        sensor si existe. Con secuencia, las retransmisiones se descartan
+ *        antes de registrar (ver VentanaSecuencia).
+ * @param linea Ej: "T-001,45.3", "P-105,85" o "P-105,85,1042"
+ * @param lista Referencia a la lista polimórfica
+ * @param llegadaTsc Ciclos del Trazador cuando llegó la línea (0 = ahora)
+ * @return true si se pudo registrar, false en caso contrario.
+ */
+bool procesarLineaSerial(const char* linea, ListaGeneral& lista, unsigned long long llegadaTsc = 0) {
+    if (!linea) return false;
+    Trazador& tr = Trazador::global();
+    unsigned long long inicioParseo = tr.estaActivo() ? Trazador::ciclos() : 0;
+    if (!llegadaTsc) llegadaTsc = inicioParseo;
+
+    // copias temporales (sin STL)
+    char id[64] = {0};
+    char valor[64] = {0};
+
+    const char* coma = std::strchr(linea, ',');
+    if (!coma) return false;
+
+    size_t lenId = (size_t)(coma - linea);
+    if (lenId >= sizeof(id)) lenId = sizeof(id) - 1;
+    std::memcpy(id, linea, lenId);
+    id[lenId] = '\0';
+
+    const char* pVal = coma + 1;
+    std::strncpy(valor, pVal, sizeof(valor) - 1);
+    // limpiar salto de línea
+    size_t lv = std::strlen(valor);
+    if (lv && (valor[lv-1] == '\n' || valor[lv-1] == '\r')) valor[lv-1] = '\0';
+
+    // Número de secuencia opcional del puente: "ID,valor,seq"
+    char* comaSeq = std::strchr(valor, ',');
+    unsigned long long seq = 0;
+    if (comaSeq) {
+        char* fin = NULL;
+        seq = std::strtoull(comaSeq + 1, &fin, 10);
+        if (fin == comaSeq + 1) {
+            printf("[Serial] Secuencia invalida: %s\n", comaSeq + 1);
+            return false;
+        }
+        *comaSeq = '\0';
+    }
+
+    SensorBase* s = lista.buscarPorNombre(id);
+    if (!s) {
+        printf("[Serial] ID no encontrado: %s\n", id);
+        return false;
+    }
+    if (comaSeq && s->consultarSecuencia(seq) != VentanaSecuencia::NUEVA) {
+        VentanaSecuencia::Resultado r = s->aceptarSecuencia(seq); // solo la cuenta
+        if (registroDetallado())
+            printf("[Serial] %s #%llu descartada (%s).\n", id, seq,
+                   r == VentanaSecuencia::DUPLICADA ? "duplicada" : "tardia");
+        return false;
+    }
+    unsigned long long finParseo = tr.estaActivo() ? Trazador::ciclos() : 0;
+    bool ok = s->registrarDesdeTexto(valor);
+    if (ok && comaSeq) s->aceptarSecuencia(seq); // recién aplicada ocupa su número
+    if (!ok) {
+        printf("[Serial] Valor inválido para %s: %s\n", id, valor);
+    } else if (tr.estaActivo()) {
+        tr.lectura(id, llegadaTsc, inicioParseo, finParseo, Trazador::ciclos());
+        s->marcarLlegada(llegadaTsc);
+    }
+    lista.aplicarPresupuesto();
+    return ok;
+}
+
+/**
+ * @brief Modo consumidor: lee el anillo durante `segundos`, mostrando cada
+ *        lectura (si `mostrar`) y la latencia publicación -> consumo en ns.
+ * @param dormir false = espera activa con pausa (latencia real del anillo,
+ *        un núcleo ocupado); true = dormir 50 us entre sondeos vacíos (poca
+ *        CPU, pero la latencia medida pasa a ser ese sueño).
+ */
+int ejecutarSuscriptor(const char* nombre, double segundos, bool mostrar, bool dormir) {
+    ConsumidorAnillo c;
+    if (!c.conectar(nombre)) {
+        printf("[Suscriptor] No se pudo conectar a %s.\n", nombre);
+        return 1;
+    }
+    HistogramaLatencia latencia;
+    unsigned long long fin = relojNs() + (unsigned long long)(segundos * 1e9);
+    AnilloCompartido::Registro r;
+    while (relojNs() < fin) {
+        if (!dormir) {
+            if (!c.leerGirando(r, 4096)) continue; // el reloj se consulta cada 4096 giros
+        } else if (!c.leer(r)) {
+            timespec ts = { 0, 50000 }; // 50 us entre sondeos vacíos
+            nanosleep(&ts, NULL);
+            continue;
+        }
+        latencia.registrar(relojNs() - r.marcaNs);
+        if (mostrar) printf("[Suscriptor] %s = %.3f\n", c.nombreDe(r.handle), r.valor);
+    }
+    printf("\n--- Suscriptor %s (%s) ---\n  Perdidos por sobrescritura: %llu\n", nombre,
+           dormir ? "sondeo con sueno de 50 us" : "espera activa", c.getPerdidos());
+    latencia.imprimirNs("Publicar -> consumir:");
+    return 0;
+}
+
+/**
+ * @brief Prueba automática de conmutación (--prueba-failover [lecturas]).
+ * @details Un hijo hace de primario con replicación hacia este proceso, que
+ *          hace de standby. El primario registra lecturas por la ruta normal
+ *          (confirmando cada una con el standby), anota cuántas quedaron
+ *          confirmadas, agrega algunas más sin confirmar y muere con SIGKILL.
+ *          El standby promovido debe tener exactamente las confirmadas. Una
+ *          segunda fase envía un lote con una operación que se sale del lote
+ *          y verifica que el standby lo rechaza sin aplicarlo ni confirmarlo.
+ * @return 0 si ambas fases pasan.
+ */
+int ejecutarPruebaFailover(size_t lecturas) {
+    char ruta[108];
+    std::snprintf(ruta, sizeof(ruta), "/tmp/iot_failover_%d.sock", (int)getpid());
+    int tubo[2];
+    if (pipe(tubo) != 0) return 1;
+    std::fflush(stdout);
+
+    pid_t primario = fork();
+    if (primario < 0) return 1;
+    if (primario == 0) {
+        close(tubo[0]);
+        if (!std::freopen("/dev/null", "w", stdout)) _exit(2);
+        ListaGeneral g;
+        if (!g.replicarEn(ruta)) _exit(2);
+        SensorBase* t = new SensorTemperatura("F-TEMP");
+        SensorBase* p = new SensorPresion("F-PRES");
+        g.push_back(t);
+        g.push_back(p);
+        g.sincronizarReplica();
+        char texto[32];
+        for (size_t i = 0; i < lecturas; ++i) {
+            std::snprintf(texto, sizeof(texto), "%.2f", 20.0 + (double)(i % 97) * 0.25);
+            t->registrarDesdeTexto(texto);
+            std::snprintf(texto, sizeof(texto), "%u", 1000u + (unsigned)(i % 31));
+            p->registrarDesdeTexto(texto);
+            if (i == lecturas / 2) t->procesarLectura(); // elimina la mínima también en el standby
+            if (!g.sincronizarReplica()) _exit(3);
+        }
+        unsigned long long confirmadas[2] = { t->lecturasHistorial(), p->lecturasHistorial() };
+        if (write(tubo[1], confirmadas, sizeof(confirmadas)) != (ssize_t)sizeof(confirmadas)) _exit(4);
+        // Cola sin confirmar: queda en el lote en construcción y se pierde.
+        for (int i = 0; i < 5; ++i) t->registrarDesdeTexto("99.5");
+        kill(getpid(), SIGKILL);
+        _exit(5);
+    }
+    close(tubo[1]);
+
+    ListaGeneral standby;
+    unsigned long long aplicado = standby.seguirPrimario(ruta);
+    unsigned long long esperado[2] = { 0, 0 };
+    bool recibido = read(tubo[0], esperado, sizeof(esperado)) == (ssize_t)sizeof(esperado);
+    close(tubo[0]);
+    int estado = 0;
+    waitpid(primario, &estado, 0);
+    SensorBase* t = standby.buscarPorNombre("F-TEMP");
+    SensorBase* p = standby.buscarPorNombre("F-PRES");
+    unsigned long long tieneT = t ? t->lecturasHistorial() : 0, tieneP = p ? p->lecturasHistorial() : 0;
+    bool fase1 = recibido && WIFSIGNALED(estado) && t && p && tieneT == esperado[0] && tieneP == esperado[1];
+    printf("[Failover] Fase 1: primario muerto por %s; confirmadas T=%llu P=%llu, en el standby T=%llu P=%llu "
+           "(LSN %llu): %s\n", WIFSIGNALED(estado) ? "SIGKILL" : "salida", esperado[0], esperado[1],
+           tieneT, tieneP, aplicado, fase1 ? "OK" : "FALLO");
+
+    // Fase 2: lote con una operación cuya carga declara más bytes que el lote.
+    std::snprintf(ruta, sizeof(ruta), "/tmp/iot_failover_%d_b.sock", (int)getpid());
+    std::fflush(stdout);
+    pid_t malo = fork();
+    if (malo < 0) return 1;
+    if (malo == 0) {
+        sockaddr_un dir;
+        std::memset(&dir, 0, sizeof(dir));
+        dir.sun_family = AF_UNIX;
+        std::snprintf(dir.sun_path, sizeof(dir.sun_path), "%s", ruta);
+        unlink(ruta);
+        int fe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fe < 0 || bind(fe, (sockaddr*)&dir, sizeof(dir)) != 0 || listen(fe, 1) != 0) _exit(2);
+        int fd = accept(fe, NULL, NULL);
+        if (fd < 0) _exit(2);
+        unsigned char carga[sizeof(ReplicadorPrimario::Operacion) + 16];
+        std::memset(carga, 0, sizeof(carga));
+        ReplicadorPrimario::Operacion o;
+        std::memset(&o, 0, sizeof(o));
+        o.lsn = 1;
+        o.op = ReplicadorPrimario::OP_CARGA;
+        o.bytes = 60000; // fuera del lote
+        o.cnt = 5000;
+        std::memcpy(carga, &o, sizeof(o));
+        ReplicadorPrimario::Lote l = { ReplicadorPrimario::MAGIA_LOTE, (unsigned)sizeof(carga), 1 };
+        if (!escribirCompleto(fd, &l, sizeof(l)) || !escribirCompleto(fd, carga, sizeof(carga))) _exit(2);
+        unsigned long long ack;
+        bool confirmo = leerCompleto(fd, &ack, sizeof(ack));
+        close(fd);
+        close(fe);
+        unlink(ruta);
+        _exit(confirmo ? 1 : 0);
+    }
+    ListaGeneral segundo;
+    unsigned long long aplicado2 = segundo.seguirPrimario(ruta);
+    waitpid(malo, &estado, 0);
+    bool fase2 = aplicado2 == 0 && segundo.size() == 0 && WIFEXITED(estado) && WEXITSTATUS(estado) == 0;
+    printf("[Failover] Fase 2: lote corrupto %s: %s\n",
+           fase2 ? "rechazado sin aplicar ni confirmar" : "aceptado", fase2 ? "OK" : "FALLO");
+    std::fflush(stdout);
+    if (!std::freopen("/dev/null", "w", stdout)) return 1; // silencia los destructores
+    return fase1 && fase2 ? 0 : 1;
+}
+
+/* ============================================================
+ *         Modo cluster: router + trabajadores por hash
+ * ============================================================*/
+
+/// FNV-1a de 32 bits sobre una cadena, con mezcla final (fmix32) para que
+/// IDs casi iguales ("P-1", "P-2") se repartan por todo el anillo.
+inline unsigned hashFnv1a(const char* texto) {
+    unsigned h = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)texto; *p; ++p) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * @brief Anillo de hash consistente con nodos virtuales: al agregar un
+ *        trabajador solo cambian de dueño ~1/N de los sensores.
+ */
+class AnilloHash {
+public:
+    static const unsigned VIRTUALES = 64;
+
+private:
+    struct Punto {
+        unsigned hash;
+        unsigned trabajador;
+    };
+    Punto* puntos;
+    size_t n, capacidad;
+
+    AnilloHash(const AnilloHash&);
+    AnilloHash& operator=(const AnilloHash&);
+
+public:
+    AnilloHash() : puntos(NULL), n(0), capacidad(0) {}
+    ~AnilloHash() { delete[] puntos; }
+
+    void agregarTrabajador(unsigned t) {
+        if (n + VIRTUALES > capacidad) {
+            size_t nueva = capacidad ? capacidad * 2 : VIRTUALES * 4;
+            while (nueva < n + VIRTUALES) nueva *= 2;
+            Punto* mayor = new Punto[nueva];
+            if (n) std::memcpy(mayor, puntos, n * sizeof(Punto));
+            delete[] puntos;
+            puntos = mayor;
+            capacidad = nueva;
+        }
+        for (unsigned v = 0; v < VIRTUALES; ++v) {
+            char clave[32];
+            std::snprintf(clave, sizeof(clave), "trabajador-%u#%u", t, v);
+            Punto p = { hashFnv1a(clave), t };
+            size_t i = n++;
+            while (i > 0 && puntos[i - 1].hash > p.hash) { // inserción ordenada
+                puntos[i] = puntos[i - 1];
+                --i;
+            }
+            puntos[i] = p;
+        }
+    }
+
+    /// Trabajador dueño de `id`: primer punto en sentido horario.
+    unsigned dueno(const char* id) const {
+        unsigned h = hashFnv1a(id);
+        size_t lo = 0, hi = n;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (puntos[mid].hash < h) lo = mid + 1;
+            else hi = mid;
+        }
+        return puntos[lo == n ? 0 : lo].trabajador;
+    }
+};
+
+/// Mensajes entre router y trabajadores (encabezado + carga útil).
+enum TipoMensajeCluster {
+    MSG_CREAR = 1,     ///< tipo (1 byte) + nombre
+    MSG_LINEAS = 2,    ///< Lote de líneas "ID,valor\n"
+    MSG_PROCESAR = 3,  ///< procesarTodos() y responde ResumenCluster
+    MSG_RESUMEN = 4,   ///< Responde ResumenCluster
+    MSG_MIGRAR = 5,    ///< nombre; responde el sensor serializado + ExtrasMigracion y lo suelta
+    MSG_ADOPTAR = 6,   ///< Sensor serializado a incorporar
+    MSG_SENSORES = 7,  ///< Responde un ResumenSensorCluster por sensor
+    MSG_BOCETOS = 8    ///< acción (1 byte) + prefijo; responde sensores del grupo [+ BocetoSensor]
+};
+
+/// Acción de MSG_BOCETOS; la consulta responde además el boceto combinado.
+enum AccionBocetos { BOCETOS_DESACTIVAR = 0, BOCETOS_ACTIVAR = 1, BOCETOS_CONSULTAR = 2 };
+
+struct MensajeCluster {
+    unsigned tipo;
+    unsigned bytes;
+};
+
+/// Estado del sensor que la instantánea no lleva; sigue a ella en MSG_MIGRAR.
+struct ExtrasMigracion {
+    unsigned char modoCuantizacion; ///< 0 = sin archivo cuantizado
+    unsigned char conBoceto;        ///< 1: sigue un BocetoSensor
+    double errorCuantizacion;       ///< Cota del origen, heredada por el destino
+};
+
+inline bool enviarMensaje(int fd, unsigned tipo, const void* datos, size_t bytes) {
+    MensajeCluster m = { tipo, (unsigned)bytes };
+    return escribirCompleto(fd, &m, sizeof(m)) && (bytes == 0 || escribirCompleto(fd, datos, bytes));
+}
+
+/**
+ * @brief Lee un mensaje completo; `datos` se agranda si hace falta.
+ */
+inline bool recibirMensaje(int fd, MensajeCluster& m, unsigned char*& datos, size_t& capacidad) {
+    if (!leerCompleto(fd, &m, sizeof(m))) return false;
+    if (m.bytes + 1 > capacidad) {
+        delete[] datos;
+        capacidad = m.bytes + 1;
+        datos = new unsigned char[capacidad];
+    }
+    if (m.bytes && !leerCompleto(fd, datos, m.bytes)) return false;
+    datos[m.bytes] = '\0';
+    return true;
+}
+
+/**
+ * @brief Bucle de un proceso trabajador: su propia ListaGeneral, alimentada
+ *        por el router. La salida de los sensores se descarta; los
+ *        resultados vuelven al router como ResumenCluster.
+ */
+int ejecutarTrabajador(int fd) {
+    if (!std::freopen("/dev/null", "w", stdout)) return 1;
+    ListaGeneral lista;
+    ResumenCluster acumulado; // rechazadas y latencias de lotes
+    size_t capacidad = 4096;
+    unsigned char* datos = new unsigned char[capacidad];
+    MensajeCluster m;
+    while (recibirMensaje(fd, m, datos, capacidad)) {
+        if (m.tipo == MSG_CREAR && m.bytes > 1) {
+            const char* id = (const char*)datos + 1;
+            if (!lista.buscarPorNombre(id)) {
+                SensorBase* s = crearSensor((TipoSensor)datos[0], id);
+                if (s) lista.push_back(s);
+            }
+        } else if (m.tipo == MSG_LINEAS) {
+            unsigned long long t0 = relojNs();
+            unsigned long long llegada = Trazador::global().estaActivo() ? Trazador::ciclos() : 0;
+            char* linea = (char*)datos;
+            while (*linea) {
+                char* fin = std::strchr(linea, '\n');
+                if (fin) *fin = '\0';
+                if (!procesarLineaSerial(linea, lista, llegada)) acumulado.rechazadas++;
+                if (!fin) break;
+                linea = fin + 1;
+            }
+            acumulado.latenciaLote.registrar(relojNs() - t0);
+        } else if (m.tipo == MSG_PROCESAR || m.tipo == MSG_RESUMEN) {
+            if (m.tipo == MSG_PROCESAR) lista.procesarTodos();
+            ResumenCluster r;
+            r.rechazadas = acumulado.rechazadas;
+            r.latenciaLote = acumulado.latenciaLote;
+            lista.resumir(r);
+            if (!enviarMensaje(fd, m.tipo, &r, sizeof(r))) break;
+        } else if (m.tipo == MSG_SENSORES) {
+            ResumenSensorCluster* rs = new ResumenSensorCluster[lista.size() ? lista.size() : 1];
+            lista.resumirPorSensor(rs);
+            bool enviado = enviarMensaje(fd, MSG_SENSORES, rs, lista.size() * sizeof(ResumenSensorCluster));
+            delete[] rs;
+            if (!enviado) break;
+        } else if (m.tipo == MSG_BOCETOS && m.bytes >= 1) {
+            const char* prefijo = (const char*)datos + 1;
+            unsigned char* r = new unsigned char[sizeof(unsigned long long) + sizeof(BocetoSensor)];
+            BocetoSensor* b = new BocetoSensor(); // 6 KB: fuera de la pila
+            unsigned long long c;
+            size_t bytes = sizeof(c);
+            if (datos[0] == BOCETOS_CONSULTAR) {
+                c = lista.combinarBocetos(prefijo, *b);
+                std::memcpy(r + sizeof(c), b, sizeof(BocetoSensor));
+                bytes += sizeof(BocetoSensor);
+            } else {
+                c = lista.configurarBocetos(prefijo, datos[0] == BOCETOS_ACTIVAR);
+            }
+            std::memcpy(r, &c, sizeof(c));
+            bool enviado = enviarMensaje(fd, MSG_BOCETOS, r, bytes);
+            delete b;
+            delete[] r;
+            if (!enviado) break;
+        } else if (m.tipo == MSG_MIGRAR) {
+            SensorBase* s = lista.extraer((const char*)datos);
+            if (s) s->cerrarTramoComprimido(); // el compresor no viaja con el sensor
+            FILE* f = s ? std::tmpfile() : NULL;
+            bool ok = f && s->escribirInstantanea(f) >= 0;
+            // Lo que no es parte de la instantánea viaja a continuación.
+            if (ok) {
+                ExtrasMigracion x;
+                std::memset(&x, 0, sizeof(x));
+                if (s->tipoSensor() == TIPO_TEMPERATURA) {
+                    const SensorTemperatura* t = static_cast<const SensorTemperatura*>(s);
+                    x.modoCuantizacion = (unsigned char)t->modoCuantizacion();
+                    x.errorCuantizacion = t->errorCuantizacion();
+                }
+                x.conBoceto = s->getBoceto() != NULL;
+                ok = std::fwrite(&x, sizeof(x), 1, f) == 1 &&
+                     (!x.conBoceto || std::fwrite(s->getBoceto(), sizeof(BocetoSensor), 1, f) == 1);
+            }
+            long bytes = ok ? std::ftell(f) : 0;
+            unsigned char* crudo = new unsigned char[bytes > 0 ? bytes : 1];
+            if (ok) {
+                std::rewind(f);
+                ok = std::fread(crudo, (size_t)bytes, 1, f) == 1;
+            }
+            if (f) std::fclose(f);
+            delete s;
+            bool enviado = enviarMensaje(fd, MSG_MIGRAR, crudo, ok ? (size_t)bytes : 0);
+            delete[] crudo;
+            if (!enviado) break;
+        } else if (m.tipo == MSG_ADOPTAR && m.bytes) {
+            FILE* f = fmemopen(datos, m.bytes, "rb");
+            SensorBase* s = f ? leerSensorInstantanea(f) : NULL;
+            ExtrasMigracion x;
+            if (s && std::fread(&x, sizeof(x), 1, f) == 1) {
+                if (x.modoCuantizacion && s->tipoSensor() == TIPO_TEMPERATURA)
+                    static_cast<SensorTemperatura*>(s)->configurarCuantizacion(x.modoCuantizacion,
+                                                                                x.errorCuantizacion);
+                BocetoSensor* b = new BocetoSensor(); // 6 KB: fuera de la pila
+                if (x.conBoceto && std::fread(b, sizeof(BocetoSensor), 1, f) == 1) s->adoptarBoceto(*b);
+                delete b;
+            }
+            if (f) std::fclose(f);
+            if (s) lista.push_back(s);
+        }
+    }
+    delete[] datos;
+    close(fd);
+    return 0;
+}
+
+/**
+ * @brief Router del modo cluster: asigna cada sensor a un proceso
+ *        trabajador por hash consistente de su ID, reenvía las líneas en
+ *        lotes por sockets locales y combina las respuestas.
+ */
+class RouterCluster {
+public:
+    static const unsigned MAX_TRABAJADORES = 64;
+    static const size_t LOTE = 4096;
+
+private:
+    struct Trabajador {
+        int fd;
+        pid_t pid;
+        char lote[LOTE];
+        size_t usado;
+        unsigned long long lineas;
+    };
+
+    /// Sensores conocidos, para saber qué mover al rebalancear.
+    struct Registrado {
+        char nombre[50];
+        unsigned trabajador;
+        Registrado* siguiente;
+    };
+
+    Trabajador* trabajadores[MAX_TRABAJADORES];
+    unsigned cuantos;
+    AnilloHash anillo;
+    Registrado* registrados;
+    size_t capacidadRespuesta;
+    unsigned char* respuesta;
+
+    RouterCluster(const RouterCluster&);
+    RouterCluster& operator=(const RouterCluster&);
+
+    void enviarLote(Trabajador& t) {
+        if (t.usado == 0) return;
+        if (!enviarMensaje(t.fd, MSG_LINEAS, t.lote, t.usado))
+            printf("[Cluster] Trabajador %d no responde.\n", (int)t.pid);
+        t.usado = 0;
+    }
+
+    void enviarLotes() {
+        for (unsigned i = 0; i < cuantos; ++i) enviarLote(*trabajadores[i]);
+    }
+
+    /**
+     * @brief Envía la consulta a todos los trabajadores (en paralelo) y
+     *        combina sus resúmenes.
+     */
+    bool consultar(unsigned tipo, ResumenCluster& total) {
+        enviarLotes();
+        for (unsigned i = 0; i < cuantos; ++i) enviarMensaje(trabajadores[i]->fd, tipo, NULL, 0);
+        bool ok = true;
+        for (unsigned i = 0; i < cuantos; ++i) {
+            MensajeCluster m;
+            if (!recibirMensaje(trabajadores[i]->fd, m, respuesta, capacidadRespuesta) ||
+                m.bytes != sizeof(ResumenCluster)) {
+                ok = false;
+                continue;
+            }
+            ResumenCluster* r = new ResumenCluster(); // ~4 KB: fuera de la pila
+            std::memcpy((void*)r, respuesta, sizeof(ResumenCluster));
+            printf("  Trabajador %u (pid %d): %llu sensores, %llu lineas recibidas\n", i,
+                   (int)trabajadores[i]->pid, r->sensores, trabajadores[i]->lineas);
+            total.combinar(*r);
+            delete r;
+        }
+        return ok;
+    }
+
+public:
+    RouterCluster() : cuantos(0), registrados(NULL), capacidadRespuesta(4096) {
+        respuesta = new unsigned char[capacidadRespuesta];
+    }
+
+    ~RouterCluster() {
+        enviarLotes();
+        for (unsigned i = 0; i < cuantos; ++i) {
+            close(trabajadores[i]->fd); // EOF: el trabajador termina
+            waitpid(trabajadores[i]->pid, NULL, 0);
+            delete trabajadores[i];
+        }
+        while (registrados) {
+            Registrado* sig = registrados->siguiente;
+            delete registrados;
+            registrados = sig;
+        }
+        delete[] respuesta;
+    }
+
+    unsigned numTrabajadores() const { return cuantos; }
+
+    /**
+     * @brief Lanza un trabajador nuevo y le mueve los sensores que ahora le
+     *        corresponden según el anillo.
+     */
+    bool agregarTrabajador() {
+        if (cuantos == MAX_TRABAJADORES) return false;
+        int par[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, par) != 0) return false;
+        std::fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(par[0]);
+            close(par[1]);
+            return false;
+        }
+        if (pid == 0) {
+            close(par[0]);
+            for (unsigned i = 0; i < cuantos; ++i) close(trabajadores[i]->fd);
+            _exit(ejecutarTrabajador(par[1]));
+        }
+        close(par[1]);
+        Trabajador* t = new Trabajador;
+        t->fd = par[0];
+        t->pid = pid;
+        t->usado = 0;
+        t->lineas = 0;
+        trabajadores[cuantos] = t;
+        anillo.agregarTrabajador(cuantos);
+        cuantos++;
+        if (registrados) rebalancear();
+        return true;
+    }
+
+    /**
+     * @brief Mueve a su nuevo dueño cada sensor cuyo punto del anillo cambió.
+     */
+    void rebalancear() {
+        enviarLotes(); // las lecturas en vuelo llegan antes de migrar
+        unsigned long long t0 = relojNs();
+        size_t total = 0, movidos = 0, bytes = 0;
+        for (Registrado* r = registrados; r; r = r->siguiente, ++total) {
+            unsigned nuevo = anillo.dueno(r->nombre);
+            if (nuevo == r->trabajador) continue;
+            MensajeCluster m;
+            if (!enviarMensaje(trabajadores[r->trabajador]->fd, MSG_MIGRAR, r->nombre,
+                               std::strlen(r->nombre) + 1) ||
+                !recibirMensaje(trabajadores[r->trabajador]->fd, m, respuesta, capacidadRespuesta)) {
+                printf("[Cluster] No se pudo migrar %s.\n", r->nombre);
+                continue;
+            }
+            if (m.bytes) enviarMensaje(trabajadores[nuevo]->fd, MSG_ADOPTAR, respuesta, m.bytes);
+            r->trabajador = nuevo;
+            movidos++;
+            bytes += m.bytes;
+        }
+        printf("[Cluster] Rebalanceo a %u trabajadores: %zu de %zu sensores movidos (%.1f%%, %zu bytes) en %.2f ms.\n",
+               cuantos, movidos, total, total ? 100.0 * movidos / total : 0.0, bytes,
+               (relojNs() - t0) / 1e6);
+    }
+
+    void crearSensor(TipoSensor tipo, const char* id) {
+        unsigned t = anillo.dueno(id);
+        for (Registrado* r = registrados; r; r = r->siguiente) {
+            if (std::strcmp(r->nombre, id) == 0) return;
+        }
+        Registrado* r = new Registrado;
+        std::strncpy(r->nombre, id, sizeof(r->nombre) - 1);
+        r->nombre[sizeof(r->nombre) - 1] = '\0';
+        r->trabajador = t;
+        r->siguiente = registrados;
+        registrados = r;
+        unsigned char msg[51];
+        msg[0] = (unsigned char)tipo;
+        std::memcpy(msg + 1, r->nombre, 50);
+        enviarLote(*trabajadores[t]); // mantiene el orden alta -> lecturas
+        enviarMensaje(trabajadores[t]->fd, MSG_CREAR, msg, sizeof(msg));
+    }
+
+    /**
+     * @brief Encola una línea "ID,valor" en el lote de su trabajador.
+     */
+    bool enrutarLinea(const char* linea) {
+        const char* coma = std::strchr(linea, ',');
+        size_t largo = std::strlen(linea);
+        while (largo && (linea[largo - 1] == '\n' || linea[largo - 1] == '\r')) --largo;
+        if (!coma || coma == linea || (size_t)(coma - linea) >= 50 || largo + 1 > LOTE) return false;
+        char id[50];
+        std::memcpy(id, linea, (size_t)(coma - linea));
+        id[coma - linea] = '\0';
+        Trabajador& t = *trabajadores[anillo.dueno(id)];
+        if (t.usado + largo + 1 > LOTE) enviarLote(t);
+        std::memcpy(t.lote + t.usado, linea, largo);
+        t.usado += largo;
+        t.lote[t.usado++] = '\n';
+        t.lineas++;
+        return true;
+    }
+
+    void procesarTodos() {
+        printf("\n--- Procesamiento en el cluster ---\n");
+        ResumenCluster* total = new ResumenCluster();
+        if (!consultar(MSG_PROCESAR, *total)) printf("[Cluster] Faltan respuestas de algun trabajador.\n");
+        total->imprimir();
+        delete total;
+    }
+
+    /**
+     * @brief Pide a todos los trabajadores el agregado de cada sensor y los
+     *        combina por nombre (un sensor en dos trabajadores, p. ej. a
+     *        mitad de un rebalanceo, suma sus partes).
+     */
+    void imprimirPorSensor() {
+        enviarLotes();
+        for (unsigned i = 0; i < cuantos; ++i) enviarMensaje(trabajadores[i]->fd, MSG_SENSORES, NULL, 0);
+        size_t n = 0, cap = 64;
+        ResumenSensorCluster* total = new ResumenSensorCluster[cap];
+        size_t capIndice = 128;
+        long* indice = new long[capIndice]; // hash de nombre -> posición en total (-1 = libre)
+        for (size_t j = 0; j < capIndice; ++j) indice[j] = -1;
+        bool ok = true;
+        for (unsigned i = 0; i < cuantos; ++i) {
+            MensajeCluster m;
+            if (!recibirMensaje(trabajadores[i]->fd, m, respuesta, capacidadRespuesta) ||
+                m.bytes % sizeof(ResumenSensorCluster) != 0) {
+                ok = false;
+                continue;
+            }
+            size_t cuenta = m.bytes / sizeof(ResumenSensorCluster);
+            for (size_t k = 0; k < cuenta; ++k) {
+                ResumenSensorCluster r;
+                std::memcpy(&r, respuesta + k * sizeof(r), sizeof(r));
+                r.nombre[sizeof(r.nombre) - 1] = '\0';
+                if ((n + 1) * 2 > capIndice) {
+                    delete[] indice;
+                    capIndice *= 2;
+                    indice = new long[capIndice];
+                    for (size_t j = 0; j < capIndice; ++j) indice[j] = -1;
+                    for (size_t e = 0; e < n; ++e) {
+                        size_t j = hashFnv1a(total[e].nombre) & (capIndice - 1);
+                        while (indice[j] >= 0) j = (j + 1) & (capIndice - 1);
+                        indice[j] = (long)e;
+                    }
+                }
+                size_t j = hashFnv1a(r.nombre) & (capIndice - 1);
+                while (indice[j] >= 0 && std::strcmp(total[indice[j]].nombre, r.nombre) != 0)
+                    j = (j + 1) & (capIndice - 1);
+                if (indice[j] >= 0) {
+                    total[indice[j]].combinar(r);
+                    continue;
+                }
+                if (n == cap) {
+                    ResumenSensorCluster* mayor = new ResumenSensorCluster[cap * 2];
+                    std::memcpy(mayor, total, n * sizeof(ResumenSensorCluster));
+                    delete[] total;
+                    total = mayor;
+                    cap *= 2;
+                }
+                total[n] = r;
+                indice[j] = (long)n++;
+            }
+        }
+        printf("\n--- Resumen por sensor (%zu sensores, %u trabajadores) ---\n", n, cuantos);
+        if (!ok) printf("[Cluster] Faltan respuestas de algun trabajador.\n");
+        for (size_t e = 0; e < n; ++e) {
+            const ResumenSensorCluster& r = total[e];
+            if (r.lecturas == 0) {
+                printf("  %-20s %s  sin lecturas\n", r.nombre, r.tipo == TIPO_TEMPERATURA ? "Temp" : "Pres");
+                continue;
+            }
+            printf("  %-20s %s  n=%llu  prom=%.3f  min=%.3f  max=%.3f\n", r.nombre,
+                   r.tipo == TIPO_TEMPERATURA ? "Temp" : "Pres", r.lecturas, r.suma / (double)r.lecturas,
+                   r.minimo, r.maximo);
+        }
+        delete[] indice;
+        delete[] total;
+    }
+
+    /**
+     * @brief Activa, descarta o consulta los bocetos del grupo `prefijo` en
+     *        todos los trabajadores. La consulta combina el boceto de cada
+     *        trabajador (combinarBocetos) en `total`, como en una sola lista.
+     * @return Sensores del grupo alcanzados.
+     */
+    size_t bocetos(AccionBocetos accion, const char* prefijo, BocetoSensor& total) {
+        enviarLotes(); // el boceto incluye las lecturas ya enrutadas
+        char msg[51];
+        msg[0] = (char)accion;
+        std::strncpy(msg + 1, prefijo, sizeof(msg) - 2);
+        msg[sizeof(msg) - 1] = '\0';
+        for (unsigned i = 0; i < cuantos; ++i)
+            enviarMensaje(trabajadores[i]->fd, MSG_BOCETOS, msg, std::strlen(msg + 1) + 2);
+        size_t c = 0;
+        bool ok = true;
+        BocetoSensor* parcial = new BocetoSensor(); // 6 KB: fuera de la pila
+        for (unsigned i = 0; i < cuantos; ++i) {
+            MensajeCluster m;
+            unsigned long long n;
+            size_t esperado = sizeof(n) + (accion == BOCETOS_CONSULTAR ? sizeof(BocetoSensor) : 0);
+            if (!recibirMensaje(trabajadores[i]->fd, m, respuesta, capacidadRespuesta) || m.bytes != esperado) {
+                ok = false;
+                continue;
+            }
+            std::memcpy(&n, respuesta, sizeof(n));
+            c += (size_t)n;
+            if (accion != BOCETOS_CONSULTAR) continue;
+            std::memcpy((void*)parcial, respuesta + sizeof(n), sizeof(BocetoSensor));
+            total.combinar(*parcial);
+        }
+        delete parcial;
+        if (!ok) printf("[Cluster] Faltan respuestas de algun trabajador.\n");
+        return c;
+    }
+
+    void imprimirResumen() {
+        printf("\n--- Resumen del cluster (%u trabajadores) ---\n", cuantos);
+        ResumenCluster* total = new ResumenCluster();
+        if (!consultar(MSG_RESUMEN, *total)) printf("[Cluster] Faltan respuestas de algun trabajador.\n");
+        total->imprimir();
+        delete total;
+    }
+};
+
+void menuCluster() {
+    printf("\n--- Modo Cluster (router) ---\n");
+    printf("1) Crear Sensor de Temperatura\n");
+    printf("2) Crear Sensor de Presion\n");
+    printf("3) Inyectar lineas Serial (ID,valor; linea vacia termina)\n");
+    printf("4) Procesar todos (en todos los trabajadores)\n");
+    printf("5) Resumen combinado\n");
+    printf("6) Agregar trabajador y rebalancear\n");
+    printf("7) Resumen por sensor (combinado)\n");
+    printf("8) Bocetos por grupo (activar/consultar en todos los trabajadores)\n");
+    printf("0) Salir\n");
+    printf("Opcion: ");
+}
+
+/**
+ * @brief Punto de entrada de --cluster N.
+ */
+int ejecutarRouter(unsigned trabajadores) {
+    RouterCluster router;
+    for (unsigned i = 0; i < trabajadores; ++i) {
+        if (!router.agregarTrabajador()) {
+            printf("[Cluster] No se pudo lanzar el trabajador %u.\n", i);
+            return 1;
+        }
+    }
+    printf("[Cluster] %u trabajadores en linea.\n", router.numTrabajadores());
+    char buffer[128];
+    while (true) {
+        menuCluster();
+        if (!std::fgets(buffer, sizeof(buffer), stdin)) break;
+        int opcion = std::atoi(buffer);
+        if (opcion == 0) break;
+        if (opcion == 1 || opcion == 2) {
+            char id[64];
+            printf("ID del sensor: ");
+            if (!std::fgets(id, sizeof(id), stdin)) break;
+            size_t l = std::strlen(id);
+            if (l && (id[l-1] == '\n' || id[l-1] == '\r')) id[l-1] = '\0';
+            router.crearSensor(opcion == 1 ? TIPO_TEMPERATURA : TIPO_PRESION, id);
+        }
+        else if (opcion == 3) {
+            char linea[128];
+            unsigned long long enrutadas = 0, invalidas = 0;
+            unsigned long long t0 = relojNs();
+            while (std::fgets(linea, sizeof(linea), stdin) && linea[0] != '\n' && linea[0] != '\r') {
+                if (router.enrutarLinea(linea)) enrutadas++;
+                else invalidas++;
+            }
+            printf("[Cluster] %llu lineas enrutadas (%llu invalidas) en %.2f ms.\n", enrutadas, invalidas,
+                   (relojNs() - t0) / 1e6);
+        }
+        else if (opcion == 4) router.procesarTodos();
+        else if (opcion == 5) router.imprimirResumen();
+        else if (opcion == 6) {
+            if (!router.agregarTrabajador()) printf("[Cluster] No se pudo agregar el trabajador.\n");
+        }
+        else if (opcion == 7) router.imprimirPorSensor();
+        else if (opcion == 8) {
+            char grupo[64], conf[64];
+            printf("Prefijo del grupo (vacio = todos): ");
+            if (!std::fgets(grupo, sizeof(grupo), stdin)) break;
+            size_t l = std::strlen(grupo);
+            if (l && (grupo[l-1] == '\n' || grupo[l-1] == '\r')) grupo[l-1] = '\0';
+            printf("Accion (1 activar | 0 desactivar | 2 [valor]: consultar): ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) break;
+            int accion = -1;
+            double valor = 0.0;
+            int leidos = std::sscanf(conf, "%d %lf", &accion, &valor);
+            if (leidos < 1 || accion < 0 || accion > 2) {
+                printf("Accion invalida.\n");
+                continue;
+            }
+            BocetoSensor* total = new BocetoSensor(); // 6 KB: fuera de la pila
+            size_t c = router.bocetos((AccionBocetos)accion, grupo, *total);
+            if (accion != BOCETOS_CONSULTAR) {
+                printf("Bocetos %s en %zu sensor(es).\n", accion ? "activados" : "desactivados", c);
+            } else if (c == 0) {
+                printf("Ningun sensor del grupo tiene bocetos.\n");
+            } else {
+                printf("Grupo '%s' (%zu sensores, %u trabajadores): %llu lecturas, ~%.0f valores distintos.\n",
+                       grupo, c, router.numTrabajadores(), total->total, total->distintos());
+                if (leidos == 2)
+                    printf("Valor %g: a lo sumo %llu apariciones (exceso <= %.0f con 98%%).\n", valor,
+                           total->frecuencia(valor), total->errorFrecuencia());
+            }
+            delete total;
+        }
+        else printf("Opcion invalida.\n");
+    }
+    return 0;
+}
+
+/* ============================================================
+ *      Ingesta de baja latencia (busy-poll, CPU fija)
+ * ============================================================*/
+
+/**
+ * @brief Lee líneas "ID,valor@marcaNs" de una o más fuentes y las aplica
+ *        con procesarLineaSerial(), midiendo la latencia desde la marca del
+ *        emisor hasta que agregar() terminó.
+ * @details En modo busy-poll la CPU se fija con sched_setaffinity, la
+ *          memoria se bloquea (mlockall) y se pre-toca, y las fuentes se
+ *          sondean sin bloquear; en modo bloqueante se espera con poll().
+ *          El procesamiento de líneas es el mismo en ambos modos.
+ */
+class IngestaBusyPoll {
+public:
+    static const int MAX_FUENTES = 8;
+    static const size_t PILA_PRETOCADA = 256 * 1024;
+
+private:
+    struct Fuente {
+        int fd;
+        char buf[4096];
+        size_t usado;
+        bool descartando;  ///< Saltando el resto de una línea demasiado larga
+    };
+    Fuente fuentes[MAX_FUENTES];
+    int numFuentes;
+    HistogramaLatencia latencia;
+    unsigned long long lineas;
+    unsigned long long sondeosVacios;
+    unsigned long long demasiadoLargas; ///< Líneas que no cabían en buf, descartadas
+
+    IngestaBusyPoll(const IngestaBusyPoll&);
+    IngestaBusyPoll& operator=(const IngestaBusyPoll&);
+
+    void aplicarLinea(char* linea, ListaGeneral& lista, unsigned long long llegadaTsc) {
+        char* arroba = std::strchr(linea, '@');
+        unsigned long long marca = 0;
+        if (arroba) {
+            *arroba = '\0';
+            marca = std::strtoull(arroba + 1, NULL, 10);
+        }
+        procesarLineaSerial(linea, lista, llegadaTsc);
+        if (marca) latencia.registrar(relojNs() - marca);
+        lineas++;
+    }
+
+    /**
+     * @brief Consume las líneas completas del buffer de la fuente. Una línea
+     *        que llena el buffer sin terminar se descarta hasta su '\n' (si
+     *        no, read() recibiría largo 0 y la fuente parecería cerrada).
+     */
+    void drenar(Fuente& f, ListaGeneral& lista, unsigned long long llegadaTsc) {
+        size_t ini = 0;
+        for (size_t i = 0; i < f.usado; ++i) {
+            if (f.buf[i] != '\n') continue;
+            f.buf[i] = '\0';
+            if (f.descartando) f.descartando = false; // fin de la línea larga
+            else aplicarLinea(f.buf + ini, lista, llegadaTsc);
+            ini = i + 1;
+        }
+        if (ini) {
+            std::memmove(f.buf, f.buf + ini, f.usado - ini);
+            f.usado -= ini;
+        }
+        if (f.usado == sizeof(f.buf) - 1 || (f.descartando && f.usado)) {
+            if (!f.descartando) demasiadoLargas++;
+            f.descartando = true;
+            f.usado = 0;
+        }
+    }
+
+public:
+    IngestaBusyPoll() : numFuentes(0), lineas(0), sondeosVacios(0), demasiadoLargas(0) {}
+
+    bool agregarFuente(int fd) {
+        if (numFuentes == MAX_FUENTES) return false;
+        fuentes[numFuentes].fd = fd;
+        fuentes[numFuentes].usado = 0;
+        fuentes[numFuentes].descartando = false;
+        numFuentes++;
+        return true;
+    }
+
+    static bool fijarCpu(int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+
+    /**
+     * @brief mlockall() y pre-toque de la pila. Devuelve false si el bloqueo
+     *        no está permitido (la pila se pre-toca igual).
+     */
+    static bool bloquearMemoria() {
+        bool ok = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+        volatile unsigned char pila[PILA_PRETOCADA];
+        for (size_t i = 0; i < sizeof(pila); i += 4096) pila[i] = 0;
+        return ok;
+    }
+
+    /**
+     * @brief Atiende las fuentes hasta que todas cierren.
+     * @param busyPoll true: sondeo sin bloqueo; false: poll() bloqueante
+     * @param ceder sched_yield() en sondeos vacíos (si el emisor comparte CPU)
+     */
+    void ejecutar(ListaGeneral& lista, bool busyPoll, bool ceder) {
+        for (int i = 0; i < numFuentes; ++i) {
+            int fl = fcntl(fuentes[i].fd, F_GETFL);
+            fcntl(fuentes[i].fd, F_SETFL, busyPoll ? (fl | O_NONBLOCK) : (fl & ~O_NONBLOCK));
+        }
+        int abiertas = numFuentes;
+        struct pollfd pfd[MAX_FUENTES];
+        while (abiertas > 0) {
+            if (!busyPoll) {
+                for (int i = 0; i < numFuentes; ++i) {
+                    pfd[i].fd = fuentes[i].fd;
+                    pfd[i].events = POLLIN;
+                    pfd[i].revents = 0;
+                }
+                if (poll(pfd, (nfds_t)numFuentes, -1) < 0) break;
+            }
+            bool hubo = false;
+            for (int i = 0; i < numFuentes; ++i) {
+                Fuente& f = fuentes[i];
+                if (f.fd < 0 || (!busyPoll && !pfd[i].revents)) continue;
+                ssize_t r = read(f.fd, f.buf + f.usado, sizeof(f.buf) - 1 - f.usado);
+                if (r > 0) {
+                    f.usado += (size_t)r;
+                    drenar(f, lista, Trazador::global().estaActivo() ? Trazador::ciclos() : 0);
+                    hubo = true;
+                } else if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    f.fd = -1;
+                    abiertas--;
+                }
+            }
+            if (!hubo) {
+                sondeosVacios++;
+                if (busyPoll && ceder) sched_yield();
+            }
+        }
+    }
+
+    unsigned long long getLineas() const { return lineas; }
+    unsigned long long getSondeosVacios() const { return sondeosVacios; }
+    unsigned long long getDemasiadoLargas() const { return demasiadoLargas; }
+    const HistogramaLatencia& getLatencia() const { return latencia; }
+};
+
+/**
+ * @brief Emisor del banco: `n` líneas para los sensores `prefijo`T-i con su
+ *        marca relojNs(), una cada `periodoUs` microsegundos.
+ */
+static void emitirLineas(int fd, size_t n, unsigned periodoUs, size_t sensores, const char* prefijo) {
+    char linea[96];
+    for (size_t i = 0; i < n; ++i) {
+        int largo = std::snprintf(linea, sizeof(linea), "%sT-%zu,%.1f@%llu\n", prefijo, i % sensores,
+                                  20.0 + (double)(i % 50) * 0.1, relojNs());
+        if (!escribirCompleto(fd, linea, (size_t)largo)) break;
+        timespec ts = { 0, (long)periodoUs * 1000L };
+        nanosleep(&ts, NULL);
+    }
+}
+
+/**
+ * @brief --bench-ingesta N [cpu]: latencia de punta a punta (emisión ->
+ *        agregar() terminado) en modo bloqueante y en modo busy-poll.
+ */
+int ejecutarBancoIngesta(size_t n, int cpu) {
+    const size_t SENSORES = 16;
+    const unsigned PERIODO_US = 20;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpu < 0 || cpu >= cpus) cpu = 0;
+    int cpuEmisor = cpus > 1 ? (cpu + 1) % (int)cpus : cpu;
+    bool ceder = cpus <= 1;
+
+    registroDetallado() = false;
+    ListaGeneral lista;
+    printf("\n--- Ingesta: %zu lineas, una cada %u us, CPU de ingesta %d, emisor en CPU %d ---\n", n,
+           PERIODO_US, cpu, cpuEmisor);
+    if (ceder) printf("  Un solo CPU: el sondeo cede con sched_yield() para no frenar al emisor.\n");
+
+    for (int modo = 0; modo < 2; ++modo) {
+        bool busy = modo == 1;
+        // Cada corrida con sensores propios y vacíos: ninguna hereda los
+        // historiales (ni los nodos) de la otra.
+        const char* prefijo = busy ? "B-" : "A-";
+        for (size_t i = 0; i < SENSORES; ++i) {
+            char id[16];
+            std::snprintf(id, sizeof(id), "%sT-%zu", prefijo, i);
+            lista.push_back(new SensorTemperatura(id));
+        }
+        int par[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, par) != 0) return 1;
+        std::fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(par[0]);
+            IngestaBusyPoll::fijarCpu(cpuEmisor);
+            char listo;
+            if (read(par[1], &listo, 1) == 1) emitirLineas(par[1], n, PERIODO_US, SENSORES, prefijo);
+            _exit(0);
+        }
+        close(par[1]);
+        // Preparación después de fork(): así la copia en escritura no
+        // reaparece como fallos de página en la ruta caliente. Ambas
+        // corridas usan la misma arena precalentada; solo la CPU fija y
+        // mlockall distinguen al busy-poll.
+        ArenaNodos& a = ArenaNodos::global();
+        size_t listos = a.activar(ArenaNodos::MODO_THP)
+            ? a.precalentar(sizeof(ListaSensor<float>::Nodo), n + 1024) : 0;
+        if (busy) {
+            bool fija = IngestaBusyPoll::fijarCpu(cpu);
+            bool bloqueada = IngestaBusyPoll::bloquearMemoria();
+            printf("  Busy-poll: CPU fija %s, mlockall %s, %zu nodos precalentados en la arena\n",
+                   fija ? "si" : "no", bloqueada ? "si" : "no (sin permiso)", listos);
+        } else {
+            printf("  Bloqueante: %zu nodos precalentados en la arena\n", listos);
+        }
+        if (!escribirCompleto(par[0], "x", 1)) return 1;
+        IngestaBusyPoll ingesta;
+        ingesta.agregarFuente(par[0]);
+        size_t bloquesAntes = ArenaNodos::global().bloquesComprometidos();
+        rusage ru0, ru1;
+        getrusage(RUSAGE_SELF, &ru0);
+        ingesta.ejecutar(lista, busy, ceder);
+        getrusage(RUSAGE_SELF, &ru1);
+        close(par[0]);
+        waitpid(pid, NULL, 0);
+        printf("  %s: %llu lineas (%llu demasiado largas), %ld fallos de pagina, %zu bloques nuevos de arena, "
+               "%llu sondeos vacios\n", busy ? "Busy-poll " : "Bloqueante", ingesta.getLineas(),
+               ingesta.getDemasiadoLargas(), ru1.ru_minflt - ru0.ru_minflt,
+               ArenaNodos::global().bloquesComprometidos() - bloquesAntes, ingesta.getSondeosVacios());
+        ingesta.getLatencia().imprimirNs(busy ? "Busy-poll:" : "Bloqueante:");
+    }
+    munlockall();
+    return 0;
+}
+
+/**
+ * @brief --bench-mezcla sensores lecturas [tramos]: mezcla k-vías de
+ *        `sensores` historiales con marcas intercaladas; mide el recorrido
+ *        secuencial, verifica el orden y cronometra el volcado por tramos.
+ *        Al final vuelca un caso fuera de orden cuya última marca no es la
+ *        mayor, que debe emitir todas sus lecturas en un solo tramo.
+ */
+int ejecutarBancoMezcla(size_t sensores, size_t lecturas, size_t tramos) {
+    printf("\n--- Mezcla k-vias: %zu lecturas en %zu historiales, %zu tramo(s) ---\n", lecturas, sensores, tramos);
+    ListaSensor<float>* listas = new ListaSensor<float>[sensores];
+    unsigned long long x = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < lecturas; ++i) {
+        // Marcas crecientes por sensor con separación irregular.
+        x = mezclar64(x);
+        listas[i % sensores].push_back((float)(x & 1023), 0, (long long)i * 10 + (long long)(x % 7));
+    }
+    MezclaKVias::Fuente* f = new MezclaKVias::Fuente[sensores];
+    for (size_t s = 0; s < sensores; ++s) {
+        f[s].nodo = listas[s].primero();
+        f[s].ultima = listas[s].ultimo() ? listas[s].ultimo()->marcaMs : 0;
+        f[s].handle = (unsigned)s;
+        f[s].tipo = TIPO_TEMPERATURA;
+        f[s].marca = 0;
+    }
+
+    const size_t LOTE = 4096;
+    MezclaKVias::Lectura* lote = new MezclaKVias::Lectura[LOTE];
+    unsigned long long t0 = relojNs();
+    MezclaKVias m(f, sensores);
+    size_t c, desordenadas = 0;
+    long long previa = -MezclaKVias::FIN;
+    unsigned previoHandle = 0;
+    double suma = 0.0;
+    while ((c = m.siguienteLote(lote, LOTE)) > 0) {
+        for (size_t i = 0; i < c; ++i) {
+            if (lote[i].marcaMs < previa || (lote[i].marcaMs == previa && lote[i].handle < previoHandle))
+                desordenadas++;
+            previa = lote[i].marcaMs;
+            previoHandle = lote[i].handle;
+            suma += lote[i].valor;
+        }
+    }
+    double seg = (relojNs() - t0) / 1e9;
+    double gb = m.getEmitidas() * (double)sizeof(ListaSensor<float>::Nodo) / 1e9;
+    printf("  Secuencial: %llu lecturas en %.1f ms, %.1f M lecturas/s, %.2f GB/s de nodos leidos\n",
+           m.getEmitidas(), seg * 1e3, m.getEmitidas() / seg / 1e6, gb / seg);
+    printf("  Orden: %s (%zu fuera de orden), suma de control %.0f\n", desordenadas ? "ERROR" : "correcto",
+           desordenadas, suma);
+
+    char ruta[] = "/tmp/mezclaXXXXXX";
+    int fd = mkstemp(ruta);
+    if (fd >= 0) {
+        std::fflush(stdout);
+        t0 = relojNs();
+        long long total = MezclaKVias::volcarParticionado(f, sensores, tramos, fd, 0);
+        seg = (relojNs() - t0) / 1e9;
+        // Relectura: el archivo debe quedar ordenado a través de los tramos.
+        desordenadas = 0;
+        previa = -MezclaKVias::FIN;
+        previoHandle = 0;
+        off_t pos = 0;
+        ssize_t leido;
+        while ((leido = pread(fd, lote, LOTE * sizeof(MezclaKVias::Lectura), pos)) > 0) {
+            size_t cuantas = (size_t)leido / sizeof(MezclaKVias::Lectura);
+            for (size_t i = 0; i < cuantas; ++i) {
+                if (lote[i].marcaMs < previa || (lote[i].marcaMs == previa && lote[i].handle < previoHandle))
+                    desordenadas++;
+                previa = lote[i].marcaMs;
+                previoHandle = lote[i].handle;
+            }
+            pos += leido;
+        }
+        printf("  Por tramos (fork + pwrite): %lld lecturas en %.1f ms (%.1f MB/s escritos), orden %s\n", total,
+               seg * 1e3, total * (double)sizeof(MezclaKVias::Lectura) / seg / 1e6,
+               desordenadas || total != (long long)lecturas ? "ERROR" : "correcto");
+        close(fd);
+        unlink(ruta);
+    }
+
+    // Historial con la lectura más nueva retrasada: {100, 300, 200} y {150, 250}.
+    ListaSensor<float> atrasada, ordenada;
+    atrasada.push_back(1.0f, 0, 100);
+    atrasada.push_back(2.0f, 0, 300);
+    atrasada.push_back(3.0f, 0, 200);
+    ordenada.push_back(4.0f, 0, 150);
+    ordenada.push_back(5.0f, 0, 250);
+    MezclaKVias::Fuente g[2];
+    const ListaSensor<float>* dos[2] = { &atrasada, &ordenada };
+    for (size_t s = 0; s < 2; ++s) {
+        g[s].nodo = dos[s]->primero();
+        g[s].ultima = dos[s]->ultimo()->marcaMs;
+        g[s].handle = (unsigned)s;
+        g[s].tipo = TIPO_TEMPERATURA;
+        g[s].marca = 0;
+    }
+    char rutaAtrasada[] = "/tmp/mezclaXXXXXX";
+    fd = mkstemp(rutaAtrasada);
+    long long totalAtrasada = -1;
+    size_t desordenada = 2;
+    if (fd >= 0) {
+        std::fflush(stdout);
+        totalAtrasada = MezclaKVias::volcarParticionado(g, 2, tramos > 1 ? tramos : 2, fd, 0, &desordenada);
+        close(fd);
+        unlink(rutaAtrasada);
+    }
+    bool atrasadaOk = totalAtrasada == 5 && desordenada == 0;
+    printf("  Marca final retrasada: %lld de 5 lecturas, historial fuera de orden %zu: %s\n", totalAtrasada,
+           desordenada, atrasadaOk ? "correcto" : "ERROR");
+    delete[] lote;
+    delete[] f;
+    delete[] listas;
+    return desordenadas || !atrasadaOk ? 1 : 0;
+}
+
+/**
+ * @brief Banco de --bench-arena: inserta `total` lecturas repartidas en
+ *        `sensores` listas (intercaladas, como en la ingesta real) y recorre
+ *        todas con sum(), primero con nodos del heap y luego en la arena.
+ */
+int ejecutarBancoArena(size_t total, size_t sensores, ArenaNodos::Modo modo) {
+    ContadorTlb tlb;
+    const int VUELTAS = 3;
+    printf("\n--- Arena vs heap: %zu lecturas en %zu sensores ---\n", total, sensores);
+    printf("  %-8s %14s %14s %18s\n", "Nodos", "push (M/s)", "sum (M/s)", "fallos DTLB/1000");
+    for (int fase = 0; fase < 2; ++fase) {
+        if (fase == 1 && !ArenaNodos::global().activar(modo)) {
+            printf("  No se pudo reservar la arena.\n");
+            break;
+        }
+        ListaSensor<float>* listas = new ListaSensor<float>[sensores];
+        unsigned long long t0 = relojNs();
+        for (size_t i = 0; i < total; ++i) listas[i % sensores].push_back((float)(i & 1023));
+        double segPush = (relojNs() - t0) / 1e9;
+
+        volatile float acumulado = 0.0f;
+        tlb.iniciar();
+        t0 = relojNs();
+        for (int v = 0; v < VUELTAS; ++v) {
+            for (size_t s = 0; s < sensores; ++s) acumulado = acumulado + listas[s].sum();
+        }
+        double segSum = (relojNs() - t0) / 1e9;
+        long long fallos = tlb.detener();
+
+        char tlbTexto[32];
+        if (fallos >= 0) std::snprintf(tlbTexto, sizeof(tlbTexto), "%.2f", 1000.0 * fallos / ((double)total * VUELTAS));
+        else std::snprintf(tlbTexto, sizeof(tlbTexto), "no disponible");
+        printf("  %-8s %14.1f %14.1f %18s\n", fase ? "arena" : "heap", total / segPush / 1e6,
+               total * VUELTAS / segSum / 1e6, tlbTexto);
+        delete[] listas;
+    }
+    ArenaNodos::global().imprimirReporte();
+    return 0;
+}
+
+/**
+ * @brief --bench-filtros sensores [lecturas]: lecturas filtradas por segundo
+ *        con la ruta por lectura del banco (la de la ingesta) frente a
+ *        aplicarLote() sobre sensores intercalados, y de la ingesta completa
+ *        con suavizado EWMA.
+ */
+int ejecutarBancoFiltros(size_t sensores, size_t lecturas) {
+    unsigned* ranuras = new unsigned[lecturas];
+    double* x = new double[lecturas];
+    float* escalar = new float[lecturas];
+    float* lote = new float[lecturas];
+    BancoFiltros a, b;
+    for (size_t s = 0; s < sensores; ++s) {
+        // Tipo al azar por sensor: el orden de llegada no permite predecir el salto.
+        FiltroSuavizado f = mezclar64(s) & 1 ? FiltroSuavizado::crearKalman(1e-3, 0.1) : FiltroSuavizado::crearEWMA(0.2);
+        a.alta(f, NULL);
+        b.alta(f, NULL);
+    }
+    unsigned long long semilla = 0x5DEECE66DULL;
+    for (size_t i = 0; i < lecturas; ++i) {
+        semilla = mezclar64(semilla);
+        ranuras[i] = (unsigned)(i % sensores); // llegada intercalada, como en la ingesta
+        x[i] = 22.0 + (double)(semilla & 0xFFFF) / 65535.0 - 0.5;
+    }
+
+    printf("\n--- Banco de filtros: %zu lecturas de %zu sensores (EWMA y Kalman al azar) ---\n", lecturas,
+           sensores);
+    const int VUELTAS = 3; // se informa la mejor de tres
+    double segEscalar = 0, segLote = 0;
+    for (int v = 0; v < VUELTAS; ++v) {
+        unsigned long long t0 = relojNs();
+        for (size_t i = 0; i < lecturas; ++i) escalar[i] = (float)a.aplicar(ranuras[i], x[i]);
+        double t = (relojNs() - t0) / 1e9;
+        if (v == 0 || t < segEscalar) segEscalar = t;
+        t0 = relojNs();
+        for (size_t i = 0; i < lecturas; i += BancoFiltros::LOTE) {
+            size_t m = lecturas - i < BancoFiltros::LOTE ? lecturas - i : BancoFiltros::LOTE;
+            b.aplicarLote(ranuras + i, x + i, lote + i, m);
+        }
+        t = (relojNs() - t0) / 1e9;
+        if (v == 0 || t < segLote) segLote = t;
+    }
+    double peor = 0.0;
+    for (size_t i = 0; i < lecturas; ++i) {
+        double d = (double)escalar[i] - (double)lote[i];
+        if (d < 0) d = -d;
+        if (d > peor) peor = d;
+    }
+    printf("  Por lectura:        %8.1f M lecturas/s (ruta de la ingesta)\n", lecturas / segEscalar / 1e6);
+    printf("  aplicarLote():      %8.1f M lecturas/s (diferencia maxima %.2g)\n", lecturas / segLote / 1e6, peor);
+
+    // Ingesta completa: agregar() con calidad, historial y serie suavizada.
+    registroDetallado() = false;
+    size_t n = sensores < 1000 ? sensores : 1000;
+    size_t total = lecturas < 2000000 ? lecturas : 2000000;
+    SensorTemperatura** ts = new SensorTemperatura*[n];
+    for (size_t s = 0; s < n; ++s) {
+        char id[16];
+        std::snprintf(id, sizeof(id), "T-%zu", s);
+        ts[s] = new SensorTemperatura(id);
+        ts[s]->configurarFiltro(FiltroSuavizado::crearEWMA(0.2));
+    }
+    unsigned long long t0 = relojNs();
+    for (size_t i = 0; i < total; ++i) ts[i % n]->agregar((float)x[i]);
+    double segIngesta = (relojNs() - t0) / 1e9;
+    printf("  Ingesta completa:   %8.1f M lecturas/s (%zu sensores, agregar() + suavizado)\n",
+           total / segIngesta / 1e6, n);
+    std::fflush(stdout);
+    if (!std::freopen("/dev/null", "w", stdout)) return 1; // silencia los destructores de sensores
+    for (size_t s = 0; s < n; ++s) delete ts[s];
+    delete[] ts;
+    delete[] ranuras;
+    delete[] x;
+    delete[] escalar;
+    delete[] lote;
+    return peor < 1e-3 ? 0 : 1;
+}
+
+/**
+ * @brief Banco de --bench-compresion: una temperatura estable (deriva lenta
+ *        más ruido de ±0.02, una lectura cada 100 ms) guardada completa, con
+ *        banda muerta y con puerta giratoria. Reporta quiebres, memoria,
+ *        error máximo de la reconstrucción y el costo del promedio.
+ */
+int ejecutarBancoCompresion(size_t total, double error) {
+    long long* marcas = new long long[total];
+    float* valores = new float[total];
+    unsigned semilla = 12345u;
+    double deriva = 22.0;
+    for (size_t i = 0; i < total; ++i) {
+        semilla = semilla * 1103515245u + 12345u;
+        double u = (double)((semilla >> 8) & 0xFFFF) / 65535.0 - 0.5;
+        if (i % 600 == 0) deriva += 0.3 * u;  // cambio lento cada minuto
+        marcas[i] = 1700000000000LL + (long long)i * 100;
+        valores[i] = (float)(deriva + 0.04 * u);
+    }
+
+    printf("\n--- Compresion del historial: %zu lecturas, E=%g ---\n", total, error);
+    printf("  %-18s %10s %8s %12s %12s %12s\n", "Modo", "quiebres", "razon", "bytes", "error max", "prom (us)");
+    for (int modo = 0; modo < 3; ++modo) {
+        CompresorHistorial c;
+        if (modo == 1) c = CompresorHistorial::crearBandaMuerta(error);
+        if (modo == 2) c = CompresorHistorial::crearPuertaGiratoria(error);
+        ListaSensor<float> h;
+        for (size_t i = 0; i < total; ++i) {
+            long long m = marcas[i];
+            if (modo == 0) { h.push_back(valores[i], 0, m); continue; }
+            CompresorHistorial::PuntoQuiebre q[2];
+            int n = c.agregar(valores[i], 0, m, q);
+            for (int k = 0; k < n; ++k) h.push_back((float)q[k].valor, q[k].banderas, q[k].marcaMs);
+        }
+
+        // Error de la reconstrucción en cada lectura cruda.
+        double peor = 0.0;
+        CompresorHistorial::PuntoQuiebre fin;
+        bool hayFin = modo != 0 && c.puntoPendiente(fin);
+        const ListaSensor<float>::Nodo* a = h.primero();
+        for (size_t i = 0; modo != 0 && i < total; ++i) {
+            while (a->siguiente && a->siguiente->marcaMs <= marcas[i]) a = a->siguiente;
+            long long tb = a->siguiente ? a->siguiente->marcaMs : (hayFin ? fin.marcaMs : a->marcaMs);
+            double vb = a->siguiente ? a->siguiente->dato : (hayFin ? fin.valor : a->dato);
+            double r = tb > a->marcaMs
+                ? a->dato + (vb - a->dato) * (double)(marcas[i] - a->marcaMs) / (double)(tb - a->marcaMs)
+                : a->dato;
+            double d = r - valores[i];
+            if (d < 0) d = -d;
+            if (d > peor) peor = d;
+        }
+
+        volatile double promedio = 0.0;
+        unsigned long long t0 = relojNs();
+        if (modo == 0) {
+            promedio = h.sum() / (double)total;
+        } else {
+            double p = 0.0;
+            c.promedioReconstruido(h, p);
+            promedio = p;
+        }
+        double us = (relojNs() - t0) / 1e3;
+        static const char* nombres[3] = { "Completo", "Banda muerta", "Puerta giratoria" };
+        printf("  %-18s %10zu %7.1fx %12zu %12.4f %12.1f  (promedio %.4f)\n", nombres[modo], h.size(),
+               (double)total / (double)h.size(), h.bytes(), peor, us, (double)promedio);
+    }
+    delete[] marcas;
+    delete[] valores;
+    return 0;
+}
+
+/**
+ * @brief Banco de --bench-cuantizado: suma un historial de temperatura
+ *        (±0.1 °C de resolución) guardado en nodos float y en el archivo
+ *        cuantizado de cada modo; reporta bytes, ritmo de suma y error.
+ */
+int ejecutarBancoCuantizado(size_t total) {
+    const int VUELTAS = 5;
+    float* valores = new float[total];
+    unsigned char* banderas = new unsigned char[total];
+    long long* marcas = new long long[total];
+    unsigned semilla = 777u;
+    double t = 21.0;
+    for (size_t i = 0; i < total; ++i) {
+        semilla = semilla * 1103515245u + 12345u;
+        t += 0.01 * ((double)((semilla >> 8) & 0xFF) / 255.0 - 0.5);
+        valores[i] = (float)((long long)(t * 10.0 + 0.5) / 10.0); // resolución del sensor
+        banderas[i] = 0;
+        marcas[i] = 1700000000000LL + (long long)i * 1000;
+    }
+    printf("\n--- Historial cuantizado: %zu lecturas%s ---\n", total,
+#if defined(__x86_64__) || defined(__i386__)
+           hayF16c() ? " (F16C)" : " (sin F16C)"
+#else
+           ""
+#endif
+           );
+    printf("  %-18s %14s %10s %14s %14s\n", "Almacenamiento", "bytes", "B/lectura", "suma (M/s)", "promedio");
+
+    ListaSensor<float> lista;
+    for (size_t i = 0; i < total; ++i) lista.push_back(valores[i], banderas[i], marcas[i]);
+    volatile double s = 0.0;
+    unsigned long long t0 = relojNs();
+    for (int v = 0; v < VUELTAS; ++v) s = s + lista.sum();
+    double seg = (relojNs() - t0) / 1e9;
+    printf("  %-18s %14zu %10.1f %14.1f %14.4f\n", "nodos float", lista.bytes(),
+           (double)lista.bytes() / (double)total, total * VUELTAS / seg / 1e6, (double)lista.sum() / (double)total);
+    lista.clear();
+
+    for (int modo = ArchivoCuantizado::F16; modo <= ArchivoCuantizado::Q8; ++modo) {
+        ArchivoCuantizado a((ArchivoCuantizado::Modo)modo);
+        for (size_t i = 0; i < total; i += ArchivoCuantizado::BLOQUE) {
+            size_t k = total - i < ArchivoCuantizado::BLOQUE ? total - i : ArchivoCuantizado::BLOQUE;
+            a.archivar(valores + i, banderas + i, marcas + i, k);
+        }
+        s = 0.0;
+        t0 = relojNs();
+        for (int v = 0; v < VUELTAS; ++v) s = s + a.suma();
+        seg = (relojNs() - t0) / 1e9;
+        printf("  %-18s %14zu %10.1f %14.1f %14.4f\n", a.nombreModo(), a.bytes(),
+               (double)a.bytes() / (double)total, total * VUELTAS / seg / 1e6, a.suma() / (double)total);
+        a.imprimir();
+    }
+    delete[] valores;
+    delete[] banderas;
+    delete[] marcas;
+    return 0;
+}
+
+/**
+ * @brief Banco de --bench-topk: `sensores` handles reciben `lecturas`
+ *        valores al azar; compara el costo por lectura del ranking y el de
+ *        una consulta contra recorrer todas las métricas.
+ */
+int ejecutarBancoTopK(size_t sensores, size_t lecturas, size_t k) {
+    IndiceRanking idx;
+    for (size_t h = 0; h < sensores; ++h) idx.registrar(NULL, (unsigned)h, TIPO_TEMPERATURA);
+    idx.crear(RankingSensores::ULTIMO, 0, k);
+    idx.crear(RankingSensores::MAXIMO, 0, k);
+    double* ultimo = new double[sensores];
+    bool* leido = new bool[sensores]();
+    unsigned semilla = 99u;
+    printf("\n--- Top-%zu incremental: %zu sensores, %zu lecturas, 2 rankings ---\n", k, sensores, lecturas);
+    unsigned long long t0 = relojNs();
+    for (size_t i = 0; i < lecturas; ++i) {
+        semilla = semilla * 1103515245u + 12345u;
+        unsigned h = (unsigned)((semilla >> 4) % sensores);
+        double v = 15.0 + (double)((semilla >> 12) & 0x3FF) / 32.0;
+        ultimo[h] = v;
+        leido[h] = true;
+        idx.lectura(h, v);
+    }
+    double ns = (double)(relojNs() - t0) / (double)lecturas;
+    printf("  Actualizacion: %.1f ns por lectura\n", ns);
+
+    unsigned* hs = new unsigned[k];
+    double* vs = new double[k];
+    t0 = relojNs();
+    size_t m = idx.ranking(0).copiaOrdenada(hs, vs);
+    double usConsulta = (relojNs() - t0) / 1e3;
+
+    // Referencia: recorrer todos los sensores manteniendo los K mayores.
+    double* mejores = new double[k];
+    size_t llenos = 0;
+    t0 = relojNs();
+    for (size_t h = 0; h < sensores; ++h) {
+        if (!leido[h]) continue;
+        double v = ultimo[h];
+        if (llenos == k && v <= mejores[k - 1]) continue;
+        size_t j = llenos < k ? llenos++ : k - 1;
+        while (j > 0 && mejores[j - 1] < v) { mejores[j] = mejores[j - 1]; j--; }
+        mejores[j] = v;
+    }
+    double usRecorrido = (relojNs() - t0) / 1e3;
+    bool coincide = m == llenos;
+    for (size_t j = 0; coincide && j < m; ++j) coincide = vs[j] == mejores[j];
+    printf("  Consulta top-%zu: %.2f us | recorrido completo: %.1f us | resultados %s\n", k, usConsulta,
+           usRecorrido, coincide ? "iguales" : "DISTINTOS");
+    delete[] ultimo;
+    delete[] leido;
+    delete[] hs;
+    delete[] vs;
+    delete[] mejores;
+    return coincide ? 0 : 1;
+}
+
+/**
+ * @brief Banco de --bench-bocetos: error de distintos() de 10 a `maximo`
+ *        valores (cada uno repetido 3 veces), la unión de dos grupos que se
+ *        solapan, una frecuencia consultada con el literal decimal y el
+ *        costo de agregar().
+ * @return 0 si el error relativo queda en ±5% y count-min no subestima.
+ */
+int ejecutarBancoBocetos(size_t maximo) {
+    BocetoSensor* b = new BocetoSensor(); // 6 KB: fuera de la pila
+    bool ok = true;
+    printf("\n--- Bocetos: HLL de %zu registros, count-min %zux%zu ---\n", BocetoSensor::REGISTROS,
+           BocetoSensor::FILAS, BocetoSensor::ANCHO);
+    printf("  %12s %14s %10s\n", "distintos", "estimado", "error");
+    for (size_t n = 10; n <= maximo; n *= 10) {
+        b->clear();
+        for (size_t i = 0; i < n; ++i) {
+            for (int r = 0; r < 3; ++r) b->agregar((double)(float)((double)i / 8.0));
+        }
+        double e = b->distintos();
+        double rel = (e - (double)n) / (double)n;
+        if (rel > 0.05 || rel < -0.05) ok = false;
+        printf("  %12zu %14.0f %9.2f%%\n", n, e, 100.0 * rel);
+    }
+
+    // Dos grupos: [0, 700) y [350, 1050) -> 1050 distintos.
+    BocetoSensor* otro = new BocetoSensor();
+    b->clear();
+    for (int i = 0; i < 700; ++i) b->agregar((double)i);
+    for (int i = 350; i < 1050; ++i) otro->agregar((double)i);
+    b->combinar(*otro);
+    printf("  Union de grupos solapados: ~%.0f de 1050\n", b->distintos());
+
+    // La ingesta ve el float; la consulta, el literal decimal.
+    b->clear();
+    for (int i = 0; i < 1000; ++i) b->agregar((double)(i % 4 == 0 ? 22.1f : 18.0f + (float)(i % 97) * 0.01f));
+    unsigned long long f = b->frecuencia(22.1);
+    if (f < 250) ok = false;
+    printf("  Frecuencia de 22.1 (250 reales): a lo sumo %llu (exceso <= %.0f)\n", f, b->errorFrecuencia());
+
+    const size_t VUELTAS = 10000000;
+    unsigned long long t0 = relojNs();
+    for (size_t i = 0; i < VUELTAS; ++i) b->agregar(20.0 + (double)(i & 1023) * 0.01);
+    printf("  agregar(): %.1f ns por lectura\n", (double)(relojNs() - t0) / (double)VUELTAS);
+    delete b;
+    delete otro;
+    printf("  Resultado: %s\n", ok ? "OK" : "FUERA DE TOLERANCIA");
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Visitante de la autoverificación: guarda los pares recibidos.
+ */
+struct ParesAlineados {
+    size_t n, capacidad;
+    long long* marcas;
+    double* derecha;
+
+    explicit ParesAlineados(size_t cap) : n(0), capacidad(cap), marcas(new long long[cap]), derecha(new double[cap]) {}
+    ~ParesAlineados() {
+        delete[] marcas;
+        delete[] derecha;
+    }
+    void operator()(long long m, double, double b) {
+        if (n < capacidad) {
+            marcas[n] = m;
+            derecha[n] = b;
+        }
+        n++;
+    }
+
+private:
+    ParesAlineados(const ParesAlineados&);
+    ParesAlineados& operator=(const ParesAlineados&);
+};
+
+/**
+ * @brief Referencia por fuerza bruta de unirPorTiempo(): para cada lectura
+ *        de `izq` recorre `der` completo.
+ */
+static size_t unirFuerzaBruta(const ListaSensor<float>& izq, const ListaSensor<float>& der, bool cercano,
+                              long long tol, ParesAlineados& out) {
+    for (const ListaSensor<float>::Nodo* i = izq.primero(); i; i = i->siguiente) {
+        const ListaSensor<float>::Nodo* previo = NULL;
+        const ListaSensor<float>::Nodo* siguiente = NULL;
+        for (const ListaSensor<float>::Nodo* d = der.primero(); d; d = d->siguiente) {
+            if (d->marcaMs <= i->marcaMs) previo = d;           // última con marca <=
+            else if (!siguiente) siguiente = d;                 // primera con marca >
+        }
+        const ListaSensor<float>::Nodo* e = previo;
+        if (cercano && siguiente && (!previo || siguiente->marcaMs - i->marcaMs < i->marcaMs - previo->marcaMs))
+            e = siguiente;
+        if (!e) continue;
+        long long dist = e->marcaMs > i->marcaMs ? e->marcaMs - i->marcaMs : i->marcaMs - e->marcaMs;
+        if (tol >= 0 && dist > tol) continue;
+        out(i->marcaMs, (double)i->dato, (double)e->dato);
+    }
+    return out.n;
+}
+
+/// Referencia de remuestrear() en un punto: interpolación entre vecinos.
+static double interpolarFuerzaBruta(const ListaSensor<float>& h, long long t) {
+    const ListaSensor<float>::Nodo* a = h.primero();
+    if (t < a->marcaMs) return (double)a->dato;
+    while (a->siguiente && a->siguiente->marcaMs <= t) a = a->siguiente;
+    if (!a->siguiente) return (double)a->dato;
+    const ListaSensor<float>::Nodo* b = a->siguiente;
+    return (double)a->dato + ((double)b->dato - (double)a->dato) * (double)(t - a->marcaMs) /
+           (double)(b->marcaMs - a->marcaMs);
+}
+
+static bool casiIgual(double a, double b) {
+    double d = a - b, m = (a < 0 ? -a : a) + (b < 0 ? -b : b);
+    return (d < 0 ? -d : d) <= 1e-9 * (m > 1.0 ? m : 1.0);
+}
+
+/**
+ * @brief Compara unirPorTiempo() con la referencia y reporta si difieren.
+ */
+static bool verificarUnion(const char* caso, const ListaSensor<float>& izq, const ListaSensor<float>& der,
+                           bool cercano, long long tol) {
+    ParesAlineados rapido(izq.size() + 1), lento(izq.size() + 1);
+    size_t n = unirPorTiempo(izq, der, cercano, tol, rapido);
+    unirFuerzaBruta(izq, der, cercano, tol, lento);
+    bool ok = n == rapido.n && rapido.n == lento.n;
+    for (size_t i = 0; ok && i < rapido.n; ++i)
+        ok = rapido.marcas[i] == lento.marcas[i] && rapido.derecha[i] == lento.derecha[i];
+    if (!ok) printf("  FALLA %s (%s, tol %lld): %zu pares, referencia %zu\n", caso, cercano ? "cercana" : "as-of",
+                    tol, rapido.n, lento.n);
+    return ok;
+}
+
+/**
+ * @brief Compara remuestrear() con la referencia en la grilla dada.
+ */
+static bool verificarGrilla(const char* caso, const ListaSensor<float>& h, long long inicio, long long paso,
+                            size_t n) {
+    double* out = new double[n ? n : 1];
+    size_t dentro = remuestrear(h, inicio, paso, n, out);
+    bool ok = true;
+    size_t esperados = 0;
+    long long primera = 0, ultima = 0;
+    bool hay = rangoMarcas(h, primera, ultima);
+    for (size_t k = 0; hay && paso > 0 && k < n; ++k) {
+        long long t = inicio + (long long)k * paso;
+        if (t >= primera && t <= ultima) esperados++;
+        if (!casiIgual(out[k], interpolarFuerzaBruta(h, t))) ok = false;
+    }
+    if (dentro != esperados) ok = false;
+    if (!ok) printf("  FALLA grilla %s: %zu puntos dentro, esperados %zu\n", caso, dentro, esperados);
+    delete[] out;
+    return ok;
+}
+
+/**
+ * @brief --bench-alineacion [lecturas]: autoverificación de los bordes del
+ *        join as-of / más cercano (antes del primero, empates exactos,
+ *        marcas repetidas, equidistancia, tolerancia 0 y sin límite) y del
+ *        remuestreo (grilla antes, después y sobre las marcas, un solo
+ *        punto, paso que no divide), más una comparación al azar contra
+ *        fuerza bruta y el costo de ambos con `lecturas` por lado.
+ * @return 0 si todas las verificaciones coinciden con la referencia.
+ */
+int ejecutarBancoAlineacion(size_t lecturas) {
+    printf("\n--- Alineacion temporal: autoverificacion de bordes ---\n");
+    size_t casos = 0, fallas = 0;
+    ListaSensor<float> izq, der, uno;
+    // Izquierda: 5, 10, 15, 20, 25, 40. Derecha: 10, 10 (repetida), 18, 22, 30.
+    long long mi[] = { 5, 10, 15, 20, 25, 40 };
+    long long md[] = { 10, 10, 18, 22, 30 };
+    for (size_t i = 0; i < sizeof(mi) / sizeof(mi[0]); ++i) izq.push_back((float)i, 0, mi[i]);
+    for (size_t i = 0; i < sizeof(md) / sizeof(md[0]); ++i) der.push_back(100.0f + (float)i, 0, md[i]);
+    uno.push_back(7.0f, 0, 50);
+
+    long long tolerancias[] = { -1, 0, 2, 3, 100 };
+    for (int cercano = 0; cercano < 2; ++cercano) {
+        for (size_t t = 0; t < sizeof(tolerancias) / sizeof(tolerancias[0]); ++t) {
+            casos += 3;
+            if (!verificarUnion("fija", izq, der, cercano != 0, tolerancias[t])) fallas++;
+            if (!verificarUnion("derecha de un punto", izq, uno, cercano != 0, tolerancias[t])) fallas++;
+            if (!verificarUnion("derecha vacia", izq, ListaSensor<float>(), cercano != 0, tolerancias[t])) fallas++;
+        }
+    }
+    // Bordes puntuales con resultado conocido.
+    ParesAlineados p(8);
+    unirPorTiempo(izq, der, false, -1, p);  // 5 no tiene previa; 10 toma la última de las repetidas
+    casos++;
+    if (!(p.n == 5 && p.marcas[0] == 10 && p.derecha[0] == 101.0)) {
+        printf("  FALLA as-of: antes del primero / marca repetida\n");
+        fallas++;
+    }
+    ParesAlineados q(8);
+    unirPorTiempo(izq, der, true, -1, q);   // 20 está a 2 de 18 y de 22: gana la previa
+    casos++;
+    if (!(q.n == 6 && q.derecha[0] == 100.0 && q.derecha[3] == 102.0)) {
+        printf("  FALLA cercana: equidistancia o primer punto\n");
+        fallas++;
+    }
+    ParesAlineados r(8);
+    unirPorTiempo(izq, der, false, 0, r);   // tolerancia 0: solo el empate exacto
+    casos++;
+    if (!(r.n == 1 && r.marcas[0] == 10)) {
+        printf("  FALLA as-of con tolerancia 0\n");
+        fallas++;
+    }
+
+    struct { const char* caso; const ListaSensor<float>* h; long long inicio, paso; size_t n; } grillas[] = {
+        { "antes del primero", &der, -20, 3, 5 },   { "despues del ultimo", &der, 31, 4, 6 },
+        { "sobre las marcas", &der, 10, 4, 6 },     { "paso que no divide", &izq, 4, 7, 7 },
+        { "un solo punto", &uno, 40, 5, 5 },        { "cubre todo", &izq, 0, 1, 50 },
+        { "sin puntos", &izq, 0, 1, 0 },            { "paso invalido", &izq, 0, 0, 4 },
+    };
+    for (size_t g = 0; g < sizeof(grillas) / sizeof(grillas[0]); ++g) {
+        casos++;
+        if (!verificarGrilla(grillas[g].caso, *grillas[g].h, grillas[g].inicio, grillas[g].paso, grillas[g].n))
+            fallas++;
+    }
+
+    // Al azar: marcas crecientes con saltos 0..9 ms (empates incluidos).
+    unsigned semilla = 4242u;
+    for (int ronda = 0; ronda < 20; ++ronda) {
+        ListaSensor<float> a, b;
+        long long ta = 0, tb = 0;
+        for (int i = 0; i < 200; ++i) {
+            semilla = semilla * 1103515245u + 12345u;
+            ta += (semilla >> 16) % 10;
+            a.push_back((float)(semilla & 255), 0, ta);
+            semilla = semilla * 1103515245u + 12345u;
+            tb += (semilla >> 16) % 10;
+            b.push_back((float)(semilla & 255), 0, tb);
+        }
+        long long tol = ronda % 3 == 0 ? -1 : ronda % 5;
+        casos += 3;
+        if (!verificarUnion("al azar", a, b, false, tol)) fallas++;
+        if (!verificarUnion("al azar", a, b, true, tol)) fallas++;
+        if (!verificarGrilla("al azar", a, -5 + ronda, 1 + ronda % 7, 400)) fallas++;
+    }
+    printf("  %zu casos, %zu fallas\n", casos, fallas);
+
+    // Costo con historiales grandes intercalados.
+    ListaSensor<float> ga, gb;
+    for (size_t i = 0; i < lecturas; ++i) {
+        ga.push_back((float)(i % 97), 0, (long long)i * 10);
+        gb.push_back((float)(i % 89), 0, (long long)i * 10 + 3);
+    }
+    CorrelacionAlineada c;
+    unsigned long long t0 = relojNs();
+    size_t pares = unirPorTiempo(ga, gb, true, 5, c);
+    double msUnion = (relojNs() - t0) / 1e6;
+    double* grilla = new double[lecturas];
+    t0 = relojNs();
+    remuestrear(ga, 0, 10, lecturas, grilla);
+    double msGrilla = (relojNs() - t0) / 1e6;
+    printf("  Join cercano de %zu x %zu: %zu pares en %.2f ms | remuestreo de %zu puntos: %.2f ms\n", lecturas,
+           lecturas, pares, msUnion, lecturas, msGrilla);
+    delete[] grilla;
+    printf("  Resultado: %s\n", fallas ? "FALLAS" : "OK");
+    return fallas ? 1 : 0;
+}
+
+/* ============================================================
+ *     Backends de referencia para bancos (no se usan en sensores)
+ * ============================================================*/
+
+/// Lectura almacenada por los backends de referencia (mismo contenido que un Nodo).
+template <typename T>
+struct RegistroLectura {
+    T dato;
+    unsigned char banderas;
+    long long marcaMs;
+};
+
+/**
+ * @brief Backend de referencia: arreglo contiguo que duplica su capacidad.
+ *        Misma interfaz que ListaSensor en las operaciones del banco.
+ */
+template <typename T>
+class ListaContigua {
+    RegistroLectura<T>* datos;
+    size_t cap;
+    size_t n;
+
+    void copiarDesde(const ListaContigua& otra) {
+        for (size_t i = 0; i < otra.n; ++i) push_back(otra.datos[i].dato, otra.datos[i].banderas, otra.datos[i].marcaMs);
+    }
+
+public:
+    ListaContigua() : datos(NULL), cap(0), n(0) {}
+    ListaContigua(const ListaContigua& otra) : datos(NULL), cap(0), n(0) { copiarDesde(otra); }
+    ListaContigua& operator=(const ListaContigua& otra) {
+        if (this != &otra) {
+            clear();
+            copiarDesde(otra);
+        }
+        return *this;
+    }
+    ~ListaContigua() { clear(); }
+
+    void push_back(const T& v, unsigned char banderas = 0, long long marcaMs = 0) {
+        if (n == cap) {
+            size_t nueva = cap ? cap * 2 : 16;
+            RegistroLectura<T>* mayor = new RegistroLectura<T>[nueva];
+            if (n) std::memcpy(mayor, datos, n * sizeof(RegistroLectura<T>));
+            delete[] datos;
+            datos = mayor;
+            cap = nueva;
+        }
+        RegistroLectura<T>& r = datos[n++];
+        r.dato = v;
+        r.banderas = banderas;
+        r.marcaMs = marcaMs;
+    }
+
+    size_t size() const { return n; }
+
+    T sum() const {
+        T s = T(0);
+        for (size_t i = 0; i < n; ++i) s += datos[i].dato;
+        return s;
+    }
+
+    /// Quita el mínimo conservando el orden de llegada (corre la cola).
+    bool pop_min(T& outMin) {
+        if (!n) return false;
+        size_t m = 0;
+        for (size_t i = 1; i < n; ++i) {
+            if (datos[i].dato < datos[m].dato) m = i;
+        }
+        outMin = datos[m].dato;
+        std::memmove(datos + m, datos + m + 1, (n - m - 1) * sizeof(RegistroLectura<T>));
+        n--;
+        return true;
+    }
+
+    bool find_first(const T& value, T& found) const {
+        for (size_t i = 0; i < n; ++i) {
+            if (datos[i].dato == value) {
+                found = datos[i].dato;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void clear() {
+        delete[] datos;
+        datos = NULL;
+        cap = n = 0;
+    }
+
+    size_t bytes() const { return cap * sizeof(RegistroLectura<T>); }
+};
+
+/**
+ * @brief Backend de referencia al estilo std::deque: bloques fijos de
+ *        BLOQUE lecturas indexados por un mapa de punteros. Borrar en el
+ *        medio corre el lado más corto.
+ */
+template <typename T>
+class ListaDeque {
+public:
+    static const size_t BLOQUE = 512; ///< Potencia de dos
+
+private:
+    RegistroLectura<T>** mapa;
+    size_t capMapa;
+    size_t bloques;  ///< Bloques reservados (al frente del mapa)
+    size_t inicio;   ///< Desplazamiento del primer elemento en mapa[0]
+    size_t n;
+
+    RegistroLectura<T>& en(size_t i) const {
+        size_t g = inicio + i;
+        return mapa[g / BLOQUE][g & (BLOQUE - 1)];
+    }
+
+    void copiarDesde(const ListaDeque& otra) {
+        for (size_t i = 0; i < otra.n; ++i) {
+            const RegistroLectura<T>& r = otra.en(i);
+            push_back(r.dato, r.banderas, r.marcaMs);
+        }
+    }
+
+public:
+    ListaDeque() : mapa(NULL), capMapa(0), bloques(0), inicio(0), n(0) {}
+    ListaDeque(const ListaDeque& otra) : mapa(NULL), capMapa(0), bloques(0), inicio(0), n(0) { copiarDesde(otra); }
+    ListaDeque& operator=(const ListaDeque& otra) {
+        if (this != &otra) {
+            clear();
+            copiarDesde(otra);
+        }
+        return *this;
+    }
+    ~ListaDeque() { clear(); }
+
+    void push_back(const T& v, unsigned char banderas = 0, long long marcaMs = 0) {
+        size_t g = inicio + n;
+        if (g / BLOQUE >= bloques) {
+            if (bloques == capMapa) {
+                size_t nueva = capMapa ? capMapa * 2 : 8;
+                RegistroLectura<T>** mayor = new RegistroLectura<T>*[nueva];
+                if (bloques) std::memcpy(mayor, mapa, bloques * sizeof(RegistroLectura<T>*));
+                delete[] mapa;
+                mapa = mayor;
+                capMapa = nueva;
+            }
+            mapa[bloques++] = new RegistroLectura<T>[BLOQUE];
+        }
+        RegistroLectura<T>& r = mapa[g / BLOQUE][g & (BLOQUE - 1)];
+        r.dato = v;
+        r.banderas = banderas;
+        r.marcaMs = marcaMs;
+        n++;
+    }
+
+    size_t size() const { return n; }
+
+    T sum() const {
+        T s = T(0);
+        size_t g = inicio, fin = inicio + n;
+        while (g < fin) {
+            const RegistroLectura<T>* b = mapa[g / BLOQUE];
+            size_t hasta = (g / BLOQUE + 1) * BLOQUE;
+            if (hasta > fin) hasta = fin;
+            for (size_t j = g & (BLOQUE - 1), k = hasta - g; k; ++j, --k) s += b[j].dato;
+            g = hasta;
+        }
+        return s;
+    }
+
+    bool pop_min(T& outMin) {
+        if (!n) return false;
+        size_t m = 0;
+        T menor = en(0).dato;
+        for (size_t i = 1; i < n; ++i) {
+            if (en(i).dato < menor) {
+                menor = en(i).dato;
+                m = i;
+            }
+        }
+        outMin = menor;
+        if (m < n / 2) {
+            for (size_t i = m; i > 0; --i) en(i) = en(i - 1);
+            if (++inicio == BLOQUE) {
+                delete[] mapa[0];
+                std::memmove(mapa, mapa + 1, (bloques - 1) * sizeof(RegistroLectura<T>*));
+                bloques--;
+                inicio = 0;
+            }
+        } else {
+            for (size_t i = m; i + 1 < n; ++i) en(i) = en(i + 1);
+        }
+        n--;
+        return true;
+    }
+
+    bool find_first(const T& value, T& found) const {
+        size_t g = inicio, fin = inicio + n;
+        while (g < fin) {
+            const RegistroLectura<T>* b = mapa[g / BLOQUE];
+            size_t hasta = (g / BLOQUE + 1) * BLOQUE;
+            if (hasta > fin) hasta = fin;
+            for (size_t j = g & (BLOQUE - 1), k = hasta - g; k; ++j, --k) {
+                if (b[j].dato == value) {
+                    found = b[j].dato;
+                    return true;
+                }
+            }
+            g = hasta;
+        }
+        return false;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < bloques; ++i) delete[] mapa[i];
+        delete[] mapa;
+        mapa = NULL;
+        capMapa = bloques = inicio = n = 0;
+    }
+
+    size_t bytes() const { return bloques * BLOQUE * sizeof(RegistroLectura<T>) + capMapa * sizeof(void*); }
+};
+
+/**
+ * @brief Backend de referencia: lista enlazada de trozos de CAPACIDAD
+ *        lecturas contiguas (lista "desenrollada").
+ */
+template <typename T>
+class ListaTrozos {
+public:
+    static const size_t CAPACIDAD = 64;
+
+private:
+    struct Trozo {
+        RegistroLectura<T> r[CAPACIDAD];
+        size_t cuenta;
+        Trozo* siguiente;
+    };
+    Trozo* cabeza;
+    Trozo* cola;
+    size_t n;
+    size_t trozos;
+
+    void copiarDesde(const ListaTrozos& otra) {
+        for (const Trozo* t = otra.cabeza; t; t = t->siguiente) {
+            for (size_t i = 0; i < t->cuenta; ++i) push_back(t->r[i].dato, t->r[i].banderas, t->r[i].marcaMs);
+        }
+    }
+
+public:
+    ListaTrozos() : cabeza(NULL), cola(NULL), n(0), trozos(0) {}
+    ListaTrozos(const ListaTrozos& otra) : cabeza(NULL), cola(NULL), n(0), trozos(0) { copiarDesde(otra); }
+    ListaTrozos& operator=(const ListaTrozos& otra) {
+        if (this != &otra) {
+            clear();
+            copiarDesde(otra);
+        }
+        return *this;
+    }
+    ~ListaTrozos() { clear(); }
+
+    void push_back(const T& v, unsigned char banderas = 0, long long marcaMs = 0) {
+        if (!cola || cola->cuenta == CAPACIDAD) {
+            Trozo* t = new Trozo;
+            t->cuenta = 0;
+            t->siguiente = NULL;
+            if (cola) cola->siguiente = t;
+            else cabeza = t;
+            cola = t;
+            trozos++;
+        }
+        RegistroLectura<T>& r = cola->r[cola->cuenta++];
+        r.dato = v;
+        r.banderas = banderas;
+        r.marcaMs = marcaMs;
+        n++;
+    }
+
+    size_t size() const { return n; }
+
+    T sum() const {
+        T s = T(0);
+        for (const Trozo* t = cabeza; t; t = t->siguiente) {
+            for (size_t i = 0; i < t->cuenta; ++i) s += t->r[i].dato;
+        }
+        return s;
+    }
+
+    bool pop_min(T& outMin) {
+        if (!n) return false;
+        Trozo* previoMin = NULL;
+        Trozo* trozoMin = cabeza;
+        size_t m = 0;
+        Trozo* previo = NULL;
+        for (Trozo* t = cabeza; t; previo = t, t = t->siguiente) {
+            for (size_t i = 0; i < t->cuenta; ++i) {
+                if (t->r[i].dato < trozoMin->r[m].dato) {
+                    trozoMin = t;
+                    previoMin = previo;
+                    m = i;
+                }
+            }
         }
+        outMin = trozoMin->r[m].dato;
+        std::memmove(trozoMin->r + m, trozoMin->r + m + 1, (trozoMin->cuenta - m - 1) * sizeof(RegistroLectura<T>));
+        if (--trozoMin->cuenta == 0) {
+            if (previoMin) previoMin->siguiente = trozoMin->siguiente;
+            else cabeza = trozoMin->siguiente;
+            if (cola == trozoMin) cola = previoMin;
+            delete trozoMin;
+            trozos--;
+        }
+        n--;
+        return true;
     }
 
-    /**
-     * @brief Libera nodos y, en cascada, cada SensorBase* (virtual dtor).
-     */
-    void liberarTodo() {
-        if (!cabeza) return;
-        printf("\n--- Liberación de Memoria en Cascada ---\n");
-        Nodo* it = cabeza;
-        while (it) {
-            Nodo* nxt = it->siguiente;
-            printf("[Destructor General] Liberando Nodo: %s.\n", it->sensor->getNombre());
-            delete it->sensor;  // destructor virtual -> baja a derivadas
-            delete it;
-            it = nxt;
+    bool find_first(const T& value, T& found) const {
+        for (const Trozo* t = cabeza; t; t = t->siguiente) {
+            for (size_t i = 0; i < t->cuenta; ++i) {
+                if (t->r[i].dato == value) {
+                    found = t->r[i].dato;
+                    return true;
+                }
+            }
         }
-        cabeza = cola = NULL;
-        n = 0;
-        printf("Sistema cerrado. Memoria limpia.\n");
+        return false;
     }
 
-    void imprimirResumen() const {
-        printf("\n--- Sensores en la lista (%zu) ---\n", n);
-        Nodo* it = cabeza;
-        while (it) {
-            it->sensor->imprimirInfo();
-            it = it->siguiente;
+    void clear() {
+        while (cabeza) {
+            Trozo* sig = cabeza->siguiente;
+            delete cabeza;
+            cabeza = sig;
         }
+        cola = NULL;
+        n = trozos = 0;
     }
+
+    size_t bytes() const { return trozos * sizeof(Trozo); }
 };
 
-/* ============================================================
- *    Utilidades de “Serial” simulado (opcional)
- * ============================================================*/
+/// Tiempos de una fila de la matriz (ns por lectura; pop_min en ns por operación).
+struct FilaBancoBackend {
+    double push, sum, popMin, findFirst, copia, clear;
+    size_t bytes;
+};
 
 /**
- * @brief Parsea una línea con formato "ID,valor" y registra en el sensor si existe.
- * @param linea Ej: "T-001,45.3" o "P-105,85"
- * @param lista Referencia a la lista polimórfica
- * @return true si se pudo registrar, false en caso contrario.
+ * @brief Mide push_back, sum, pop_min, find_first, copia y clear de un
+ *        backend con `n` lecturas; repite hasta cubrir ~2M lecturas.
  */
-bool procesarLineaSerial(const char* linea, ListaGeneral& lista) {
-    if (!linea) return false;
-
-    // copias temporales (sin STL)
-    char id[64] = {0};
-    char valor[64] = {0};
-
-    const char* coma = std::strchr(linea, ',');
-    if (!coma) return false;
-
-    size_t lenId = (size_t)(coma - linea);
-    if (lenId >= sizeof(id)) lenId = sizeof(id) - 1;
-    std::memcpy(id, linea, lenId);
-    id[lenId] = '\0';
-
-    const char* pVal = coma + 1;
-    std::strncpy(valor, pVal, sizeof(valor) - 1);
-    // limpiar salto de línea
-    size_t lv = std::strlen(valor);
-    if (lv && (valor[lv-1] == '\n' || valor[lv-1] == '\r')) valor[lv-1] = '\0';
+template <typename L>
+FilaBancoBackend medirBackend(size_t n) {
+    const size_t POPS = 32;
+    size_t vueltas = 2000000 / n;
+    if (vueltas == 0) vueltas = 1;
+    FilaBancoBackend f;
+    std::memset(&f, 0, sizeof(f));
+    unsigned long long tPush = 0, tSum = 0, tPop = 0, tFind = 0, tCopia = 0, tClear = 0;
+    size_t pops = 0;
+    volatile float sumidero = 0.0f;
+    for (size_t v = 0; v < vueltas; ++v) {
+        unsigned long long x = 0x2545F4914F6CDD1DULL + v;
+        L* l = new L;
+        unsigned long long t0 = relojNs();
+        for (size_t i = 0; i < n; ++i) {
+            x = mezclar64(x);
+            l->push_back((float)(x % 100000) * 0.01f, 0, (long long)i);
+        }
+        unsigned long long t1 = relojNs();
+        sumidero = sumidero + l->sum();
+        unsigned long long t2 = relojNs();
+        float hallado = 0.0f;
+        if (l->find_first(-1.0f, hallado)) sumidero = sumidero + hallado; // ausente: recorre todo
+        unsigned long long t3 = relojNs();
+        L* copia = new L(*l);
+        unsigned long long t4 = relojNs();
+        copia->clear();
+        unsigned long long t5 = relojNs();
+        if (v == 0) f.bytes = l->bytes();
+        size_t p = n < POPS ? n : POPS;
+        float menor = 0.0f;
+        for (size_t i = 0; i < p; ++i) {
+            if (l->pop_min(menor)) sumidero = sumidero + menor;
+        }
+        unsigned long long t6 = relojNs();
+        delete copia;
+        delete l;
+        tPush += t1 - t0;
+        tSum += t2 - t1;
+        tFind += t3 - t2;
+        tCopia += t4 - t3;
+        tClear += t5 - t4;
+        tPop += t6 - t5;
+        pops += p;
+    }
+    double lecturas = (double)n * (double)vueltas;
+    f.push = tPush / lecturas;
+    f.sum = tSum / lecturas;
+    f.findFirst = tFind / lecturas;
+    f.copia = tCopia / lecturas;
+    f.clear = tClear / lecturas;
+    f.popMin = pops ? (double)tPop / (double)pops : 0.0;
+    return f;
+}
 
-    SensorBase* s = lista.buscarPorNombre(id);
-    if (!s) {
-        printf("[Serial] ID no encontrado: %s\n", id);
-        return false;
+/**
+ * @brief --bench-backends [max] [archivo.csv]: matriz de operaciones de
+ *        ListaSensor<float> contra los backends de referencia para tamaños
+ *        de 1000 hasta `max`. Con archivo, agrega una fila CSV por celda
+ *        (marca de tiempo incluida) para seguir la evolución entre corridas.
+ */
+int ejecutarBancoBackends(size_t maximo, const char* rutaCsv) {
+    static const char* nombres[4] = { "enlazada", "contigua", "deque", "trozos" };
+    bool previo = registroDetallado();
+    registroDetallado() = false; // pop_min de ListaSensor registra cada nodo
+    FILE* csv = NULL;
+    if (rutaCsv) {
+        csv = std::fopen(rutaCsv, "a");
+        if (!csv) {
+            printf("No se pudo abrir %s.\n", rutaCsv);
+            return 1;
+        }
+        if (std::ftell(csv) == 0)
+            std::fprintf(csv, "marca_ms,backend,lecturas,push_ns,sum_ns,pop_min_ns,find_first_ns,copia_ns,clear_ns,"
+                              "bytes_por_lectura\n");
     }
-    bool ok = s->registrarDesdeTexto(valor);
-    if (!ok) {
-        printf("[Serial] Valor inválido para %s: %s\n", id, valor);
+    long long marca = relojEpochMs();
+    printf("\n--- Backends de ListaSensor<float>: ns por lectura (pop_min: ns por operacion) ---\n");
+    for (size_t n = 1000; n <= maximo; n *= 10) {
+        printf("\n  %zu lecturas\n", n);
+        printf("  %-9s %8s %8s %12s %11s %8s %8s %9s\n", "Backend", "push", "sum", "pop_min", "find_first",
+               "copia", "clear", "B/lectura");
+        for (int b = 0; b < 4; ++b) {
+            FilaBancoBackend f = b == 0 ? medirBackend<ListaSensor<float> >(n)
+                               : b == 1 ? medirBackend<ListaContigua<float> >(n)
+                               : b == 2 ? medirBackend<ListaDeque<float> >(n)
+                                        : medirBackend<ListaTrozos<float> >(n);
+            double porLectura = (double)f.bytes / (double)n;
+            printf("  %-9s %8.2f %8.2f %12.0f %11.2f %8.2f %8.2f %9.1f\n", nombres[b], f.push, f.sum, f.popMin,
+                   f.findFirst, f.copia, f.clear, porLectura);
+            if (csv)
+                std::fprintf(csv, "%lld,%s,%zu,%.3f,%.3f,%.1f,%.3f,%.3f,%.3f,%.1f\n", marca, nombres[b], n, f.push,
+                             f.sum, f.popMin, f.findFirst, f.copia, f.clear, porLectura);
+        }
+        if (n > maximo / 10) break;
     }
-    return ok;
+    registroDetallado() = previo;
+    if (csv && std::fclose(csv) != 0) return 1;
+    if (csv) printf("\n  Filas agregadas a %s.\n", rutaCsv);
+    return 0;
 }
 
 /* ============================================================
  *                      Menú principal
  * ============================================================*/
 
+/**
+ * @brief Lee la opción del menú sin dejar de atender los temporizadores:
+ *        espera la entrada con poll() usando como timeout el próximo
+ *        vencimiento, de modo que un sensor silencioso se informa y los
+ *        turnos planificados corren aunque nadie escriba. stdin va sin
+ *        buffer para que poll() vea todo lo pendiente.
+ */
+bool leerOpcion(char* buffer, size_t n, ListaGeneral& gestion) {
+    gestion.sincronizarReplica(); // nada queda sin replicar mientras se espera
+    while (true) {
+        std::fflush(stdout);
+        pollfd pfd;
+        pfd.fd = STDIN_FILENO;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        int r = poll(&pfd, 1, gestion.msHastaProximoEvento());
+        if (r < 0 && errno != EINTR) break;
+        if (r > 0) break;
+        if (gestion.atenderTemporizadores()) printf("Opcion: ");
+    }
+    return std::fgets(buffer, (int)n, stdin) != NULL;
+}
+
 void menu() {
     printf("\n--- Sistema IoT de Monitoreo Polimórfico ---\n");
     printf("1) Crear Sensor de Temperatura (FLOAT)\n");
@@ -499,20 +9823,154 @@ void menu() {
     printf("4) Ejecutar Procesamiento Polimorfico\n");
     printf("5) Mostrar sensores\n");
     printf("6) Inyectar linea estilo Serial (ID,valor)\n");
+    printf("7) Configurar suavizado de un sensor\n");
+    printf("8) Configurar pronostico (Holt-Winters) de un sensor\n");
+    printf("9) Consultar pronostico de un sensor\n");
+    printf("10) Vigilar silencio de un sensor (latido)\n");
+    printf("11) Planificar procesamiento de un sensor\n");
+    printf("12) Ejecutar planificador N segundos y reportar\n");
+    printf("13) Presupuesto de memoria y reporte de desborde\n");
+    printf("14) Instantanea en segundo plano (fork)\n");
+    printf("15) Checkpoint incremental (configurar / ejecutar)\n");
+    printf("16) Publicar lecturas en memoria compartida\n");
+    printf("17) Reporte de replicacion\n");
+    printf("18) Exportar historiales (Arrow IPC)\n");
+    printf("19) Trazas de latencia por etapa\n");
+    printf("20) Comprimir historial de un sensor (banda muerta / puerta giratoria)\n");
+    printf("21) Almacenamiento cuantizado de una temperatura (float16 / 16 / 8 bits)\n");
+    printf("22) Top-K de sensores por metrica (crear / consultar)\n");
+    printf("23) Bocetos HLL / count-min (activar / consultar grupo)\n");
+    printf("24) Duplicados y huecos por numero de secuencia\n");
+    printf("25) Alinear dos sensores por tiempo (as-of / cercana / grilla)\n");
+    printf("26) Exportar flujo mezclado en orden de tiempo\n");
+    printf("27) Resumen visual de un historial (LTTB)\n");
     printf("0) Salir\n");
     printf("Opcion: ");
 }
 
-int main() {
+int main(int argc, char** argv) {
+    if (argc >= 3 && std::strcmp(argv[1], "--suscriptor") == 0) {
+        double segundos = argc >= 4 ? std::atof(argv[3]) : 10.0;
+        // Con un solo núcleo la espera activa le quita la CPU al publicador.
+        bool mostrar = true, dormir = sysconf(_SC_NPROCESSORS_ONLN) < 2;
+        for (int i = 4; i < argc; ++i) {
+            if (std::strcmp(argv[i], "dormir") == 0) dormir = true;
+            else if (std::strcmp(argv[i], "girar") == 0) dormir = false;
+            else mostrar = false; // "silencioso" u otra palabra, como antes
+        }
+        return ejecutarSuscriptor(argv[2], segundos > 0.0 ? segundos : 10.0, mostrar, dormir);
+    }
+
+    if (argc >= 2 && std::strcmp(argv[1], "--prueba-failover") == 0) {
+        long lecturas = argc >= 3 ? std::atol(argv[2]) : 0;
+        return ejecutarPruebaFailover(lecturas > 0 ? (size_t)lecturas : 2000);
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--bench-filtros") == 0) {
+        long sensores = std::atol(argv[2]);
+        long lecturas = argc >= 4 ? std::atol(argv[3]) : 0;
+        return ejecutarBancoFiltros(sensores > 0 ? (size_t)sensores : 10000,
+                                    lecturas > 0 ? (size_t)lecturas : 10000000);
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--bench-compresion") == 0) {
+        long total = std::atol(argv[2]);
+        double error = argc >= 4 ? std::atof(argv[3]) : 0.05;
+        return ejecutarBancoCompresion(total > 0 ? (size_t)total : 1000000, error > 0.0 ? error : 0.05);
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--bench-cuantizado") == 0) {
+        long total = std::atol(argv[2]);
+        return ejecutarBancoCuantizado(total > 0 ? (size_t)total : 1000000);
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--bench-topk") == 0) {
+        long sensores = std::atol(argv[2]);
+        long lecturas = argc >= 4 ? std::atol(argv[3]) : 0;
+        long k = argc >= 5 ? std::atol(argv[4]) : 10;
+        if (sensores <= 0) sensores = 1000000;
+        return ejecutarBancoTopK((size_t)sensores, lecturas > 0 ? (size_t)lecturas : (size_t)sensores * 4,
+                                 k > 0 ? (size_t)k : 10);
+    }
+
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-bocetos") == 0) {
+        long maximo = argc >= 3 ? std::atol(argv[2]) : 0;
+        return ejecutarBancoBocetos(maximo >= 10 ? (size_t)maximo : 1000000);
+    }
+
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-alineacion") == 0) {
+        long lecturas = argc >= 3 ? std::atol(argv[2]) : 0;
+        return ejecutarBancoAlineacion(lecturas > 0 ? (size_t)lecturas : 1000000);
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--bench-mezcla") == 0) {
+        long sensores = std::atol(argv[2]);
+        long lecturas = argc >= 4 ? std::atol(argv[3]) : 0;
+        long tramos = argc >= 5 ? std::atol(argv[4]) : 4;
+        if (sensores <= 0) sensores = 100000;
+        return ejecutarBancoMezcla((size_t)sensores, lecturas > 0 ? (size_t)lecturas : (size_t)sensores * 100,
+                                   tramos > 0 ? (size_t)tramos : 4);
+    }
+
+    if (argc >= 2 && std::strcmp(argv[1], "--bench-backends") == 0) {
+        long maximo = argc >= 3 ? std::atol(argv[2]) : 0;
+        return ejecutarBancoBackends(maximo >= 1000 ? (size_t)maximo : 1000000, argc >= 4 ? argv[3] : NULL);
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--bench-arena") == 0) {
+        long total = std::atol(argv[2]);
+        long sensores = argc >= 4 ? std::atol(argv[3]) : 1000;
+        return ejecutarBancoArena(total > 0 ? (size_t)total : 10000000, sensores > 0 ? (size_t)sensores : 1000,
+                                  ArenaNodos::MODO_HUGETLB);
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--bench-ingesta") == 0) {
+        long total = std::atol(argv[2]);
+        return ejecutarBancoIngesta(total > 0 ? (size_t)total : 100000, argc >= 4 ? std::atoi(argv[3]) : 0);
+    }
+
+    if (argc >= 3 && std::strcmp(argv[1], "--cluster") == 0) {
+        int n = std::atoi(argv[2]);
+        return ejecutarRouter(n > 0 ? (unsigned)n : 1);
+    }
+
     ListaGeneral gestion;
+    const char* archivoTrazas = NULL;
+
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], "--persistente") == 0) gestion.abrirPersistente(argv[++i]);
+        else if (std::strcmp(argv[i], "--restaurar") == 0) gestion.cargarInstantanea(argv[++i]);
+        else if (std::strcmp(argv[i], "--checkpoint") == 0) gestion.activarCheckpoints(argv[++i], 0);
+        else if (std::strcmp(argv[i], "--publicar") == 0) gestion.publicarEnMemoriaCompartida(argv[++i]);
+        else if (std::strcmp(argv[i], "--replicar") == 0) gestion.replicarEn(argv[++i]);
+        else if (std::strcmp(argv[i], "--trazas") == 0) {
+            archivoTrazas = argv[++i];
+            Trazador::global().activar(16);
+        }
+        else if (std::strcmp(argv[i], "--arena") == 0) {
+            const char* m = argv[++i];
+            ArenaNodos::Modo modo = std::strcmp(m, "hugetlb") == 0 ? ArenaNodos::MODO_HUGETLB
+                                  : std::strcmp(m, "thp") == 0     ? ArenaNodos::MODO_THP
+                                                                   : ArenaNodos::MODO_NORMAL;
+            if (!ArenaNodos::global().activar(modo)) printf("[Arena] No se pudo reservar; se usa el heap.\n");
+        }
+        else if (std::strcmp(argv[i], "--standby") == 0) gestion.seguirPrimario(argv[++i]);
+    }
 
     int opcion = -1;
     char buffer[128];
+    std::setvbuf(stdin, NULL, _IONBF, 0);
 
     while (true) {
         menu();
-        if (!std::fgets(buffer, sizeof(buffer), stdin)) break;
+        if (!leerOpcion(buffer, sizeof(buffer), gestion)) break;
         opcion = std::atoi(buffer);
+        gestion.revisarLatidos();
+        gestion.ejecutarPlanificados();
+        gestion.aplicarPresupuesto();
+        gestion.revisarInstantanea();
+        gestion.revisarCheckpoint();
+        gestion.revisarReplica();
 
         if (opcion == 0) {
             break;
@@ -525,6 +9983,7 @@ int main() {
             if (l && (id[l-1] == '\n' || id[l-1] == '\r')) id[l-1] = '\0';
             SensorBase* s = new SensorTemperatura(id);
             gestion.push_back(s);
+            gestion.sincronizarReplica();
             printf("Sensor '%s' (Temp) creado e insertado en la lista de gestion.\n", id);
         }
         else if (opcion == 2) {
@@ -535,6 +9994,7 @@ int main() {
             if (l && (id[l-1] == '\n' || id[l-1] == '\r')) id[l-1] = '\0';
             SensorBase* s = new SensorPresion(id);
             gestion.push_back(s);
+            gestion.sincronizarReplica();
             printf("Sensor '%s' (Presion) creado e insertado en la lista de gestion.\n", id);
         }
         else if (opcion == 3) {
@@ -556,6 +10016,7 @@ int main() {
             if (l && (val[l-1] == '\n' || val[l-1] == '\r')) val[l-1] = '\0';
 
             if (s->registrarDesdeTexto(val)) {
+                gestion.sincronizarReplica();
                 printf("Lectura registrada en %s.\n", s->getNombre());
             } else {
                 printf("Formato de lectura invalido para el tipo de sensor.\n");
@@ -571,14 +10032,392 @@ int main() {
             char linea[128];
             printf("Linea (ID,valor): ");
             if (!std::fgets(linea, sizeof(linea), stdin)) continue;
-            bool ok = procesarLineaSerial(linea, gestion);
+            // La llegada se marca con la línea ya leída: marcar antes del
+            // fgets mediría el tecleo. En este camino "Cola" sale ~0; la
+            // espera real en cola solo se ve por la ingesta serial/cluster.
+            unsigned long long llegada = Trazador::global().estaActivo() ? Trazador::ciclos() : 0;
+            bool ok = procesarLineaSerial(linea, gestion, llegada);
+            if (ok) gestion.sincronizarReplica();
             printf("Inyeccion %s.\n", ok ? "OK" : "fallida");
         }
+        else if (opcion == 7) {
+            char id[64], conf[64];
+            printf("ID del sensor: ");
+            if (!std::fgets(id, sizeof(id), stdin)) continue;
+            size_t l = std::strlen(id);
+            if (l && (id[l-1] == '\n' || id[l-1] == '\r')) id[l-1] = '\0';
+
+            SensorBase* s = gestion.buscarPorNombre(id);
+            if (!s) {
+                printf("No existe el sensor '%s'.\n", id);
+                continue;
+            }
+
+            printf("Filtro (0 ninguno | 1 alpha: EWMA | 2 q r: Kalman | 3 k: Mediana): ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            int tipo = -1;
+            double a = 0.0, b = 0.0;
+            int leidos = std::sscanf(conf, "%d %lf %lf", &tipo, &a, &b);
+            if (leidos < 1) {
+                printf("Configuracion invalida.\n");
+                continue;
+            }
+
+            FiltroSuavizado f;
+            if (tipo == 1)      f = FiltroSuavizado::crearEWMA(a);
+            else if (tipo == 2) f = FiltroSuavizado::crearKalman(a, b);
+            else if (tipo == 3) f = FiltroSuavizado::crearMediana((int)a);
+            else if (tipo != 0) {
+                printf("Tipo de filtro invalido.\n");
+                continue;
+            }
+            s->configurarFiltro(f);
+            printf("Suavizado de %s: %s.\n", s->getNombre(), f.nombreTipo());
+        }
+        else if (opcion == 8) {
+            char id[64], conf[64];
+            printf("ID del sensor: ");
+            if (!std::fgets(id, sizeof(id), stdin)) continue;
+            size_t l = std::strlen(id);
+            if (l && (id[l-1] == '\n' || id[l-1] == '\r')) id[l-1] = '\0';
+
+            SensorBase* s = gestion.buscarPorNombre(id);
+            if (!s) {
+                printf("No existe el sensor '%s'.\n", id);
+                continue;
+            }
+
+            printf("alpha beta gamma periodo (periodo 0 = sin estacion, alpha 0 = desactivar): ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            double a = 0.0, b = 0.0, g = 0.0;
+            int m = 0;
+            if (std::sscanf(conf, "%lf %lf %lf %d", &a, &b, &g, &m) < 1) {
+                printf("Configuracion invalida.\n");
+                continue;
+            }
+            if (a <= 0.0) {
+                s->deshabilitarPronostico();
+                printf("Pronostico de %s desactivado.\n", s->getNombre());
+            } else {
+                s->habilitarPronostico(a, b, g, m);
+                printf("Pronostico de %s habilitado.\n", s->getNombre());
+            }
+        }
+        else if (opcion == 9) {
+            char id[64], hor[64];
+            printf("ID del sensor: ");
+            if (!std::fgets(id, sizeof(id), stdin)) continue;
+            size_t l = std::strlen(id);
+            if (l && (id[l-1] == '\n' || id[l-1] == '\r')) id[l-1] = '\0';
+
+            SensorBase* s = gestion.buscarPorNombre(id);
+            if (!s) {
+                printf("No existe el sensor '%s'.\n", id);
+                continue;
+            }
+
+            printf("Horizonte (1-32): ");
+            if (!std::fgets(hor, sizeof(hor), stdin)) continue;
+            int k = std::atoi(hor);
+            if (k < 1) k = 1;
+            if (k > 32) k = 32;
+
+            double media[32], inf[32], sup[32];
+            if (!s->pronosticar(k, media, inf, sup)) {
+                printf("Sin pronostico para %s (no habilitado o sin lecturas).\n", s->getNombre());
+                continue;
+            }
+            for (int h = 0; h < k; ++h) {
+                printf("  t+%d: %.3f  [%.3f, %.3f]\n", h + 1, media[h], inf[h], sup[h]);
+            }
+        }
+        else if (opcion == 10) {
+            char id[64], plazo[64];
+            printf("ID del sensor: ");
+            if (!std::fgets(id, sizeof(id), stdin)) continue;
+            size_t l = std::strlen(id);
+            if (l && (id[l-1] == '\n' || id[l-1] == '\r')) id[l-1] = '\0';
+
+            SensorBase* s = gestion.buscarPorNombre(id);
+            if (!s) {
+                printf("No existe el sensor '%s'.\n", id);
+                continue;
+            }
+
+            printf("Plazo de silencio en ms (0 = dejar de vigilar): ");
+            if (!std::fgets(plazo, sizeof(plazo), stdin)) continue;
+            unsigned long long ms = std::strtoull(plazo, NULL, 10);
+            s->vigilarLatido(gestion.getMonitorLatidos(), ms);
+            if (ms) printf("Vigilando %s: alerta tras %llu ms sin lecturas.\n", s->getNombre(), ms);
+            else    printf("%s ya no se vigila.\n", s->getNombre());
+        }
+        else if (opcion == 11) {
+            char id[64], conf[64];
+            printf("ID del sensor: ");
+            if (!std::fgets(id, sizeof(id), stdin)) continue;
+            size_t l = std::strlen(id);
+            if (l && (id[l-1] == '\n' || id[l-1] == '\r')) id[l-1] = '\0';
+
+            SensorBase* s = gestion.buscarPorNombre(id);
+            if (!s) {
+                printf("No existe el sensor '%s'.\n", id);
+                continue;
+            }
+
+            printf("periodo_ms cada_N (0 0 = quitar de la planificacion): ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            unsigned long long periodo = 0;
+            unsigned long cadaN = 0;
+            if (std::sscanf(conf, "%llu %lu", &periodo, &cadaN) < 1) {
+                printf("Configuracion invalida.\n");
+                continue;
+            }
+            gestion.getPlanificador().planificar(s, periodo, (size_t)cadaN);
+            printf("Planificacion de %s: periodo %llu ms, cada %lu lecturas.\n",
+                   s->getNombre(), periodo, cadaN);
+        }
+        else if (opcion == 12) {
+            char seg[64];
+            printf("Segundos: ");
+            if (!std::fgets(seg, sizeof(seg), stdin)) continue;
+            double t = std::atof(seg);
+            if (t <= 0.0) t = 1.0;
+            gestion.ejecutarPlanificadorDurante(t);
+        }
+        else if (opcion == 13) {
+            char conf[64];
+            printf("Presupuesto en bytes (0 = sin limite, vacio = solo reporte): ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            unsigned long long bytes = 0;
+            if (std::sscanf(conf, "%llu", &bytes) == 1) {
+                gestion.configurarPresupuesto((size_t)bytes);
+            }
+            gestion.imprimirMemoria();
+        }
+        else if (opcion == 14) {
+            char ruta[200];
+            printf("Archivo destino: ");
+            if (!std::fgets(ruta, sizeof(ruta), stdin)) continue;
+            size_t l = std::strlen(ruta);
+            if (l && (ruta[l-1] == '\n' || ruta[l-1] == '\r')) ruta[l-1] = '\0';
+            if (!ruta[0]) continue;
+            gestion.instantaneaEnSegundoPlano(ruta);
+        }
+        else if (opcion == 15) {
+            char conf[220];
+            printf("Ruta y periodo_ms para activar (vacio = checkpoint ahora): ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            char ruta[200];
+            unsigned long long periodo = 0;
+            if (std::sscanf(conf, "%199s %llu", ruta, &periodo) >= 1) {
+                gestion.activarCheckpoints(ruta, periodo);
+            } else {
+                gestion.checkpoint();
+            }
+            gestion.imprimirCheckpoints();
+        }
+        else if (opcion == 16) {
+            char nombre[64];
+            printf("Nombre del segmento (p.ej. /iot_lecturas): ");
+            if (!std::fgets(nombre, sizeof(nombre), stdin)) continue;
+            size_t l = std::strlen(nombre);
+            if (l && (nombre[l-1] == '\n' || nombre[l-1] == '\r')) nombre[l-1] = '\0';
+            if (nombre[0] != '/') {
+                printf("El nombre debe empezar con '/'.\n");
+                continue;
+            }
+            gestion.publicarEnMemoriaCompartida(nombre);
+        }
+        else if (opcion == 17) {
+            gestion.imprimirReplica();
+        }
+        else if (opcion == 18) {
+            char ruta[256];
+            printf("Archivo destino (.arrow): ");
+            if (!std::fgets(ruta, sizeof(ruta), stdin)) continue;
+            size_t l = std::strlen(ruta);
+            if (l && (ruta[l-1] == '\n' || ruta[l-1] == '\r')) ruta[l-1] = '\0';
+            gestion.exportarArrow(ruta);
+        }
+        else if (opcion == 20) {
+            char id[64], conf[64];
+            printf("ID del sensor: ");
+            if (!std::fgets(id, sizeof(id), stdin)) continue;
+            size_t l = std::strlen(id);
+            if (l && (id[l-1] == '\n' || id[l-1] == '\r')) id[l-1] = '\0';
+
+            SensorBase* s = gestion.buscarPorNombre(id);
+            if (!s) {
+                printf("No existe el sensor '%s'.\n", id);
+                continue;
+            }
+
+            printf("Compresion (0 ninguna | 1 E: banda muerta | 2 E: puerta giratoria): ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            int tipo = -1;
+            double e = 0.0;
+            if (std::sscanf(conf, "%d %lf", &tipo, &e) < 1 || (tipo != 0 && e <= 0.0)) {
+                printf("Configuracion invalida.\n");
+                continue;
+            }
+
+            if (s->tipoSensor() == TIPO_TEMPERATURA && static_cast<SensorTemperatura*>(s)->estaCuantizado()) {
+                printf("El historial de %s esta cuantizado; desactivelo primero (opcion 21).\n", s->getNombre());
+                continue;
+            }
+            bool entero = s->tipoSensor() == TIPO_PRESION;
+            CompresorHistorial c;
+            if (tipo == 1)      c = CompresorHistorial::crearBandaMuerta(e, entero);
+            else if (tipo == 2) c = CompresorHistorial::crearPuertaGiratoria(e, entero);
+            else if (tipo != 0) {
+                printf("Tipo de compresion invalido.\n");
+                continue;
+            }
+            s->configurarCompresion(c);
+            printf("Compresion de %s: %s.\n", s->getNombre(), c.nombreTipo());
+        }
+        else if (opcion == 21) {
+            char id[64], conf[64];
+            printf("ID del sensor de temperatura: ");
+            if (!std::fgets(id, sizeof(id), stdin)) continue;
+            size_t l = std::strlen(id);
+            if (l && (id[l-1] == '\n' || id[l-1] == '\r')) id[l-1] = '\0';
+
+            SensorBase* s = gestion.buscarPorNombre(id);
+            if (!s || s->tipoSensor() != TIPO_TEMPERATURA) {
+                printf("No existe el sensor de temperatura '%s'.\n", id);
+                continue;
+            }
+
+            printf("Almacenamiento (0 float completo | 1 float16 | 2 16 bits escalado | 3 8 bits escalado): ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            int modo = -1;
+            if (std::sscanf(conf, "%d", &modo) != 1 || modo < 0 || modo > 3) {
+                printf("Modo invalido.\n");
+                continue;
+            }
+            SensorTemperatura* t = static_cast<SensorTemperatura*>(s);
+            if (!t->configurarCuantizacion(modo)) {
+                printf("%s se persiste o comprime; no admite cuantizacion.\n", s->getNombre());
+                continue;
+            }
+            printf("Almacenamiento de %s actualizado.\n", s->getNombre());
+            t->imprimirInfo();
+        }
+        else if (opcion == 22) {
+            IndiceRanking& idx = gestion.getRankings();
+            char conf[64];
+            printf("Nuevo ranking: metrica (1 ultimo | 2 promedio | 3 maximo) tipo (0 todos | 1 temp | 2 presion) K\n");
+            printf("  (linea vacia = consultar los existentes): ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            int metrica = 0, tipo = 0, k = 0;
+            if (std::sscanf(conf, "%d %d %d", &metrica, &tipo, &k) == 3) {
+                if (metrica < 1 || metrica > 3 || tipo < 0 || tipo > 2 || k <= 0) {
+                    printf("Configuracion invalida.\n");
+                    continue;
+                }
+                if (idx.crear((RankingSensores::Metrica)metrica, tipo, (size_t)k) < 0) {
+                    printf("Limite de %d rankings alcanzado.\n", IndiceRanking::MAX_RANKINGS);
+                    continue;
+                }
+            }
+            for (int i = 0; i < idx.getCuantos(); ++i) idx.imprimir(i);
+            if (idx.getCuantos() == 0) printf("No hay rankings configurados.\n");
+        }
+        else if (opcion == 23) {
+            char grupo[64], conf[64];
+            printf("Prefijo del grupo de sensores (linea vacia = todos): ");
+            if (!std::fgets(grupo, sizeof(grupo), stdin)) continue;
+            size_t l = std::strlen(grupo);
+            if (l && (grupo[l-1] == '\n' || grupo[l-1] == '\r')) grupo[l-1] = '\0';
+
+            printf("Accion (1 activar | 0 desactivar | 2 [valor]: consultar): ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            int accion = -1;
+            double valor = 0.0;
+            int leidos = std::sscanf(conf, "%d %lf", &accion, &valor);
+            if (leidos < 1 || accion < 0 || accion > 2) {
+                printf("Accion invalida.\n");
+                continue;
+            }
+            if (accion != 2) {
+                printf("Bocetos %s en %zu sensor(es).\n", accion ? "activados" : "desactivados",
+                       gestion.configurarBocetos(grupo, accion == 1));
+                continue;
+            }
+            BocetoSensor* total = new BocetoSensor(); // 6 KB: fuera de la pila
+            size_t c = gestion.combinarBocetos(grupo, *total);
+            if (c == 0) {
+                printf("Ningun sensor del grupo tiene bocetos.\n");
+            } else {
+                printf("Grupo '%s' (%zu sensores): %llu lecturas, ~%.0f valores distintos.\n", grupo, c,
+                       total->total, total->distintos());
+                if (leidos == 2)
+                    printf("Valor %g: a lo sumo %llu apariciones (exceso <= %.0f con 98%%).\n", valor,
+                           total->frecuencia(valor), total->errorFrecuencia());
+            }
+            delete total;
+        }
+        else if (opcion == 25) {
+            char conf[256], idA[64], idB[64], ruta[160];
+            printf("ID_A ID_B modo (1 as-of | 2 cercana | 3 grilla) tolerancia/paso_ms [archivo.csv]: ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            int modo = 0;
+            long long param = -1;
+            ruta[0] = '\0';
+            if (std::sscanf(conf, "%63s %63s %d %lld %159s", idA, idB, &modo, &param, ruta) < 4 ||
+                modo < 1 || modo > 3) {
+                printf("Configuracion invalida.\n");
+                continue;
+            }
+            long long pares = gestion.alinear(idA, idB, modo, param, ruta[0] ? ruta : NULL);
+            if (pares < 0) printf("No se pudo alinear (IDs, paso o archivo invalidos).\n");
+            else if (ruta[0]) printf("Pares alineados escritos en %s.\n", ruta);
+        }
+        else if (opcion == 26) {
+            char conf[256], ruta[200];
+            int tramos = 1;
+            printf("Archivo destino y tramos en paralelo [1]: ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            if (std::sscanf(conf, "%199s %d", ruta, &tramos) < 1 || tramos < 1 || tramos > 64) {
+                printf("Configuracion invalida.\n");
+                continue;
+            }
+            if (gestion.exportarMezcla(ruta, (size_t)tramos) < 0) printf("No se pudo exportar la mezcla.\n");
+        }
+        else if (opcion == 27) {
+            char conf[256], id[64], ruta[160];
+            long puntos = 0;
+            ruta[0] = '\0';
+            printf("ID puntos [archivo.csv]: ");
+            if (!std::fgets(conf, sizeof(conf), stdin)) continue;
+            if (std::sscanf(conf, "%63s %ld %159s", id, &puntos, ruta) < 2 || puntos < 1 || puntos > 1000000) {
+                printf("Configuracion invalida.\n");
+                continue;
+            }
+            if (gestion.resumirSensor(id, (size_t)puntos, ruta[0] ? ruta : NULL) < 0)
+                printf("No se pudo resumir (ID o archivo invalidos).\n");
+            else if (ruta[0]) printf("Resumen escrito en %s.\n", ruta);
+        }
+        else if (opcion == 24) {
+            gestion.imprimirSecuencias();
+        }
+        else if (opcion == 19) {
+            Trazador::global().imprimir();
+            if (archivoTrazas && Trazador::global().exportarChrome(archivoTrazas))
+                printf("[Trazas] Exportadas en %s.\n", archivoTrazas);
+        }
         else {
             printf("Opcion invalida.\n");
         }
     }
 
+    gestion.revisarInstantanea(true);
+    gestion.cerrarTramosComprimidos(); // antes de cerrar réplica y archivo mapeado
+    gestion.cerrarReplica();
+    if (archivoTrazas && !Trazador::global().exportarChrome(archivoTrazas))
+        printf("[Trazas] No se pudo escribir %s.\n", archivoTrazas);
+
     // Al salir, ~ListaGeneral libera en cascada.
     return 0;
 }